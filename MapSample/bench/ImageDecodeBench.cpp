@@ -0,0 +1,745 @@
+﻿//----------------------------------------------------------
+//
+// 画像デコードのベンチマーク
+//
+// データフォルダのbitmap,png,jpegの全ファイルと、ビット深度毎の合成画像(4096x4096)を
+// ImageDecorder::decodeでデコードし、1回あたりの時間、MP/s、MB/s(入力データ)、
+// 1デコードあたりのnew回数(libpng,libjpeg内部のmallocは含まない)、ピークRSSを表示する。
+// デコード結果のチェックサムをゴールデンファイルと比較し、不一致があれば1を返す。
+// 同梱のImageDecodeBench.goldenはbitmap,pngと合成画像(bmp,png)の分のみ。jpegの結果はlibjpegのビルドで
+// 変わるため含めておらず、初回実行時にNEWとして追加される。
+// データフォルダのpng,jpegはFileStreamでも同期、非同期、io_uringの各読み込みでprobeとデコードを行い、
+// メモリ上のデータと結果が一致するか確認する(不一致があれば1を返す)。
+//
+// ビルド例(Visual Studioの開発者コマンドプロンプト、x64):
+//   cl /O2 /EHsc /I..\source\framework /I..\build\windows\library\libpng\Include /I..\build\windows\library\libjpeg\Include
+//      /I..\build\windows\library\zlib\Include ImageDecodeBench.cpp ..\source\framework\Cpu.cpp ..\source\framework\ThreadPool.cpp
+//      ..\source\framework\io\File.cpp ..\source\framework\io\FileStream.cpp ..\source\framework\io\AsyncFileReader.cpp
+//      ..\source\framework\image\Image.cpp ..\source\framework\image\PixelConv.cpp
+//      ..\source\framework\image\PalleteExpander.cpp ..\source\framework\image\ImageBufferPool.cpp ..\source\framework\image\DecodeCache.cpp
+//      /link /LIBPATH:..\build\windows\library\libpng\Lib\x64 /LIBPATH:..\build\windows\library\libjpeg\Lib\x64
+//      /LIBPATH:..\build\windows\library\zlib\Lib\x64 libpng16.lib zlib.lib jpeg-static.lib
+// 使い方: ImageDecodeBench [データフォルダ(既定は../../data)] [--golden ファイル] [--update] [--quick]
+//   --golden  ゴールデンファイル(既定はImageDecodeBench.golden)
+//   --update  比較せずにゴールデンファイルを作成し直す(最適化前の基準を取る場合に使用)
+//   --quick   合成画像を1024x1024にして短時間で確認する
+//
+//----------------------------------------------------------
+
+#include "image/Image.hpp"
+#include "image/PixelConv.hpp"
+#include "io/AsyncFileReader.hpp"
+#include "io/FileStream.hpp"
+#include <png.h>
+#include <jpeglib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+	//new回数(全スレッド合計)
+	static std::atomic<std::int64_t> gNewCount(0);
+
+	//1ケースあたりの最小計測時間[秒]
+	static const double MIN_TIME = 0.5;
+	//1ケースあたりの最小、最大計測回数
+	static const std::int32_t MIN_ITERATION = 3;
+	static const std::int32_t MAX_ITERATION = 1000;
+	//合成画像の幅高さ
+	static const std::int32_t SYNTH_SIZE = 4096;
+	static const std::int32_t SYNTH_SIZE_QUICK = 1024;
+	//入力ストリームの確認で1回に読み込むバイト数(ヘッダがチャンク境界をまたぐ場合も確認するため小さくする)
+	static const size_t STREAM_CHUNK_SIZE = 4 * 1024;
+
+	//ベンチマークケース
+	struct BenchCase {
+		std::string					name_;		//名前(ゴールデンファイルのキー)
+		fw::EN_ImageFormat			format_;	//画像フォーマット
+		std::vector<std::uint8_t>	data_;		//画像データ
+		std::string					filePath_;	//画像ファイルのパス(合成画像は空)
+	};
+
+	//計測結果
+	struct BenchResult {
+		std::int32_t	rc_;			//デコード結果
+		std::int32_t	width_;			//幅
+		std::int32_t	height_;		//高さ
+		std::uint64_t	checksum_;		//デコード結果のチェックサム
+		std::int32_t	iteration_;		//計測回数
+		double			msec_;			//1回あたりの時間(中央値)[ms]
+		double			newPerDecode_;	//1デコードあたりのnew回数
+	};
+
+	//ピークRSS[byte]を取得
+	static std::uint64_t getPeakRss()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS pmc = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+			return std::uint64_t(pmc.PeakWorkingSetSize);
+		}
+		return 0;
+#else
+		struct rusage usage = {};
+		if (getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+#if defined(__APPLE__)
+		return std::uint64_t(usage.ru_maxrss);
+#else
+		//Linuxはキロバイト単位
+		return std::uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+	}
+
+	//フォルダ内のファイル名を取得(名前順)
+	static std::vector<std::string> listFiles(const std::string& dirPath)
+	{
+		std::vector<std::string> names;
+#if defined(_WIN32)
+		WIN32_FIND_DATAA find = {};
+		const HANDLE handle = FindFirstFileA((dirPath + "/*").c_str(), &find);
+		if (handle != INVALID_HANDLE_VALUE) {
+			do {
+				if ((find.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+					names.push_back(find.cFileName);
+				}
+			} while (FindNextFileA(handle, &find));
+			FindClose(handle);
+		}
+#else
+		DIR* const dir = opendir(dirPath.c_str());
+		if (dir != nullptr) {
+			for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+				if (entry->d_name[0] != '.') {
+					names.push_back(entry->d_name);
+				}
+			}
+			closedir(dir);
+		}
+#endif
+		std::sort(names.begin(), names.end());
+		return names;
+	}
+
+	//ファイル全体を読み込み
+	static bool readFile(const std::string& filePath, std::vector<std::uint8_t>* const data)
+	{
+		FILE* const fp = std::fopen(filePath.c_str(), "rb");
+		if (fp == nullptr) {
+			return false;
+		}
+		std::uint8_t buf[64 * 1024];
+		data->clear();
+		for (;;) {
+			const size_t n = std::fread(buf, 1, sizeof(buf), fp);
+			if (n == 0) {
+				break;
+			}
+			data->insert(data->end(), buf, buf + n);
+		}
+		std::fclose(fp);
+		return true;
+	}
+
+	//拡張子から画像フォーマットを判定(対象外はfalse)
+	static bool getFormat(const std::string& name, fw::EN_ImageFormat* const format)
+	{
+		const size_t dot = name.rfind('.');
+		if (dot == std::string::npos) {
+			return false;
+		}
+		std::string ext = name.substr(dot + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](const char c) { return char(std::tolower(static_cast<unsigned char>(c))); });
+		if (ext == "bmp") {
+			*format = fw::D_IMAGEFORMAT_BMP;
+		}
+		else if (ext == "png") {
+			*format = fw::D_IMAGEFORMAT_PNG;
+		}
+		else if ((ext == "jpg") || (ext == "jpeg")) {
+			*format = fw::D_IMAGEFORMAT_JPEG;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+
+	//----------------------------------------------------------
+	//
+	// 合成画像の作成
+	//
+	// 地図画像に近いよう、なだらかなグラデーションに平坦な領域とノイズを混ぜる。
+	//
+	//----------------------------------------------------------
+
+	//座標からノイズ値を作成
+	static std::uint32_t hashXY(const std::int32_t x, const std::int32_t y)
+	{
+		std::uint32_t h = (std::uint32_t(x) * 73856093u) ^ (std::uint32_t(y) * 19349663u);
+		h ^= h >> 13;
+		h *= 0x5BD1E995u;
+		return h ^ (h >> 15);
+	}
+
+	//合成画像の画素値(c:0=R,1=G,2=B,3=A)
+	static std::uint8_t synthPixel(const std::int32_t x, const std::int32_t y, const std::int32_t c, const std::int32_t size)
+	{
+		//64x64のブロック毎に平坦な領域とグラデーションを切り替える
+		const bool isFlat = (((x >> 6) + (y >> 6)) % 3) == 0;
+		if (c == 3) {
+			return isFlat ? 255 : std::uint8_t(128 + (hashXY(x >> 2, y >> 2) & 127));
+		}
+		if (isFlat) {
+			return std::uint8_t(60 + (c * 70));
+		}
+		const std::int32_t grad = ((x * 255) / size) + ((y * (c + 1) * 255) / size / 3);
+		return std::uint8_t(grad + (hashXY(x, y + c) & 15));
+	}
+
+	//合成画像のパレットインデックス
+	static std::int32_t synthIndex(const std::int32_t x, const std::int32_t y, const std::int32_t bitCount)
+	{
+		const std::int32_t num = 1 << bitCount;
+		return (((x >> 4) + (y >> 4) * 3) + std::int32_t(hashXY(x >> 3, y >> 3) & 1)) % num;
+	}
+
+	//リトルエンディアンで書き込み
+	static void put16(std::uint8_t* const p, const std::uint32_t v)
+	{
+		p[0] = std::uint8_t(v);
+		p[1] = std::uint8_t(v >> 8);
+	}
+	static void put32(std::uint8_t* const p, const std::uint32_t v)
+	{
+		put16(p, v);
+		put16(p + 2, v >> 16);
+	}
+
+	//Windows形式のBitmapを作成(1,4,8bitはパレット、16bitはRGB555)
+	static std::vector<std::uint8_t> makeBitmap(const std::int32_t size, const std::int32_t bitCount)
+	{
+		const std::int32_t palleteNum = (bitCount <= 8) ? (1 << bitCount) : 0;
+		const std::int32_t rowByte = (((size * bitCount) + 31) / 32) * 4;
+		const std::int32_t offset = 14 + 40 + (palleteNum * 4);
+		std::vector<std::uint8_t> data(size_t(offset) + (size_t(rowByte) * size), 0);
+		std::uint8_t* const p = data.data();
+		p[0] = 'B';
+		p[1] = 'M';
+		put32(p + 2, std::uint32_t(data.size()));
+		put32(p + 10, std::uint32_t(offset));
+		put32(p + 14, 40);
+		put32(p + 18, std::uint32_t(size));
+		put32(p + 22, std::uint32_t(size));
+		put16(p + 26, 1);
+		put16(p + 28, std::uint32_t(bitCount));
+		put32(p + 34, std::uint32_t(rowByte * size));
+		put32(p + 46, std::uint32_t(palleteNum));
+		for (std::int32_t i = 0; i < palleteNum; i++) {
+			//B,G,R,予約
+			p[54 + (i * 4) + 0] = std::uint8_t(i * 37);
+			p[54 + (i * 4) + 1] = std::uint8_t(255 - (i * 11));
+			p[54 + (i * 4) + 2] = std::uint8_t(i * 5);
+		}
+
+		for (std::int32_t y = 0; y < size; y++) {
+			//下の行から格納
+			std::uint8_t* const row = p + offset + (size_t(size - 1 - y) * rowByte);
+			for (std::int32_t x = 0; x < size; x++) {
+				const std::uint8_t r = synthPixel(x, y, 0, size);
+				const std::uint8_t g = synthPixel(x, y, 1, size);
+				const std::uint8_t b = synthPixel(x, y, 2, size);
+				switch (bitCount) {
+				case 1:
+				case 4:
+				case 8:
+				{
+					const std::int32_t bit = x * bitCount;
+					row[bit / 8] |= std::uint8_t(synthIndex(x, y, bitCount) << (8 - bitCount - (bit % 8)));
+					break;
+				}
+				case 16:
+					put16(row + (x * 2), (std::uint32_t(r >> 3) << 10) | (std::uint32_t(g >> 3) << 5) | (b >> 3));
+					break;
+				case 24:
+					row[(x * 3) + 0] = b;
+					row[(x * 3) + 1] = g;
+					row[(x * 3) + 2] = r;
+					break;
+				default:
+					row[(x * 4) + 0] = b;
+					row[(x * 4) + 1] = g;
+					row[(x * 4) + 2] = r;
+					row[(x * 4) + 3] = synthPixel(x, y, 3, size);
+					break;
+				}
+			}
+		}
+		return data;
+	}
+
+	//PNG書き込みコールバック
+	static void callbackWritePng(png_structp pngStr, png_bytep data, png_size_t length)
+	{
+		std::vector<std::uint8_t>* const out = static_cast<std::vector<std::uint8_t>*>(png_get_io_ptr(pngStr));
+		out->insert(out->end(), data, data + length);
+	}
+	static void callbackFlushPng(png_structp pngStr)
+	{
+		(void)pngStr;
+	}
+
+	//PNGを作成
+	static std::vector<std::uint8_t> makePng(const std::int32_t size, const std::int32_t colorType, const std::int32_t bitDepth)
+	{
+		std::vector<std::uint8_t> data;
+		png_structp pngStr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+		png_infop pngInfo = png_create_info_struct(pngStr);
+		if (setjmp(png_jmpbuf(pngStr))) {
+			png_destroy_write_struct(&pngStr, &pngInfo);
+			return std::vector<std::uint8_t>();
+		}
+		png_set_write_fn(pngStr, &data, callbackWritePng, callbackFlushPng);
+		png_set_IHDR(pngStr, pngInfo, png_uint_32(size), png_uint_32(size), bitDepth, colorType, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+		std::int32_t channelNum = 1;
+		if (colorType == PNG_COLOR_TYPE_PALETTE) {
+			png_color pallete[256];
+			png_byte alpha[256];
+			for (std::int32_t i = 0; i < 256; i++) {
+				pallete[i].red = png_byte(i * 5);
+				pallete[i].green = png_byte(255 - (i * 11));
+				pallete[i].blue = png_byte(i * 37);
+				alpha[i] = png_byte((i % 4) == 0 ? 128 : 255);
+			}
+			png_set_PLTE(pngStr, pngInfo, pallete, 1 << bitDepth);
+			png_set_tRNS(pngStr, pngInfo, alpha, 1 << bitDepth, nullptr);
+		}
+		else if (colorType == PNG_COLOR_TYPE_RGB) {
+			channelNum = 3;
+		}
+		else if (colorType == PNG_COLOR_TYPE_RGB_ALPHA) {
+			channelNum = 4;
+		}
+		png_write_info(pngStr, pngInfo);
+
+		const std::int32_t byteDepth = (bitDepth == 16) ? 2 : 1;
+		std::vector<png_byte> row(size_t(size) * channelNum * byteDepth);
+		for (std::int32_t y = 0; y < size; y++) {
+			std::fill(row.begin(), row.end(), png_byte(0));
+			for (std::int32_t x = 0; x < size; x++) {
+				if (colorType == PNG_COLOR_TYPE_PALETTE) {
+					const std::int32_t bit = x * bitDepth;
+					row[bit / 8] |= png_byte(synthIndex(x, y, bitDepth) << (8 - bitDepth - (bit % 8)));
+					continue;
+				}
+				for (std::int32_t c = 0; c < channelNum; c++) {
+					//グレーは緑成分、アルファは4番目
+					const std::uint8_t v = synthPixel(x, y, (channelNum == 1) ? 1 : c, size);
+					png_byte* const wp = &row[(size_t(x) * channelNum + c) * byteDepth];
+					wp[0] = v;
+					if (byteDepth == 2) {
+						wp[1] = png_byte(hashXY(x, y) & 0xFF);
+					}
+				}
+			}
+			png_write_row(pngStr, row.data());
+		}
+		png_write_end(pngStr, pngInfo);
+		png_destroy_write_struct(&pngStr, &pngInfo);
+		return data;
+	}
+
+	//JPEGを作成(品質90)
+	static std::vector<std::uint8_t> makeJpeg(const std::int32_t size, const bool isGray)
+	{
+		jpeg_compress_struct cinfo;
+		jpeg_error_mgr jerr;
+		cinfo.err = jpeg_std_error(&jerr);
+		jpeg_create_compress(&cinfo);
+		unsigned char* out = nullptr;
+		unsigned long outSize = 0;
+		jpeg_mem_dest(&cinfo, &out, &outSize);
+		cinfo.image_width = JDIMENSION(size);
+		cinfo.image_height = JDIMENSION(size);
+		cinfo.input_components = isGray ? 1 : 3;
+		cinfo.in_color_space = isGray ? JCS_GRAYSCALE : JCS_RGB;
+		jpeg_set_defaults(&cinfo);
+		jpeg_set_quality(&cinfo, 90, TRUE);
+		jpeg_start_compress(&cinfo, TRUE);
+
+		std::vector<JSAMPLE> row(size_t(size) * cinfo.input_components);
+		while (cinfo.next_scanline < cinfo.image_height) {
+			const std::int32_t y = std::int32_t(cinfo.next_scanline);
+			for (std::int32_t x = 0; x < size; x++) {
+				for (std::int32_t c = 0; c < cinfo.input_components; c++) {
+					row[size_t(x) * cinfo.input_components + c] = synthPixel(x, y, isGray ? 1 : c, size);
+				}
+			}
+			JSAMPROW rows[1] = { row.data() };
+			(void)jpeg_write_scanlines(&cinfo, rows, 1);
+		}
+		jpeg_finish_compress(&cinfo);
+		jpeg_destroy_compress(&cinfo);
+
+		std::vector<std::uint8_t> data(out, out + outSize);
+		std::free(out);
+		return data;
+	}
+
+	//合成画像のケースを追加
+	static void addSynthCases(const std::int32_t size, std::vector<BenchCase>* const cases)
+	{
+		const std::string suffix = "_" + std::to_string(size);
+		static const std::int32_t BMP_BITCOUNT[] = { 1, 4, 8, 16, 24, 32 };
+		for (const std::int32_t bitCount : BMP_BITCOUNT) {
+			cases->push_back({ "synth/bmp_" + std::to_string(bitCount) + suffix, fw::D_IMAGEFORMAT_BMP, makeBitmap(size, bitCount), std::string() });
+		}
+
+		//名前,カラータイプ,ビット深度
+		static const struct {
+			const char*		name_;
+			std::int32_t	colorType_;
+			std::int32_t	bitDepth_;
+		} PNG_TYPE[] = {
+			{ "pal4", PNG_COLOR_TYPE_PALETTE, 4 },
+			{ "pal8", PNG_COLOR_TYPE_PALETTE, 8 },
+			{ "gray8", PNG_COLOR_TYPE_GRAY, 8 },
+			{ "rgb24", PNG_COLOR_TYPE_RGB, 8 },
+			{ "rgba32", PNG_COLOR_TYPE_RGB_ALPHA, 8 },
+			{ "rgba64", PNG_COLOR_TYPE_RGB_ALPHA, 16 },
+		};
+		for (const auto& type : PNG_TYPE) {
+			cases->push_back({ std::string("synth/png_") + type.name_ + suffix, fw::D_IMAGEFORMAT_PNG, makePng(size, type.colorType_, type.bitDepth_), std::string() });
+		}
+
+		cases->push_back({ "synth/jpeg_gray8" + suffix, fw::D_IMAGEFORMAT_JPEG, makeJpeg(size, true), std::string() });
+		cases->push_back({ "synth/jpeg_rgb24" + suffix, fw::D_IMAGEFORMAT_JPEG, makeJpeg(size, false), std::string() });
+	}
+
+
+	//----------------------------------------------------------
+	//
+	// 計測
+	//
+	//----------------------------------------------------------
+
+	//デコード結果のチェックサム(FNV-1a、行の余白は含まない)
+	static std::uint64_t calcChecksum(fw::ImageDecorder& decorder)
+	{
+		std::int32_t width = 0;
+		std::int32_t height = 0;
+		const std::uint8_t* const data = decorder.getDecodeData(nullptr, &width, &height);
+		const std::int32_t rowByte = width * fw::PixelConv::getBytePerPixel(decorder.getDecodeFormat());
+		std::uint64_t h = 14695981039346656037ULL;
+		for (std::int32_t y = 0; y < height; y++) {
+			const std::uint8_t* const row = data + (size_t(y) * decorder.getStride());
+			for (std::int32_t x = 0; x < rowByte; x++) {
+				h = (h ^ row[x]) * 1099511628211ULL;
+			}
+		}
+		return h;
+	}
+
+	//1ケースを計測
+	static BenchResult measure(const BenchCase& benchCase)
+	{
+		fw::Image image = {};
+		image.id_ = 0;
+		image.type_ = fw::D_IMAGETYPE_LOCAL;
+		image.format_ = benchCase.format_;
+		image.body_.data_ = const_cast<std::uint8_t*>(benchCase.data_.data());
+		image.body_.dataSize_ = std::int32_t(benchCase.data_.size());
+
+		//1回目で結果を確認(バッファプールの確保もここで済ませる)
+		BenchResult result = {};
+		{
+			fw::ImageDecorder decorder;
+			result.rc_ = decorder.decode(image);
+			(void)decorder.getDecodeData(nullptr, &result.width_, &result.height_);
+			result.checksum_ = calcChecksum(decorder);
+		}
+		if ((result.rc_ != fw::D_DECODERESULT_OK) || (result.width_ <= 0)) {
+			return result;
+		}
+
+		//最小計測時間を超えるまで繰り返す
+		std::vector<double> times;
+		const std::int64_t newCount = gNewCount.load();
+		const auto begin = std::chrono::steady_clock::now();
+		for (;;) {
+			const auto start = std::chrono::steady_clock::now();
+			{
+				fw::ImageDecorder decorder;
+				(void)decorder.decode(image);
+			}
+			const auto end = std::chrono::steady_clock::now();
+			times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+			const double total = std::chrono::duration<double>(end - begin).count();
+			const std::int32_t num = std::int32_t(times.size());
+			if (((total >= MIN_TIME) && (num >= MIN_ITERATION)) || (num >= MAX_ITERATION)) {
+				break;
+			}
+		}
+		result.iteration_ = std::int32_t(times.size());
+		result.newPerDecode_ = double(gNewCount.load() - newCount) / result.iteration_;
+		std::sort(times.begin(), times.end());
+		result.msec_ = times[times.size() / 2];
+		return result;
+	}
+
+	//入力ストリームでprobe,デコードし、メモリ上のデータの結果と一致するか確認
+	//readerがnullptrの場合は同期読み込み、msecにprobeとデコードの時間[ms]を返す
+	static bool checkStream(const BenchCase& benchCase, const BenchResult& expect, fw::AsyncFileReader* const reader, double* const msec)
+	{
+		fw::Image image = {};
+		image.id_ = 0;
+		image.type_ = fw::D_IMAGETYPE_LOCAL;
+		image.format_ = benchCase.format_;
+		image.body_.data_ = const_cast<std::uint8_t*>(benchCase.data_.data());
+		image.body_.dataSize_ = std::int32_t(benchCase.data_.size());
+		const fw::ImageInfo info = fw::ImageDecorder::probe(image);
+
+		fw::FileStream stream;
+		if (!stream.open(benchCase.filePath_, 0, 0, STREAM_CHUNK_SIZE, reader)) {
+			return false;
+		}
+		image.body_.data_ = nullptr;
+		image.body_.dataSize_ = 0;
+		image.body_.stream_ = &stream;
+
+		//probe後も範囲の先頭からデコードできること
+		const auto start = std::chrono::steady_clock::now();
+		const fw::ImageInfo streamInfo = fw::ImageDecorder::probe(image);
+		fw::ImageDecorder decorder;
+		const std::int32_t rc = decorder.decode(image);
+		*msec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if ((streamInfo.width_ != info.width_) || (streamInfo.height_ != info.height_) ||
+			(streamInfo.bitDepth_ != info.bitDepth_) || (streamInfo.hasAlpha_ != info.hasAlpha_)) {
+			return false;
+		}
+		return (rc == expect.rc_) && ((rc != fw::D_DECODERESULT_OK) || (calcChecksum(decorder) == expect.checksum_));
+	}
+
+	//ゴールデンファイルを読み込み(名前→チェックサム)
+	static std::map<std::string, std::uint64_t> loadGolden(const std::string& filePath)
+	{
+		std::map<std::string, std::uint64_t> golden;
+		FILE* const fp = std::fopen(filePath.c_str(), "r");
+		if (fp == nullptr) {
+			return golden;
+		}
+		char name[512];
+		unsigned long long checksum = 0;
+		while (std::fscanf(fp, "%511s %llx", name, &checksum) == 2) {
+			golden[name] = std::uint64_t(checksum);
+		}
+		std::fclose(fp);
+		return golden;
+	}
+
+	//ゴールデンファイルを書き込み
+	static bool saveGolden(const std::string& filePath, const std::map<std::string, std::uint64_t>& golden)
+	{
+		FILE* const fp = std::fopen(filePath.c_str(), "w");
+		if (fp == nullptr) {
+			return false;
+		}
+		for (auto itr = golden.cbegin(); itr != golden.cend(); itr++) {
+			std::fprintf(fp, "%s %016llx\n", itr->first.c_str(), static_cast<unsigned long long>(itr->second));
+		}
+		std::fclose(fp);
+		return true;
+	}
+}
+
+//new,deleteを置き換えて回数を数える
+void* operator new(size_t size)
+{
+	gNewCount++;
+	void* const p = std::malloc((size > 0) ? size : 1);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+void operator delete(void* p, size_t size) noexcept
+{
+	(void)size;
+	std::free(p);
+}
+void operator delete[](void* p, size_t size) noexcept
+{
+	(void)size;
+	std::free(p);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string dataDir = "../../data";
+	std::string goldenPath = "ImageDecodeBench.golden";
+	bool isUpdate = false;
+	bool isQuick = false;
+	for (std::int32_t i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--update") {
+			isUpdate = true;
+		}
+		else if (arg == "--quick") {
+			isQuick = true;
+		}
+		else if ((arg == "--golden") && ((i + 1) < argc)) {
+			goldenPath = argv[++i];
+		}
+		else {
+			dataDir = arg;
+		}
+	}
+
+	//データフォルダの画像
+	std::vector<BenchCase> cases;
+	static const char* const SUB_DIR[] = { "bitmap", "png", "jpeg" };
+	for (const char* const subDir : SUB_DIR) {
+		const std::string dirPath = dataDir + "/" + subDir;
+		const std::vector<std::string> names = listFiles(dirPath);
+		for (auto itr = names.cbegin(); itr != names.cend(); itr++) {
+			BenchCase benchCase;
+			if (!getFormat(*itr, &benchCase.format_) || !readFile(dirPath + "/" + *itr, &benchCase.data_)) {
+				continue;
+			}
+			benchCase.name_ = std::string(subDir) + "/" + *itr;
+			benchCase.filePath_ = dirPath + "/" + *itr;
+			cases.push_back(std::move(benchCase));
+		}
+	}
+	if (cases.empty()) {
+		std::printf("no image in %s\n", dataDir.c_str());
+	}
+
+	//合成画像
+	addSynthCases(isQuick ? SYNTH_SIZE_QUICK : SYNTH_SIZE, &cases);
+
+	std::map<std::string, std::uint64_t> golden = isUpdate ? std::map<std::string, std::uint64_t>() : loadGolden(goldenPath);
+	std::vector<BenchResult> results;
+	std::int32_t ngNum = 0;
+	std::int32_t newNum = 0;
+	double totalMsec = 0;
+
+	std::printf("%-30s %11s %10s %6s %10s %8s %8s %8s %s\n", "image", "size", "input[KB]", "iter", "time[ms]", "MP/s", "MB/s", "new/dec", "golden");
+	for (auto itr = cases.cbegin(); itr != cases.cend(); itr++) {
+		const BenchResult result = measure(*itr);
+		results.push_back(result);
+		const double inputMb = double(itr->data_.size()) / (1024.0 * 1024.0);
+		const std::string size = std::to_string(result.width_) + "x" + std::to_string(result.height_);
+
+		//ゴールデンファイルと比較
+		const char* status = "OK";
+		auto found = golden.find(itr->name_);
+		if (isUpdate || (found == golden.end())) {
+			golden[itr->name_] = result.checksum_;
+			status = isUpdate ? "UPDATE" : "NEW";
+			newNum++;
+		}
+		else if (found->second != result.checksum_) {
+			status = "NG";
+			ngNum++;
+		}
+
+		if ((result.rc_ != fw::D_DECODERESULT_OK) || (result.msec_ <= 0)) {
+			std::printf("%-30s %11s %10.1f %6s %10s %8s %8s %8s %s (rc=%d)\n", itr->name_.c_str(), size.c_str(), inputMb * 1024.0,
+				"-", "-", "-", "-", "-", status, result.rc_);
+			continue;
+		}
+		const double mpix = (double(result.width_) * result.height_) / (1000.0 * 1000.0);
+		std::printf("%-30s %11s %10.1f %6d %10.3f %8.1f %8.1f %8.1f %s\n", itr->name_.c_str(), size.c_str(), inputMb * 1024.0,
+			result.iteration_, result.msec_, mpix / (result.msec_ / 1000.0), inputMb / (result.msec_ / 1000.0), result.newPerDecode_, status);
+		totalMsec += result.msec_;
+	}
+
+	std::printf("\ncases %d, total %.3f ms/pass, peak RSS %.1f MB\n", std::int32_t(cases.size()), totalMsec, double(getPeakRss()) / (1024.0 * 1024.0));
+
+	//入力ストリームのデコード(BITMAPは未対応)
+	fw::AsyncFileReader asyncReader(fw::AsyncFileReader::DEFAULT_THREAD_NUM, false);
+	fw::AsyncFileReader uringReader(fw::AsyncFileReader::DEFAULT_THREAD_NUM, true);
+	//名前,非同期読み込み(nullptrは同期読み込み)
+	const struct {
+		const char*				name_;
+		fw::AsyncFileReader*	reader_;
+	} STREAM_MODE[] = {
+		{ "sync", nullptr },
+		{ "async", &asyncReader },
+		{ "io_uring", &uringReader },
+	};
+	std::int32_t streamNgNum = 0;
+	std::printf("\n%-30s", "stream[ms]");
+	for (const auto& mode : STREAM_MODE) {
+		std::printf(" %10s", mode.name_);
+	}
+	std::printf("\n");
+	for (size_t i = 0; i < cases.size(); i++) {
+		const BenchCase& benchCase = cases[i];
+		if (benchCase.filePath_.empty() || (benchCase.format_ == fw::D_IMAGEFORMAT_BMP)) {
+			continue;
+		}
+		std::printf("%-30s", benchCase.name_.c_str());
+		for (const auto& mode : STREAM_MODE) {
+			double msec = 0;
+			if (checkStream(benchCase, results[i], mode.reader_, &msec)) {
+				std::printf(" %10.3f", msec);
+			}
+			else {
+				std::printf(" %10s", "NG");
+				streamNgNum++;
+			}
+		}
+		std::printf("\n");
+	}
+	std::printf("io_uring: %s\n", uringReader.isUring() ? "used" : "not available (pread)");
+	if (newNum > 0) {
+		//基準がなかったケースを追加して保存
+		if (saveGolden(goldenPath, golden)) {
+			std::printf("golden: %d entries written to %s\n", newNum, goldenPath.c_str());
+		}
+	}
+	if (streamNgNum > 0) {
+		std::printf("stream: %d mismatch\n", streamNgNum);
+	}
+	if (ngNum > 0) {
+		std::printf("golden: %d mismatch\n", ngNum);
+	}
+	return ((ngNum > 0) || (streamNgNum > 0)) ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+﻿//----------------------------------------------------------
+//
+// 画像IDテーブルのベンチマーク
+//
+// 登録数を変えて線形探索と画像IDテーブルの1回あたりの検索時間を比較する。
+// ビルド例: g++ -std=c++14 -O2 -I../source/framework -o ImageIdTableBench ImageIdTableBench.cpp
+//
+//----------------------------------------------------------
+
+#include "image/ImageIdTable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+	//登録データ(LocalImageDataの代わり)
+	struct Entry {
+		std::uint16_t	id_;
+		std::int32_t	size_;
+	};
+
+	//検索回数
+	static const std::int32_t LOOKUP_NUM = 10 * 1000 * 1000;
+	//線形探索の総比較回数の目安(登録数が多い場合は検索回数を減らす)
+	static const std::int64_t LINEAR_COMPARE_NUM = 2000LL * 1000 * 1000;
+
+	//1回あたりの検索時間[ns]を計測
+	template <typename Find>
+	static double measure(const std::vector<std::uint16_t>& keys, const std::int32_t lookupNum, const Find& find, std::int64_t* const sum)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (std::int32_t i = 0; i < lookupNum; i++) {
+			*sum += find(keys[size_t(i) % keys.size()]);
+		}
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / lookupNum;
+	}
+}
+
+int main()
+{
+	static const std::int32_t ENTRY_NUM[] = { 100, 1000, 10000 };
+
+	std::printf("%8s %14s %14s\n", "entries", "linear[ns]", "table[ns]");
+	for (std::int32_t entryNum : ENTRY_NUM) {
+		//画像IDを16bit空間に散らして登録(奇数の刻みで重複しない)
+		std::vector<Entry> entries(static_cast<size_t>(entryNum));
+		fw::ImageIdTable table;
+		for (std::int32_t i = 0; i < entryNum; i++) {
+			entries[i].id_ = std::uint16_t(i * 40503);
+			entries[i].size_ = i;
+			table.set(entries[i].id_, i);
+		}
+
+		//検索するIDの並び(登録済みのIDを乱順に)
+		std::vector<std::uint16_t> keys(4096);
+		std::mt19937 rand(1);
+		for (auto& key : keys) {
+			key = entries[rand() % entries.size()].id_;
+		}
+
+		std::int64_t sum = 0;
+		const std::int32_t linearNum = std::int32_t(std::min<std::int64_t>(LOOKUP_NUM, LINEAR_COMPARE_NUM / entryNum));
+		const double linear = measure(keys, linearNum, [&entries](const std::uint16_t id) {
+			for (const Entry& entry : entries) {
+				if (entry.id_ == id) {
+					return entry.size_;
+				}
+			}
+			return std::int32_t(-1);
+		}, &sum);
+		const double paged = measure(keys, LOOKUP_NUM, [&entries, &table](const std::uint16_t id) {
+			const std::int32_t index = table.find(id);
+			return (index == fw::ImageIdTable::INVALID_INDEX) ? std::int32_t(-1) : entries[index].size_;
+		}, &sum);
+
+		std::printf("%8d %14.2f %14.2f  (checksum %lld)\n", entryNum, linear, paged, static_cast<long long>(sum));
+	}
+
+	return 0;
+}
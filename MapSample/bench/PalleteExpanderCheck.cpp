@@ -0,0 +1,112 @@
+﻿//----------------------------------------------------------
+//
+// パレット展開の一致チェック
+//
+// 全ての展開処理パス(CPUが対応するもののみ)でexpandRowの結果がスカラー参照実装の
+// expandRowScalarとビット単位で一致するかを、ビット深度1/2/4/8、幅0〜299、乱数パレットで確認する。
+// 不一致(出力範囲外への書き込みを含む)があれば1を返す。
+// ビルド例: g++ -std=c++14 -O2 -I../source/framework -o PalleteExpanderCheck PalleteExpanderCheck.cpp
+//             ../source/framework/Cpu.cpp ../source/framework/image/PalleteExpander.cpp
+//
+//----------------------------------------------------------
+
+#include "Cpu.hpp"
+#include "image/PalleteExpander.hpp"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+	//確認する幅の上限(含まない)
+	static const std::int32_t WIDTH_MAX = 300;
+	//ビット深度毎に試すパレットの数
+	static const std::int32_t PALLETE_TRIAL = 8;
+	//出力範囲外への書き込みを検出する余白[byte]
+	static const std::int32_t GUARD_SIZE = 64;
+	//余白に書き込む値
+	static const std::uint8_t GUARD_VALUE = 0xCD;
+
+	//展開処理パス
+	struct Path {
+		fw::PalleteExpander::EN_ExpandPath	path_;		//展開処理パス
+		const char*							name_;		//表示名
+		bool								isUse_;		//CPUが対応しているか
+	};
+
+	//1行分を展開して比較(不一致はfalse)
+	static bool checkRow(const fw::PalleteExpander& expander, const std::vector<std::uint8_t>& src, const std::int32_t width,
+		std::vector<std::uint8_t>* const expect, std::vector<std::uint8_t>* const actual)
+	{
+		const size_t size = size_t(width) * 4 + GUARD_SIZE;
+		expect->assign(size, GUARD_VALUE);
+		actual->assign(size, GUARD_VALUE);
+		expander.expandRowScalar(src.data(), expect->data(), width);
+		expander.expandRow(src.data(), actual->data(), width);
+		return (std::memcmp(expect->data(), actual->data(), size) == 0);
+	}
+}
+
+int main()
+{
+	static const std::int32_t BIT_DEPTH[] = { 1, 2, 4, 8 };
+	const Path paths[] = {
+		{ fw::PalleteExpander::D_EXPANDPATH_SCALAR, "scalar", true },
+		{ fw::PalleteExpander::D_EXPANDPATH_SSE2, "sse2", fw::Cpu::hasSse2() },
+		{ fw::PalleteExpander::D_EXPANDPATH_AVX2, "avx2", fw::Cpu::hasAvx2() },
+		{ fw::PalleteExpander::D_EXPANDPATH_NEON, "neon", fw::Cpu::hasNeon() },
+	};
+
+	std::mt19937 rand(1);
+	std::vector<std::uint8_t> src;
+	std::vector<std::uint8_t> expect;
+	std::vector<std::uint8_t> actual;
+	std::int32_t errorNum = 0;
+
+	for (const Path& path : paths) {
+		if (!path.isUse_) {
+			std::printf("%-8s skipped (not supported)\n", path.name_);
+			continue;
+		}
+
+		std::int32_t rowNum = 0;
+		for (std::int32_t bitDepth : BIT_DEPTH) {
+			for (std::int32_t trial = 0; trial < PALLETE_TRIAL; trial++) {
+				//乱数パレット(色数も乱数にして未設定のインデックスを含める)
+				fw::PalleteExpander expander(bitDepth);
+				const std::int32_t palleteNum = std::int32_t(rand() % (1U << bitDepth)) + 1;
+				for (std::int32_t p = 0; p < palleteNum; p++) {
+					const std::uint32_t c = rand();
+					expander.setColor(p, std::uint8_t(c), std::uint8_t(c >> 8), std::uint8_t(c >> 16), std::uint8_t(c >> 24));
+				}
+				expander.build();
+				expander.setPath(path.path_);
+
+				for (std::int32_t width = 0; width < WIDTH_MAX; width++) {
+					//乱数インデックスの行(末尾の未使用ビットも乱数)
+					src.resize(size_t((width * bitDepth) + 7) / 8 + 1);
+					for (std::uint8_t& v : src) {
+						v = std::uint8_t(rand());
+					}
+
+					if (!checkRow(expander, src, width, &expect, &actual)) {
+						if (errorNum < 10) {
+							std::printf("mismatch: path=%s depth=%d width=%d trial=%d\n", path.name_, bitDepth, width, trial);
+						}
+						errorNum++;
+					}
+					rowNum++;
+				}
+			}
+		}
+		std::printf("%-8s %d rows checked\n", path.name_, rowNum);
+	}
+
+	if (errorNum > 0) {
+		std::printf("NG: %d mismatches\n", errorNum);
+		return 1;
+	}
+	std::printf("OK\n");
+	return 0;
+}
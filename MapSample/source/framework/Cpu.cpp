@@ -0,0 +1,93 @@
+﻿#include "Cpu.hpp"
+
+#if defined(FW_CPU_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+	//CPU機能フラグ
+	struct CpuFeature {
+		bool	sse2_;
+		bool	ssse3_;
+		bool	avx2_;
+		bool	neon_;
+	};
+
+	//CPU機能を判定
+	static CpuFeature detectCpuFeature()
+	{
+		CpuFeature feature = { false, false, false, false };
+
+#if defined(FW_CPU_X86)
+#if defined(_MSC_VER)
+		std::int32_t info[4] = { 0 };
+		__cpuid(info, 0);
+		const std::int32_t maxId = info[0];
+
+		__cpuid(info, 1);
+		feature.sse2_ = ((info[3] & (1 << 26)) != 0);
+		feature.ssse3_ = ((info[2] & (1 << 9)) != 0);
+
+		//AVX2はOSがYMMレジスタを保存する場合のみ使用可
+		const bool osxsave = ((info[2] & (1 << 27)) != 0);
+		const bool avx = ((info[2] & (1 << 28)) != 0);
+		if ((maxId >= 7) && osxsave && avx && ((_xgetbv(0) & 0x06) == 0x06)) {
+			__cpuidex(info, 7, 0);
+			feature.avx2_ = ((info[1] & (1 << 5)) != 0);
+		}
+#else
+		__builtin_cpu_init();
+		feature.sse2_ = (__builtin_cpu_supports("sse2") != 0);
+		feature.ssse3_ = (__builtin_cpu_supports("ssse3") != 0);
+		feature.avx2_ = (__builtin_cpu_supports("avx2") != 0);
+#endif
+#endif //FW_CPU_X86
+
+#if defined(FW_CPU_NEON)
+		//AArch64ではNEONは必須
+		feature.neon_ = true;
+#endif //FW_CPU_NEON
+
+		return feature;
+	}
+
+	//CPU機能を取得(初回のみ判定)
+	static const CpuFeature& getCpuFeature()
+	{
+		static const CpuFeature feature = detectCpuFeature();
+		return feature;
+	}
+}
+
+
+//----------------------------------------------------------
+//
+// CPU機能判定クラス
+//
+//----------------------------------------------------------
+
+//SSE2使用可否
+bool fw::Cpu::hasSse2()
+{
+	return getCpuFeature().sse2_;
+}
+
+//SSSE3使用可否
+bool fw::Cpu::hasSsse3()
+{
+	return getCpuFeature().ssse3_;
+}
+
+//AVX2使用可否
+bool fw::Cpu::hasAvx2()
+{
+	return getCpuFeature().avx2_;
+}
+
+//NEON使用可否
+bool fw::Cpu::hasNeon()
+{
+	return getCpuFeature().neon_;
+}
@@ -0,0 +1,51 @@
+﻿#ifndef INCLUDED_CPU_HPP
+#define INCLUDED_CPU_HPP
+
+#include "Std.hpp"
+
+//----------------------------------------------------------
+//
+// CPUアーキテクチャ判定
+//
+//----------------------------------------------------------
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FW_CPU_X86
+#endif
+#if defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+#define FW_CPU_NEON
+#endif
+
+//SIMD命令を使う関数に付与する属性(MSVCは不要)
+#if defined(_MSC_VER)
+#define FW_TARGET_SSE2
+#define FW_TARGET_SSSE3
+#define FW_TARGET_AVX2
+#else
+#define FW_TARGET_SSE2	__attribute__((target("sse2")))
+#define FW_TARGET_SSSE3	__attribute__((target("ssse3")))
+#define FW_TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// CPU機能判定クラス
+	//
+	//----------------------------------------------------------
+
+	class Cpu {
+	public:
+		//SSE2使用可否
+		static bool hasSse2();
+		//SSSE3使用可否
+		static bool hasSsse3();
+		//AVX2使用可否
+		static bool hasAvx2();
+		//NEON使用可否
+		static bool hasNeon();
+	};
+}
+
+#endif //INCLUDED_CPU_HPP
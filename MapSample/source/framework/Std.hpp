@@ -94,6 +94,9 @@ namespace std {
 
 	//dataフォルダのパス
 	static const char_t* const D_DATA_PATH = "C:/cygwin64/home/Kyohei/program/data";
+
+	//デコードキャッシュフォルダのパス
+	static const char_t* const D_CACHE_PATH = "C:/cygwin64/home/Kyohei/program/cache";
 }
 
 #endif //INCLUDED_FWSTD_HPP
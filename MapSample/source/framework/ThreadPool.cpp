@@ -0,0 +1,183 @@
+﻿#include "ThreadPool.hpp"
+#include <algorithm>
+
+
+//----------------------------------------------------------
+//
+// スレッドプールクラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::ThreadPool::ThreadPool(const std::int32_t threadNum) :
+	mutex_(), cond_(), taskList_(), bandList_(nullptr), workers_(), isStop_(false)
+{
+	std::int32_t num = threadNum;
+	if (num <= 0) {
+		//CPUコア数(取得できない場合は1)
+		num = std::int32_t(std::thread::hardware_concurrency());
+		if (num <= 0) {
+			num = 1;
+		}
+	}
+
+	this->workers_.reserve(size_t(num));
+	for (std::int32_t i = 0; i < num; i++) {
+		this->workers_.push_back(std::thread(&ThreadPool::run, this));
+	}
+}
+
+//デストラクタ
+fw::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		this->isStop_ = true;
+	}
+	this->cond_.notify_all();
+
+	for (auto itr = this->workers_.begin(); itr != this->workers_.end(); itr++) {
+		itr->join();
+	}
+}
+
+//タスク登録
+void fw::ThreadPool::post(const Task& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		this->taskList_.push_back(task);
+	}
+	this->cond_.notify_one();
+}
+
+//範囲を帯状に分割して並列実行
+void fw::ThreadPool::runParallel(const std::int32_t num, const std::int32_t minBand, const RangeFunc func, const void* const context)
+{
+	if (num <= 0) {
+		return;
+	}
+
+	//帯数はスレッド数(呼び出し元含む)を上限とし、1帯がminBandを下回らないようにする
+	const std::int32_t threadNum = this->getThreadNum() + 1;
+	const std::int32_t band = std::max(minBand, std::int32_t(1));
+	const std::int32_t bandNum = std::min(threadNum, (num + band - 1) / band);
+	if (bandNum <= 1) {
+		//分割しない
+		func(context, 0, num);
+		return;
+	}
+
+	BandJob job;
+	job.func_ = func;
+	job.context_ = context;
+	job.num_ = num;
+	job.bandSize_ = (num + bandNum - 1) / bandNum;
+	job.bandNum_ = (num + job.bandSize_ - 1) / job.bandSize_;
+	job.next_ = 0;
+	job.active_ = 0;
+	job.wanted_ = job.bandNum_ - 1;
+
+	//呼び出し元以外の分のワーカーを呼ぶ
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		job.link_ = this->bandList_;
+		job.isListed_ = true;
+		this->bandList_ = &job;
+	}
+	for (std::int32_t i = 1; i < job.bandNum_; i++) {
+		this->cond_.notify_one();
+	}
+
+	//呼び出し元スレッドも処理に加わる
+	runBand(&job);
+
+	//まだ加わっていないワーカーが参照しないよう一覧から外す
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		if (job.isListed_) {
+			BandJob** link = &this->bandList_;
+			while (*link != &job) {
+				link = &(*link)->link_;
+			}
+			*link = job.link_;
+			job.isListed_ = false;
+		}
+	}
+
+	//他スレッドが処理中の帯の完了を待つ
+	std::unique_lock<std::mutex> lock(job.mutex_);
+	job.cond_.wait(lock, [&job] { return (job.active_ == 0); });
+}
+
+//未処理の帯がなくなるまで処理
+void fw::ThreadPool::runBand(BandJob* const job)
+{
+	for (;;) {
+		const std::int32_t band = job->next_.fetch_add(1);
+		if (band >= job->bandNum_) {
+			break;
+		}
+
+		const std::int32_t begin = band * job->bandSize_;
+		const std::int32_t end = std::min(begin + job->bandSize_, job->num_);
+		job->func_(job->context_, begin, end);
+	}
+}
+
+//ワーカースレッド数を取得
+std::int32_t fw::ThreadPool::getThreadNum() const
+{
+	return std::int32_t(this->workers_.size());
+}
+
+//既定のスレッドプールを取得
+fw::ThreadPool& fw::ThreadPool::getDefault()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+//ワーカースレッド処理
+void fw::ThreadPool::run()
+{
+	for (;;) {
+		Task task;
+		BandJob* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex_);
+			this->cond_.wait(lock, [this] { return (this->isStop_ || (this->bandList_ != nullptr) || !this->taskList_.empty()); });
+			if (this->bandList_ != nullptr) {
+				//呼び出し元が完了を待っている帯分割実行を優先
+				job = this->bandList_;
+				job->active_++;
+				job->wanted_--;
+				if (job->wanted_ <= 0) {
+					//必要なワーカー数が揃った
+					this->bandList_ = job->link_;
+					job->isListed_ = false;
+				}
+			}
+			else if (this->taskList_.empty()) {
+				//停止要求あり、未実行タスクなし
+				break;
+			}
+			else {
+				task = std::move(this->taskList_.front());
+				this->taskList_.pop_front();
+			}
+		}
+
+		if (job != nullptr) {
+			//帯を処理して参照終了を通知(通知後は呼び出し元が破棄するため参照しない)
+			runBand(job);
+			std::lock_guard<std::mutex> lock(job->mutex_);
+			job->active_--;
+			job->cond_.notify_all();
+			continue;
+		}
+
+		//タスク実行
+		task();
+	}
+}
@@ -0,0 +1,101 @@
+﻿#ifndef INCLUDED_THREADPOOL_HPP
+#define INCLUDED_THREADPOOL_HPP
+
+#include "Std.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// スレッドプールクラス
+	//
+	// 登録したタスクをワーカースレッドで順に実行する。
+	// デストラクタは未実行のタスクを全て実行してから終了する。
+	// 帯分割実行は状態を呼び出し元のスタックに置き、タスク一覧を使わずにワーカーへ渡すため
+	// 呼び出し毎のメモリ確保はない。
+	//
+	//----------------------------------------------------------
+
+	class ThreadPool {
+	public:
+		//タスク
+		using Task = std::function<void()>;
+
+	private:
+		//範囲タスクの呼び出し関数(contextは呼び出し元の範囲タスク、beginからendの手前まで処理する)
+		using RangeFunc = void (*)(const void* const context, const std::int32_t begin, const std::int32_t end);
+
+		//帯分割実行の状態(呼び出し元のスタックに置き、参照中のワーカーがなくなってから破棄する)
+		struct BandJob {
+			RangeFunc					func_;		//範囲タスクの呼び出し関数
+			const void*					context_;	//範囲タスク
+			std::int32_t				num_;		//全体の数
+			std::int32_t				bandSize_;	//1帯の数
+			std::int32_t				bandNum_;	//帯数
+			std::atomic<std::int32_t>	next_;		//次に処理する帯
+			std::atomic<std::int32_t>	active_;	//参照中のワーカー数
+			std::int32_t				wanted_;	//加わるワーカーの残り数(mutex_で排他)
+			bool						isListed_;	//帯分割一覧に登録中か(mutex_で排他)
+			BandJob*					link_;		//帯分割一覧の次の状態(mutex_で排他)
+			std::mutex					mutex_;		//排他
+			std::condition_variable		cond_;		//ワーカーの参照終了通知
+		};
+
+		//メンバ変数
+		std::mutex					mutex_;		//排他
+		std::condition_variable		cond_;		//タスク登録通知
+		std::deque<Task>			taskList_;	//未実行タスク
+		BandJob*					bandList_;	//ワーカーの参加を待つ帯分割実行(後から登録した順)
+		std::vector<std::thread>	workers_;	//ワーカースレッド
+		bool						isStop_;	//停止要求
+
+	public:
+		//コンストラクタ(threadNumが0の場合はCPUコア数)
+		ThreadPool(const std::int32_t threadNum = 0);
+		//デストラクタ
+		~ThreadPool();
+		//タスク登録
+		void post(const Task& task);
+		//範囲を帯状に分割して並列実行(全て完了するまで戻らない)
+		//taskはtask(begin, end)でbeginからendの手前まで処理する関数オブジェクト
+		//呼び出し元スレッドも帯の処理に加わるため、ワーカースレッドから呼んでもよい
+		template <typename T>
+		void parallelFor(const std::int32_t num, const std::int32_t minBand, const T& task)
+		{
+			this->runParallel(num, minBand, &ThreadPool::callRange<T>, &task);
+		}
+		//ワーカースレッド数を取得
+		std::int32_t getThreadNum() const;
+
+		//既定のスレッドプールを取得
+		static ThreadPool& getDefault();
+
+		//コピーコンストラクタ(禁止)
+		ThreadPool(const ThreadPool& org) = delete;
+		//代入演算子(禁止)
+		ThreadPool& operator=(const ThreadPool& org) = delete;
+
+	private:
+		//範囲タスクを呼び出し
+		template <typename T>
+		static void callRange(const void* const context, const std::int32_t begin, const std::int32_t end)
+		{
+			(*static_cast<const T*>(context))(begin, end);
+		}
+		//範囲を帯状に分割して並列実行
+		void runParallel(const std::int32_t num, const std::int32_t minBand, const RangeFunc func, const void* const context);
+		//未処理の帯がなくなるまで処理
+		static void runBand(BandJob* const job);
+		//ワーカースレッド処理
+		void run();
+	};
+}
+
+#endif //INCLUDED_THREADPOOL_HPP
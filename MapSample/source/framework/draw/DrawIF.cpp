@@ -1,5 +1,7 @@
 ﻿#include "DrawIF.hpp"
 #include "image/Font.hpp"
+#include "image/ImageCache.hpp"
+#include "image/ImageAtlas.hpp"
 
 
 //----------------------------------------------------------
@@ -10,10 +12,16 @@
 
 //コンストラクタ
 fw::DrawIF::DrawIF() :
-	font_(nullptr)
+	font_(nullptr), imageCache_(nullptr), imageAtlas_(nullptr)
 {
 	//フォントオブジェクトを作成
 	this->font_ = new fw::Font();
+
+	//画像キャッシュを作成
+	this->imageCache_ = new fw::ImageCache();
+
+	//画像アトラスを作成
+	this->imageAtlas_ = new fw::ImageAtlas();
 }
 
 //デストラクタ
@@ -23,4 +31,40 @@ fw::DrawIF::~DrawIF()
 		//フォントオブジェクトを解放
 		delete this->font_;
 	}
+	if (this->imageCache_ != nullptr) {
+		//画像キャッシュを解放
+		delete this->imageCache_;
+	}
+	if (this->imageAtlas_ != nullptr) {
+		//画像アトラスを解放
+		delete this->imageAtlas_;
+	}
+}
+
+//イメージ一括描画
+void fw::DrawIF::drawImages(const DrawCoords& coords, const std::vector<fw::Image>& images)
+{
+	//一括描画に対応しない描画I/Fは1枚ずつ描画
+	for (size_t i = 0; (i < coords.size()) && (i < images.size()); i++) {
+		this->drawImage(coords[i], images[i]);
+	}
+}
+
+//イメージ描画準備
+void fw::DrawIF::prepareImages(const std::vector<fw::Image>& images)
+{
+	(void)images;
+	//画像キャッシュを持たない描画I/Fは何もしない(drawImageでデコードする)
+}
+
+//画像キャッシュを取得
+fw::ImageCache* fw::DrawIF::getImageCache()
+{
+	return this->imageCache_;
+}
+
+//画像アトラスを取得
+fw::ImageAtlas* fw::DrawIF::getImageAtlas()
+{
+	return this->imageAtlas_;
 }
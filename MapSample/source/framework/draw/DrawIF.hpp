@@ -12,6 +12,8 @@ namespace fw {
 	//前方宣言
 	struct Image;
 	class Font;
+	class ImageCache;
+	class ImageAtlas;
 }
 
 namespace fw {
@@ -45,6 +47,8 @@ namespace fw {
 	class DrawIF {
 	protected:
 		fw::Font*		font_;		//フォント
+		fw::ImageCache*	imageCache_;	//画像キャッシュ
+		fw::ImageAtlas*	imageAtlas_;	//画像アトラス
 
 	public:
 		//コンストラクタ
@@ -69,11 +73,20 @@ namespace fw {
 		virtual void drawPolygons(const DrawCoords& coords, const DrawColors& colors) = 0;
 		//イメージ描画
 		virtual void drawImage(const std::CoordI& coord, const fw::Image& image) = 0;
+		//イメージ一括描画(coordsとimagesは同じ順、既定はdrawImageを順に呼ぶ)
+		virtual void drawImages(const DrawCoords& coords, const std::vector<fw::Image>& images);
+		//イメージ描画準備(未キャッシュの画像をまとめて並列デコード)
+		virtual void prepareImages(const std::vector<fw::Image>& images);
 		//文字描画
 		virtual void drawString(const std::CoordI& coord, const wchar_t* const str) = 0;
 
 		//画面幅高さを取得
 		virtual std::WH getScreenWH() = 0;
+
+		//画像キャッシュを取得(上限設定、統計取得用)
+		fw::ImageCache* getImageCache();
+		//画像アトラスを取得(統計取得用)
+		fw::ImageAtlas* getImageAtlas();
 	};
 }
 
@@ -3,15 +3,137 @@
 #ifdef DRAWIF_WGL
 #include "image/Image.hpp"
 #include "image/Font.hpp"
+#include "image/ImageCache.hpp"
+#include "image/ImageAtlas.hpp"
 
 #include <gl/GL.h>
 #include <gl/GLU.h>
+#include <unordered_set>
 
 
 #pragma comment(lib, "opengl32.lib")
 #pragma comment(lib, "glu32.lib")
 
 
+namespace {
+
+	//画像キャッシュのエントリ解放(テクスチャ削除)
+	static void releaseImageCacheEntry(const fw::ImageCacheEntry& entry)
+	{
+		GLuint texId = GLuint(entry.texId_);
+		glDeleteTextures(1, &texId);
+	}
+
+	//デコード画像からテクスチャを作成
+	static GLuint createTexture(const std::int32_t width, const std::int32_t height, const std::uint8_t* const decode)
+	{
+		//テクスチャ作成
+		GLuint texId = 0;
+		glGenTextures(1, &texId);
+
+		//テクスチャ割り当て
+		glBindTexture(GL_TEXTURE_2D, texId);
+
+		//テクスチャ画像は1バイト単位
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decode);
+
+		//テクスチャパラメータ
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		return texId;
+	}
+
+	//画像アトラスのページ(テクスチャ)を作成
+	static std::uint32_t createAtlasPage(const std::int32_t pageSize)
+	{
+		GLuint texId = 0;
+		glGenTextures(1, &texId);
+		glBindTexture(GL_TEXTURE_2D, texId);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageSize, pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+		//画像の周囲に余白があるため線形補間でも隣の画像はにじまない
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		return std::uint32_t(texId);
+	}
+
+	//画像アトラスのページへ画像を転送
+	static void uploadAtlasPage(const std::uint32_t texId, const std::int32_t x, const std::int32_t y, const std::int32_t width, const std::int32_t height, const std::uint8_t* const data)
+	{
+		glBindTexture(GL_TEXTURE_2D, GLuint(texId));
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	//画像アトラスのページを解放(テクスチャ削除)
+	static void releaseAtlasPage(const std::uint32_t texId)
+	{
+		GLuint id = GLuint(texId);
+		glDeleteTextures(1, &id);
+	}
+
+	//テクスチャ描画開始
+	static void beginTexture(const GLuint texId)
+	{
+		//テクスチャ割り当て
+		glBindTexture(GL_TEXTURE_2D, texId);
+
+		//テクスチャ環境
+		//テクスチャカラーを使用する
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+		//テクスチャ描画
+		glEnable(GL_TEXTURE_2D);
+		glBegin(GL_QUADS);
+
+		//色
+		//念のためフラグメントカラーを255で初期化する
+		glColor4ub(255, 255, 255, 255);
+	}
+
+	//テクスチャ描画終了
+	static void endTexture()
+	{
+		glEnd();
+		glDisable(GL_TEXTURE_2D);
+
+		//テクスチャ割り当て解除
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	//テクスチャの矩形を追加(coordが画像の左下、u0,v0が画像の左上のUV)
+	static void addTextureQuad(const std::CoordI& coord, const std::int32_t width, const std::int32_t height,
+		const std::float_t u0, const std::float_t v0, const std::float_t u1, const std::float_t v1)
+	{
+		std::AreaI area;
+		area.xmin = coord.x;
+		area.ymin = coord.y - height;
+		area.xmax = coord.x + width;
+		area.ymax = coord.y;
+
+		//座標
+		glTexCoord2f(u0, v0);
+		glVertex3i(area.xmin, area.ymax, 0);
+		glTexCoord2f(u1, v0);
+		glVertex3i(area.xmax, area.ymax, 0);
+		glTexCoord2f(u1, v1);
+		glVertex3i(area.xmax, area.ymin, 0);
+		glTexCoord2f(u0, v1);
+		glVertex3i(area.xmin, area.ymin, 0);
+	}
+}
+
+
 //----------------------------------------------------------
 //
 // WGL描画クラス
@@ -28,6 +150,12 @@ fw::DrawWGL::DrawWGL(const HWND hWnd) :
 fw::DrawWGL::~DrawWGL()
 {
 	if (this->hGLRC_ != nullptr) {
+		//キャッシュしたテクスチャを削除
+		::wglMakeCurrent(this->hDC_, this->hGLRC_);
+		this->imageCache_->clear();
+		this->imageAtlas_->clear();
+		::wglMakeCurrent(this->hDC_, nullptr);
+
 		//描画コンテキストハンドルを破棄
 		::wglDeleteContext(this->hGLRC_);
 	}
@@ -81,6 +209,12 @@ void fw::DrawWGL::create()
 	//描画コンテキストハンドルを作成
 	this->hGLRC_ = ::wglCreateContext(this->hDC_);
 
+	//画像キャッシュのエントリ解放時にテクスチャを削除
+	this->imageCache_->setReleaseFunc(releaseImageCacheEntry);
+
+	//画像アトラスのページはテクスチャとして作成、転送、削除
+	this->imageAtlas_->setPageFunc(createAtlasPage, uploadAtlasPage, releaseAtlasPage);
+
 	//描画コンテキストをカレントに設定
 	::wglMakeCurrent(this->hDC_, this->hGLRC_);
 
@@ -100,6 +234,11 @@ void fw::DrawWGL::setup(const DrawStatus& drawStatus)
 	::BeginPaint(this->hWnd_, &ps);
 	::EndPaint(this->hWnd_, &ps);
 
+	//画像アトラスのフレーム開始(前のフレームで使用したページを追い出し可能にする)
+	this->imageAtlas_->beginFrame();
+	//画像キャッシュのフレーム開始(前のフレームで先読みしたキーの記録を破棄する)
+	this->imageCache_->beginFrame();
+
 	//ビューポート設定
 	const std::AreaI vp = drawStatus.viewport_;
 	glViewport(vp.xmin, vp.ymin, vp.xmax, vp.ymax);
@@ -248,73 +387,180 @@ void fw::DrawWGL::drawPolygons(const DrawCoords& coords, const DrawColors& color
 //イメージ描画
 void fw::DrawWGL::drawImage(const std::CoordI& coord, const fw::Image& image)
 {
-	//イメージをデコード
-	ImageDecorder decorder;
-	(void)decorder.decode(image);
+	//アトラス、キャッシュ済みテクスチャを検索
+	const bool isCacheable = fw::ImageCacheKey::isCacheable(image);
+	const fw::ImageCacheKey key = fw::ImageCacheKey::make(image);
+	const fw::ImageAtlasRegion* region = nullptr;
+	const fw::ImageCacheEntry* entry = nullptr;
+	if (isCacheable) {
+		//ヒット、ミスの統計はここで数える(アトラスのヒットもキャッシュの統計へ加える、prepareImagesでデコードした画像はミスとして数え済み)
+		region = this->imageAtlas_->find(key);
+		if (region != nullptr) {
+			this->imageCache_->addHit(key);
+		}
+		else {
+			entry = this->imageCache_->find(key);
+		}
+	}
 
-	//デコード画像を取得
-	std::int32_t decodeSize = 0;
+	GLuint texId = 0;
 	std::int32_t width = 0;
 	std::int32_t height = 0;
-	std::uint8_t* decode = decorder.getDecodeData(&decodeSize, &width, &height);
-
-	//テクスチャ作成
-	GLuint texId;
-	glGenTextures(1, &texId);
+	bool isTemporary = false;
+	if (region == nullptr) {
+		if (entry != nullptr) {
+			//キャッシュヒット:デコード、テクスチャ転送なし
+			texId = GLuint(entry->texId_);
+			width = entry->width_;
+			height = entry->height_;
+		}
+		else {
+			//イメージをデコード
+			ImageDecorder decorder;
+			(void)decorder.decode(image);
+
+			//デコード画像を取得
+			std::int32_t decodeSize = 0;
+			std::uint8_t* decode = decorder.getDecodeData(&decodeSize, &width, &height);
+
+			//小さな画像はアトラスへ登録
+			if (isCacheable) {
+				region = this->imageAtlas_->insert(key, decode, width, height, decorder.getStride());
+			}
+			if (region == nullptr) {
+				//テクスチャ作成
+				texId = createTexture(width, height, decode);
+
+				//テクスチャをキャッシュに登録(デコードデータは保持しない)
+				isTemporary = true;
+				if (isCacheable) {
+					fw::ImageCacheEntry newEntry;
+					newEntry.key_ = key;
+					newEntry.width_ = width;
+					newEntry.height_ = height;
+					newEntry.byteSize_ = size_t(decodeSize);
+					newEntry.texId_ = std::uint32_t(texId);
+					newEntry.data_ = nullptr;
+					isTemporary = (this->imageCache_->insert(newEntry) == nullptr);
+				}
+			}
+		}
+	}
 
-	//テクスチャ割り当て
-	glBindTexture(GL_TEXTURE_2D, texId);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decode);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//テクスチャ描画
+	if (region != nullptr) {
+		//アトラスのページの一部を描画
+		beginTexture(GLuint(region->texId_));
+		addTextureQuad(coord, region->width_, region->height_, region->u0_, region->v0_, region->u1_, region->v1_);
+		endTexture();
+	}
+	else {
+		beginTexture(texId);
+		addTextureQuad(coord, width, height, 0.0F, 0.0F, 1.0F, 1.0F);
+		endTexture();
+	}
 
-	//テクスチャ割り当て
-	glBindTexture(GL_TEXTURE_2D, texId);
+	if (isTemporary) {
+		//キャッシュしなかったテクスチャは削除
+		glDeleteTextures(1, &texId);
+	}
+}
 
-	//テクスチャ画像は1バイト単位
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+//イメージ一括描画
+void fw::DrawWGL::drawImages(const DrawCoords& coords, const std::vector<fw::Image>& images)
+{
+	//アトラスの同じページの画像が続く間は1回のテクスチャ割り当て、描画にまとめる
+	//(描画順は変えないため、ページが切り替わる、アトラスにない画像がある場合は区切る)
+	GLuint batchTexId = 0;
+	bool isBatch = false;
+	for (size_t i = 0; (i < coords.size()) && (i < images.size()); i++) {
+		const fw::ImageAtlasRegion* region = nullptr;
+		fw::ImageCacheKey key = {};
+		if (fw::ImageCacheKey::isCacheable(images[i])) {
+			key = fw::ImageCacheKey::make(images[i]);
+			region = this->imageAtlas_->find(key);
+		}
 
-	//テクスチャパラメータ
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		if (isBatch && ((region == nullptr) || (GLuint(region->texId_) != batchTexId))) {
+			endTexture();
+			isBatch = false;
+		}
+		if (region == nullptr) {
+			//アトラスにない画像は1枚ずつ描画
+			this->drawImage(coords[i], images[i]);
+			continue;
+		}
+		if (!isBatch) {
+			batchTexId = GLuint(region->texId_);
+			beginTexture(batchTexId);
+			isBatch = true;
+		}
+		this->imageCache_->addHit(key);
+		addTextureQuad(coords[i], region->width_, region->height_, region->u0_, region->v0_, region->u1_, region->v1_);
+	}
+	if (isBatch) {
+		endTexture();
+	}
+}
 
-	//テクスチャ環境
-	//テクスチャカラーを使用する
-	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+//イメージ描画準備
+void fw::DrawWGL::prepareImages(const std::vector<fw::Image>& images)
+{
+	//未キャッシュの画像を抽出(同じ画像は1度だけデコード)
+	std::vector<fw::Image> decodeList;
+	std::unordered_set<fw::ImageCacheKey, fw::ImageCacheKeyHash> keySet;
+	for (auto itr = images.cbegin(); itr != images.cend(); itr++) {
+		if (!fw::ImageCacheKey::isCacheable(*itr)) {
+			continue;
+		}
+		const fw::ImageCacheKey key = fw::ImageCacheKey::make(*itr);
+		//デコードする画像は登録時にミスとして数え、描画時の検索では数えない
+		if ((this->imageAtlas_->find(key) == nullptr) && !this->imageCache_->contains(key) && keySet.insert(key).second) {
+			decodeList.push_back(*itr);
+		}
+	}
+	if (decodeList.empty()) {
+		return;
+	}
 
-	//テクスチャ描画
-	glEnable(GL_TEXTURE_2D);
-	glBegin(GL_TRIANGLE_STRIP);
-	{
-		//色
-		//念のためフラグメントカラーを255で初期化する
-		glColor4ub(255, 255, 255, 255);
+	//ワーカースレッドで並列にデコード
+	std::vector<std::future<fw::ImageDecodeResult>> futures = fw::ImageDecorder::decodeBatch(decodeList);
 
-		std::AreaI area;
-		area.xmin = coord.x;
-		area.ymin = coord.y - height;
-		area.xmax = coord.x + width;
-		area.ymax = coord.y;
+	//テクスチャ転送はGLコンテキストを持つこのスレッドで完了順に関係なく登録順に実施
+	for (size_t i = 0; i < futures.size(); i++) {
+		fw::ImageDecodeResult result = futures[i].get();
 
-		//座標
-		glTexCoord2f(0.0F, 0.0F);
-		glVertex3i(area.xmin, area.ymax, 0);
-		glTexCoord2f(1.0F, 0.0F);
-		glVertex3i(area.xmax, area.ymax, 0);
-		glTexCoord2f(0.0F, 1.0F);
-		glVertex3i(area.xmin, area.ymin, 0);
-		glTexCoord2f(1.0F, 1.0F);
-		glVertex3i(area.xmax, area.ymin, 0);
-	}
-	glEnd();
-	glDisable(GL_TEXTURE_2D);
+		std::int32_t decodeSize = 0;
+		std::int32_t width = 0;
+		std::int32_t height = 0;
+		std::uint8_t* decode = result.decorder_->getDecodeData(&decodeSize, &width, &height);
+		if ((result.rc_ != fw::D_DECODERESULT_OK) || (decode == nullptr)) {
+			continue;
+		}
 
-	//テクスチャ割り当て解除
-	glBindTexture(GL_TEXTURE_2D, 0);
+		//小さな画像はアトラスへ登録
+		const fw::ImageCacheKey key = fw::ImageCacheKey::make(decodeList[i]);
+		if (this->imageAtlas_->insert(key, decode, width, height, result.decorder_->getStride()) != nullptr) {
+			this->imageCache_->addPrepared(key);
+			continue;
+		}
 
-	//テクスチャ削除
-	glDeleteTextures(1, &texId);
+		//テクスチャを作成してキャッシュに登録
+		fw::ImageCacheEntry newEntry;
+		newEntry.key_ = key;
+		newEntry.width_ = width;
+		newEntry.height_ = height;
+		newEntry.byteSize_ = size_t(decodeSize);
+		newEntry.texId_ = std::uint32_t(createTexture(width, height, decode));
+		newEntry.data_ = nullptr;
+		if (this->imageCache_->insert(newEntry) == nullptr) {
+			//キャッシュ上限を超える画像は描画時にデコードする(ミスは描画時に数える)
+			GLuint texId = GLuint(newEntry.texId_);
+			glDeleteTextures(1, &texId);
+			continue;
+		}
+		this->imageCache_->addPrepared(key);
+	}
 }
 
 //文字描画
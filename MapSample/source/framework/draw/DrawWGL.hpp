@@ -47,6 +47,10 @@ namespace fw {
 		virtual void drawPolygons(const DrawCoords& coords, const DrawColors& colors);
 		//イメージ描画
 		virtual void drawImage(const std::CoordI& coord, const fw::Image& image);
+		//イメージ一括描画
+		virtual void drawImages(const DrawCoords& coords, const std::vector<fw::Image>& images);
+		//イメージ描画準備
+		virtual void prepareImages(const std::vector<fw::Image>& images);
 		//文字描画
 		virtual void drawString(const std::CoordI& coord, const wchar_t* const str);
 
@@ -0,0 +1,657 @@
+﻿#include "DecodeCache.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "io/ByteIO.hpp"
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+	//キャッシュファイルヘッダのオフセット
+	static const std::uint32_t HEADER_MAGIC_OFS = 0;
+	static const std::uint32_t HEADER_VERSION_OFS = 4;
+	static const std::uint32_t HEADER_FLAG_OFS = 6;
+	static const std::uint32_t HEADER_WIDTH_OFS = 8;
+	static const std::uint32_t HEADER_HEIGHT_OFS = 12;
+	static const std::uint32_t HEADER_SRCSIZE_OFS = 16;
+	static const std::uint32_t HEADER_CHECK_OFS = 20;
+	static const std::uint32_t HEADER_KEY_OFS = 24;
+
+	//キャッシュファイルのフラグ
+	static const std::uint16_t FLAG_PACKED = 0x0001;
+
+	//索引ファイル
+	static const char* const INDEX_FILE = "index.bin";
+	static const std::uint8_t INDEX_MAGIC[4] = { 'F', 'W', 'D', 'I' };
+	static const std::uint32_t INDEX_HEADER_SIZE = 16;
+	static const std::uint32_t INDEX_ENTRY_SIZE = 16;
+
+	//ハッシュの定数(xxHash64の素数)
+	static const std::uint64_t HASH_PRIME1 = 11400714785074694791ULL;
+	static const std::uint64_t HASH_PRIME2 = 14029467366897019727ULL;
+	static const std::uint64_t HASH_PRIME3 = 1609587929392839161ULL;
+	static const std::uint64_t HASH_PRIME4 = 9650029242287828579ULL;
+	static const std::uint64_t HASH_PRIME5 = 2870177450012600261ULL;
+
+	//LZ4ブロック形式の定数
+	static const size_t LZ4_MINMATCH = 4;		//最小一致長
+	static const size_t LZ4_LASTLITERALS = 5;	//末尾に必ず残すリテラル数
+	static const size_t LZ4_MFLIMIT = 12;		//末尾からこのバイト数以内では一致を探さない
+	static const size_t LZ4_MAXOFFSET = 65535;	//最大一致距離
+	static const std::int32_t LZ4_HASHLOG = 14;	//ハッシュテーブルのビット数
+
+	//ハッシュの計算途中の値(キー、照合用の2系統)
+	struct HashState {
+		std::uint64_t	key_;		//キー(xxHash64のラウンド)
+		std::uint64_t	check_;		//照合用(別の定数、回転数のラウンド)
+	};
+
+	//左回転
+	static std::uint64_t rotateLeft(const std::uint64_t value, const std::int32_t shift)
+	{
+		return (value << shift) | (value >> (64 - shift));
+	}
+
+	//値をハッシュに加える(乗算後に回転して上位ビットの変化も全ビットへ広げる)
+	static void hashValue(HashState* const state, const std::uint64_t value)
+	{
+		state->key_ = rotateLeft(state->key_ + (value * HASH_PRIME2), 31) * HASH_PRIME1;
+		state->check_ = (rotateLeft(state->check_ ^ (value * HASH_PRIME4), 27) * HASH_PRIME3) + HASH_PRIME5;
+	}
+
+	//データをハッシュに加える(8バイト単位、端数は0で埋めた1語)
+	static void hashData(HashState* const state, const std::uint8_t* const data, const size_t size)
+	{
+		hashValue(state, std::uint64_t(size));
+		if (data == nullptr) {
+			return;
+		}
+		size_t i = 0;
+		for (; (i + 8) <= size; i += 8) {
+			std::uint64_t value;
+			std::memcpy(&value, data + i, sizeof(value));
+			hashValue(state, value);
+		}
+		if (i < size) {
+			std::uint64_t value = 0;
+			std::memcpy(&value, data + i, size - i);
+			hashValue(state, value);
+		}
+	}
+
+	//ハッシュを確定(xxHash64の最終混合)
+	static std::uint64_t finalizeHash(std::uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= HASH_PRIME2;
+		hash ^= hash >> 29;
+		hash *= HASH_PRIME3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	//画像データをハッシュに加える(デコード結果が変わる指定のみ、isSizeはJPEGの指定サイズを含めるか)
+	static void hashImageData(HashState* const state, const fw::Image::ImageData& imageData, const bool isSize)
+	{
+		if (isSize) {
+			hashValue(state, std::uint32_t(imageData.width_));
+			hashValue(state, std::uint32_t(imageData.height_));
+		}
+		const bool isChgPallete = (imageData.isChgPallete_ == 1) && (imageData.palleteNum_ > 0);
+		hashValue(state, isChgPallete ? 1 : 0);
+		if (isChgPallete) {
+			//差し替えパレット(1色4バイト)
+			hashData(state, imageData.pallete_, size_t(imageData.palleteNum_) * 4);
+		}
+		const size_t dataSize = (imageData.dataSize_ > 0) ? size_t(imageData.dataSize_) : 0;
+		hashData(state, imageData.data_, dataSize);
+	}
+
+	//4バイトを読み込み(ハッシュ計算用、エンディアン非依存の必要なし)
+	static std::uint32_t readHash4(const std::uint8_t* const data)
+	{
+		std::uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	//LZ4の長さの続きを書き込み
+	static std::uint8_t* writeLz4Length(std::uint8_t* out, size_t length)
+	{
+		while (length >= 255) {
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = std::uint8_t(length);
+		return out;
+	}
+
+	//LZ4ブロック形式で圧縮(出力先に収まらない場合は0)
+	static size_t packLz4(const std::uint8_t* const data, const size_t dataSize, std::uint8_t* const outData, const size_t outSize)
+	{
+		std::vector<std::uint32_t> hashTable(size_t(1) << LZ4_HASHLOG, 0);
+
+		const std::uint8_t* const end = data + dataSize;
+		const std::uint8_t* ip = data;
+		const std::uint8_t* anchor = data;
+		std::uint8_t* op = outData;
+		std::uint8_t* const opEnd = outData + outSize;
+
+		if (dataSize > LZ4_MFLIMIT) {
+			const std::uint8_t* const matchLimit = end - LZ4_LASTLITERALS;
+			const std::uint8_t* const ipLimit = end - LZ4_MFLIMIT;
+			while (ip < ipLimit) {
+				//同じ4バイトが直前に出現した位置を探す
+				const std::uint32_t sequence = readHash4(ip);
+				const std::uint32_t h = (sequence * 2654435761U) >> (32 - LZ4_HASHLOG);
+				const std::uint8_t* ref = data + hashTable[h];
+				hashTable[h] = std::uint32_t(ip - data);
+				if ((ref >= ip) || (size_t(ip - ref) > LZ4_MAXOFFSET) || (readHash4(ref) != sequence)) {
+					ip++;
+					continue;
+				}
+
+				//一致を前後に延ばす
+				const std::uint8_t* matchEnd = ip + LZ4_MINMATCH;
+				const std::uint8_t* refEnd = ref + LZ4_MINMATCH;
+				while ((matchEnd < matchLimit) && (*matchEnd == *refEnd)) {
+					matchEnd++;
+					refEnd++;
+				}
+				while ((ip > anchor) && (ref > data) && (ip[-1] == ref[-1])) {
+					ip--;
+					ref--;
+				}
+
+				const size_t literalLength = size_t(ip - anchor);
+				const size_t matchLength = size_t(matchEnd - ip) - LZ4_MINMATCH;
+				if ((1 + (literalLength / 255) + 1 + literalLength + 2 + (matchLength / 255) + 1) > size_t(opEnd - op)) {
+					return 0;
+				}
+
+				//トークン、リテラル、一致距離、一致長
+				std::uint8_t* const token = op++;
+				*token = std::uint8_t(std::min(literalLength, size_t(15)) << 4);
+				if (literalLength >= 15) {
+					op = writeLz4Length(op, literalLength - 15);
+				}
+				std::memcpy(op, anchor, literalLength);
+				op += literalLength;
+				fw::ByteWriter::write2ByteLe(op, std::uint16_t(ip - ref));
+				op += 2;
+				*token |= std::uint8_t(std::min(matchLength, size_t(15)));
+				if (matchLength >= 15) {
+					op = writeLz4Length(op, matchLength - 15);
+				}
+
+				ip = matchEnd;
+				anchor = ip;
+			}
+		}
+
+		//末尾のリテラル
+		const size_t literalLength = size_t(end - anchor);
+		if ((1 + (literalLength / 255) + 1 + literalLength) > size_t(opEnd - op)) {
+			return 0;
+		}
+		std::uint8_t* const token = op++;
+		*token = std::uint8_t(std::min(literalLength, size_t(15)) << 4);
+		if (literalLength >= 15) {
+			op = writeLz4Length(op, literalLength - 15);
+		}
+		std::memcpy(op, anchor, literalLength);
+		op += literalLength;
+
+		return size_t(op - outData);
+	}
+
+	//LZ4の長さの続きを読み込み(不正なデータはfalse)
+	static bool readLz4Length(const std::uint8_t** const ip, const std::uint8_t* const ipEnd, size_t* const length)
+	{
+		std::uint8_t value = 0;
+		do {
+			if (*ip >= ipEnd) {
+				return false;
+			}
+			value = *(*ip)++;
+			*length += value;
+		} while (value == 255);
+		return true;
+	}
+
+	//フォルダを作成(作成済みの場合も含め失敗は無視)
+	static void makeDirectory(const std::string& dirPath)
+	{
+#if defined(_WIN32)
+		(void)_mkdir(dirPath.c_str());
+#else
+		(void)mkdir(dirPath.c_str(), 0755);
+#endif
+	}
+
+	//ファイルが存在するか
+	static bool existsFile(const std::string& filePath)
+	{
+		fw::File file;
+		(void)file.create(filePath);
+		return file.open("rb");
+	}
+
+	//ファイルを置き換え(置き換え先は削除してから名前を変更)
+	static bool replaceFile(const std::string& srcPath, const std::string& dstPath)
+	{
+		(void)std::remove(dstPath.c_str());
+		return (std::rename(srcPath.c_str(), dstPath.c_str()) == 0);
+	}
+}
+
+
+//----------------------------------------------------------
+//
+// デコードキャッシュクラス
+//
+//----------------------------------------------------------
+
+//識別子
+const std::uint8_t fw::DecodeCache::MAGIC[4] = { 'F', 'W', 'D', 'C' };
+
+//コンストラクタ
+fw::DecodeCache::DecodeCache(const std::string& cacheDir, const size_t maxByte, const bool isPack) :
+	mutex_(), cacheDir_(cacheDir), maxByte_(maxByte), isPack_(isPack), entryList_(), usedByte_(0), useCount_(0), isDirty_(false), tempCount_(0)
+{
+	makeDirectory(this->cacheDir_);
+
+	//索引読み込み
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	this->loadIndex();
+	this->trim(0);
+}
+
+//デストラクタ
+fw::DecodeCache::~DecodeCache()
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	if (this->isDirty_) {
+		this->saveIndex();
+	}
+}
+
+//検索
+bool fw::DecodeCache::find(const DecodeCacheKey& key, DecodeCacheData* const data)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		auto itr = this->entryList_.find(key.hash_);
+		if (itr == this->entryList_.end()) {
+			return false;
+		}
+		itr->second.lastUse_ = ++this->useCount_;
+		this->isDirty_ = true;
+	}
+
+	//キャッシュファイルをマップ
+	std::unique_ptr<File> file(new File());
+	(void)file->create(this->getFilePath(key.hash_));
+	const std::uint8_t* header = nullptr;
+	if (file->open("rb") && (file->getFileSize() >= HEADER_SIZE)) {
+		//展開、変換で先頭から順に参照する
+		header = file->view(0, size_t(file->getFileSize())).data_;
+		file->advise(0, size_t(file->getFileSize()), D_FILEADVICE_SEQUENTIAL);
+	}
+
+	//ヘッダ検証
+	bool isValid = false;
+	if (header != nullptr) {
+		const std::int32_t width = std::int32_t(fw::ByteReader::read4ByteLe(&header[HEADER_WIDTH_OFS]));
+		const std::int32_t height = std::int32_t(fw::ByteReader::read4ByteLe(&header[HEADER_HEIGHT_OFS]));
+		const std::uint64_t rawSize = std::uint64_t(width) * std::uint64_t(height) * 4;
+		const std::uint64_t storedSize = file->getFileSize() - HEADER_SIZE;
+		const bool isPacked = ((fw::ByteReader::read2ByteLe(&header[HEADER_FLAG_OFS]) & FLAG_PACKED) != 0);
+		//キーに加えて照合用のハッシュと画像データのバイト数が一致しなければ別画像
+		isValid = ((std::memcmp(&header[HEADER_MAGIC_OFS], MAGIC, sizeof(MAGIC)) == 0)
+			&& (fw::ByteReader::read2ByteLe(&header[HEADER_VERSION_OFS]) == VERSION)
+			&& (fw::ByteReader::read8ByteLe(&header[HEADER_KEY_OFS]) == key.hash_)
+			&& (fw::ByteReader::read4ByteLe(&header[HEADER_CHECK_OFS]) == key.check_)
+			&& (fw::ByteReader::read4ByteLe(&header[HEADER_SRCSIZE_OFS]) == key.srcSize_)
+			&& (width > 0) && (height > 0)
+			&& (rawSize <= std::uint64_t(INT32_MAX))
+			&& (isPacked ? (storedSize < rawSize) : (storedSize == rawSize)));
+		if (isValid) {
+			data->data_ = header + HEADER_SIZE;
+			data->dataSize_ = std::int32_t(storedSize);
+			data->isPacked_ = isPacked;
+			data->width_ = width;
+			data->height_ = height;
+			data->file_ = std::move(file);
+		}
+	}
+
+	if (!isValid) {
+		//読めない、古いバージョン、別画像のキャッシュファイルは削除
+		file.reset();
+		this->remove(key.hash_);
+	}
+
+	return isValid;
+}
+
+//登録
+bool fw::DecodeCache::store(const DecodeCacheKey& key, const std::uint8_t* const decode, const std::int32_t width, const std::int32_t height, const std::int32_t stride)
+{
+	if ((decode == nullptr) || (width <= 0) || (height <= 0) || (stride < (width * 4))) {
+		return false;
+	}
+	const std::uint64_t rawSize = std::uint64_t(width) * std::uint64_t(height) * 4;
+	if ((rawSize > std::uint64_t(INT32_MAX)) || ((rawSize + HEADER_SIZE) > this->maxByte_)) {
+		//上限を超える画像はキャッシュしない
+		return false;
+	}
+
+	//1行を幅*4バイトに詰めたデータ
+	const size_t rowByte = size_t(width) * 4;
+	std::vector<std::uint8_t> packed;
+	const std::uint8_t* raw = decode;
+	if (size_t(stride) != rowByte) {
+		packed.resize(size_t(rawSize));
+		for (std::int32_t y = 0; y < height; y++) {
+			std::memcpy(&packed[size_t(y) * rowByte], decode + (size_t(y) * size_t(stride)), rowByte);
+		}
+		raw = packed.data();
+	}
+
+	//圧縮(元より小さくならない場合は圧縮しない)
+	std::vector<std::uint8_t> pack;
+	const std::uint8_t* stored = raw;
+	size_t storedSize = size_t(rawSize);
+	std::uint16_t flag = 0;
+	if (this->isPack_) {
+		pack.resize(size_t(rawSize));
+		const size_t packSize = packLz4(raw, size_t(rawSize), pack.data(), pack.size());
+		if ((packSize > 0) && (packSize < size_t(rawSize))) {
+			stored = pack.data();
+			storedSize = packSize;
+			flag |= FLAG_PACKED;
+		}
+	}
+
+	//ヘッダ作成
+	std::uint8_t header[HEADER_SIZE] = {};
+	std::memcpy(&header[HEADER_MAGIC_OFS], MAGIC, sizeof(MAGIC));
+	fw::ByteWriter::write2ByteLe(&header[HEADER_VERSION_OFS], VERSION);
+	fw::ByteWriter::write2ByteLe(&header[HEADER_FLAG_OFS], flag);
+	fw::ByteWriter::write4ByteLe(&header[HEADER_WIDTH_OFS], std::uint32_t(width));
+	fw::ByteWriter::write4ByteLe(&header[HEADER_HEIGHT_OFS], std::uint32_t(height));
+	fw::ByteWriter::write4ByteLe(&header[HEADER_SRCSIZE_OFS], key.srcSize_);
+	fw::ByteWriter::write4ByteLe(&header[HEADER_CHECK_OFS], key.check_);
+	fw::ByteWriter::write8ByteLe(&header[HEADER_KEY_OFS], key.hash_);
+
+	//一時ファイルへ書き込み(他スレッドと重ならないように連番を付ける)
+	const std::string filePath = this->getFilePath(key.hash_);
+	const std::string tempPath = filePath + "." + std::to_string(this->tempCount_.fetch_add(1)) + ".tmp";
+	bool isWritten = false;
+	{
+		File file;
+		(void)file.create(tempPath);
+		if (file.open("wb")) {
+			isWritten = (file.write(header, HEADER_SIZE) && file.write(stored, storedSize));
+		}
+	}
+	if (!isWritten) {
+		(void)std::remove(tempPath.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex_);
+
+	//上限を超えないように古いキャッシュファイルを削除
+	const std::uint32_t fileSize = std::uint32_t(HEADER_SIZE + storedSize);
+	auto itr = this->entryList_.find(key.hash_);
+	if (itr != this->entryList_.end()) {
+		//同じキーを他スレッドが登録済み(置き換える)
+		this->usedByte_ -= itr->second.fileSize_;
+		this->entryList_.erase(itr);
+	}
+	this->trim(fileSize);
+
+	//一時ファイルをキャッシュファイルへ置き換え
+	if (!replaceFile(tempPath, filePath)) {
+		(void)std::remove(tempPath.c_str());
+		this->saveIndex();
+		return false;
+	}
+
+	CacheEntry entry;
+	entry.fileSize_ = fileSize;
+	entry.lastUse_ = ++this->useCount_;
+	this->entryList_[key.hash_] = entry;
+	this->usedByte_ += fileSize;
+
+	//索引保存(異常終了しても管理外のキャッシュファイルが残らないように毎回保存)
+	this->saveIndex();
+
+	return true;
+}
+
+//削除
+void fw::DecodeCache::remove(const std::uint64_t key)
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	auto itr = this->entryList_.find(key);
+	if (itr != this->entryList_.end()) {
+		this->usedByte_ -= itr->second.fileSize_;
+		this->entryList_.erase(itr);
+	}
+	(void)std::remove(this->getFilePath(key).c_str());
+	this->saveIndex();
+}
+
+//全て削除
+void fw::DecodeCache::clear()
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	for (auto itr = this->entryList_.begin(); itr != this->entryList_.end(); itr++) {
+		(void)std::remove(this->getFilePath(itr->first).c_str());
+	}
+	this->entryList_.clear();
+	this->usedByte_ = 0;
+	this->saveIndex();
+}
+
+//キャッシュファイルの合計バイト数を取得
+size_t fw::DecodeCache::getUsedByte()
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	return this->usedByte_;
+}
+
+//画像からキーを作成
+fw::DecodeCacheKey fw::DecodeCache::makeKey(const Image& image)
+{
+	HashState state;
+	state.key_ = HASH_PRIME5;
+	state.check_ = HASH_PRIME1;
+	hashValue(&state, image.format_);
+	hashValue(&state, image.isFlip_);
+	hashValue(&state, image.isBlend_);
+	//指定サイズはJPEGの本体のみ参照する(ブレンド画像は本体と同じサイズでデコード)
+	hashImageData(&state, image.body_, (image.format_ == D_IMAGEFORMAT_JPEG));
+	std::uint32_t srcSize = std::uint32_t(std::max(image.body_.dataSize_, 0));
+	if (image.isBlend_ == 1) {
+		hashImageData(&state, image.blend_, false);
+		srcSize += std::uint32_t(std::max(image.blend_.dataSize_, 0));
+	}
+
+	DecodeCacheKey key;
+	key.hash_ = finalizeHash(state.key_);
+	key.check_ = std::uint32_t(finalizeHash(state.check_) >> 32);
+	key.srcSize_ = srcSize;
+	return key;
+}
+
+//圧縮データを展開
+bool fw::DecodeCache::unpack(const std::uint8_t* const data, const size_t dataSize, std::uint8_t* const outData, const size_t outSize)
+{
+	const std::uint8_t* ip = data;
+	const std::uint8_t* const ipEnd = data + dataSize;
+	std::uint8_t* op = outData;
+	std::uint8_t* const opEnd = outData + outSize;
+
+	while (ip < ipEnd) {
+		//リテラル
+		const std::uint8_t token = *ip++;
+		size_t literalLength = token >> 4;
+		if ((literalLength == 15) && !readLz4Length(&ip, ipEnd, &literalLength)) {
+			return false;
+		}
+		if ((literalLength > size_t(ipEnd - ip)) || (literalLength > size_t(opEnd - op))) {
+			return false;
+		}
+		std::memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+		if (ip == ipEnd) {
+			//最後のシーケンスはリテラルのみ
+			break;
+		}
+
+		//一致
+		if ((ipEnd - ip) < 2) {
+			return false;
+		}
+		const size_t offset = fw::ByteReader::read2ByteLe(ip);
+		ip += 2;
+		size_t matchLength = token & 0x0F;
+		if ((matchLength == 15) && !readLz4Length(&ip, ipEnd, &matchLength)) {
+			return false;
+		}
+		matchLength += LZ4_MINMATCH;
+		if ((offset == 0) || (offset > size_t(op - outData)) || (matchLength > size_t(opEnd - op))) {
+			return false;
+		}
+		const std::uint8_t* ref = op - offset;
+		if (offset >= matchLength) {
+			std::memcpy(op, ref, matchLength);
+			op += matchLength;
+		}
+		else {
+			//重なりがある場合は先頭から1バイトずつ複写
+			for (size_t i = 0; i < matchLength; i++) {
+				*op++ = *ref++;
+			}
+		}
+	}
+
+	return (op == opEnd);
+}
+
+//キャッシュファイルパスを取得
+std::string fw::DecodeCache::getFilePath(const std::uint64_t key) const
+{
+	char name[32];
+	(void)std::snprintf(name, sizeof(name), "/%08x%08x.rgba", std::uint32_t(key >> 32), std::uint32_t(key));
+	return this->cacheDir_ + name;
+}
+
+//索引読み込み
+void fw::DecodeCache::loadIndex()
+{
+	std::vector<std::uint8_t> index;
+	{
+		File file;
+		(void)file.create(this->cacheDir_ + "/" + INDEX_FILE);
+		if (!file.open("rb") || (file.getFileSize() < INDEX_HEADER_SIZE)) {
+			return;
+		}
+		index.resize(size_t(file.getFileSize()));
+		if (!file.read(index.data(), 0, index.size())) {
+			return;
+		}
+	}
+
+	const std::uint32_t entryNum = fw::ByteReader::read4ByteLe(&index[8]);
+	if ((std::memcmp(&index[0], INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+		|| (fw::ByteReader::read2ByteLe(&index[4]) != VERSION)
+		|| (index.size() != (INDEX_HEADER_SIZE + (size_t(entryNum) * INDEX_ENTRY_SIZE)))) {
+		//不正な索引は無視(キャッシュファイルは次回以降の登録で上書きされる)
+		return;
+	}
+
+	this->useCount_ = fw::ByteReader::read4ByteLe(&index[12]);
+	for (std::uint32_t i = 0; i < entryNum; i++) {
+		const std::uint8_t* const record = &index[INDEX_HEADER_SIZE + (size_t(i) * INDEX_ENTRY_SIZE)];
+		CacheEntry entry;
+		entry.fileSize_ = fw::ByteReader::read4ByteLe(record + 8);
+		entry.lastUse_ = fw::ByteReader::read4ByteLe(record + 12);
+		this->entryList_[fw::ByteReader::read8ByteLe(record)] = entry;
+		this->usedByte_ += entry.fileSize_;
+	}
+}
+
+//索引保存
+void fw::DecodeCache::saveIndex()
+{
+	std::vector<std::uint8_t> index(INDEX_HEADER_SIZE + (this->entryList_.size() * INDEX_ENTRY_SIZE), 0);
+	std::memcpy(&index[0], INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	fw::ByteWriter::write2ByteLe(&index[4], VERSION);
+	fw::ByteWriter::write4ByteLe(&index[8], std::uint32_t(this->entryList_.size()));
+	fw::ByteWriter::write4ByteLe(&index[12], this->useCount_);
+	std::uint8_t* record = &index[INDEX_HEADER_SIZE];
+	for (auto itr = this->entryList_.cbegin(); itr != this->entryList_.cend(); itr++) {
+		fw::ByteWriter::write8ByteLe(record, itr->first);
+		fw::ByteWriter::write4ByteLe(record + 8, itr->second.fileSize_);
+		fw::ByteWriter::write4ByteLe(record + 12, itr->second.lastUse_);
+		record += INDEX_ENTRY_SIZE;
+	}
+
+	//一時ファイルへ書き込んでから置き換え
+	const std::string indexPath = this->cacheDir_ + "/" + INDEX_FILE;
+	const std::string tempPath = indexPath + ".tmp";
+	bool isWritten = false;
+	{
+		File file;
+		(void)file.create(tempPath);
+		isWritten = (file.open("wb") && file.write(index.data(), index.size()));
+	}
+	if (!isWritten || !replaceFile(tempPath, indexPath)) {
+		(void)std::remove(tempPath.c_str());
+		return;
+	}
+	this->isDirty_ = false;
+}
+
+//上限を超えないように古いキャッシュファイルを削除
+void fw::DecodeCache::trim(const size_t addByte)
+{
+	if ((this->usedByte_ + addByte) <= this->maxByte_) {
+		return;
+	}
+
+	//最終参照の古い順
+	std::vector<std::pair<std::uint32_t, std::uint64_t>> order;
+	order.reserve(this->entryList_.size());
+	for (auto itr = this->entryList_.cbegin(); itr != this->entryList_.cend(); itr++) {
+		order.push_back(std::make_pair(itr->second.lastUse_, itr->first));
+	}
+	std::sort(order.begin(), order.end());
+
+	for (auto itr = order.cbegin(); itr != order.cend(); itr++) {
+		if ((this->usedByte_ + addByte) <= this->maxByte_) {
+			break;
+		}
+		const std::string filePath = this->getFilePath(itr->second);
+		if ((std::remove(filePath.c_str()) != 0) && existsFile(filePath)) {
+			//使用中で削除できない(Windowsでマップ中など)は残す
+			continue;
+		}
+		auto entry = this->entryList_.find(itr->second);
+		this->usedByte_ -= entry->second.fileSize_;
+		this->entryList_.erase(entry);
+	}
+	this->isDirty_ = true;
+}
@@ -0,0 +1,122 @@
+﻿#ifndef INCLUDED_DECODECACHE_HPP
+#define INCLUDED_DECODECACHE_HPP
+
+#include "Std.hpp"
+#include "image/Image.hpp"
+#include "io/File.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fw {
+
+	//デコードキャッシュのキー
+	struct DecodeCacheKey {
+		std::uint64_t			hash_;			//画像データとデコード結果が変わる指定のハッシュ(キャッシュファイル名)
+		std::uint32_t			check_;			//照合用のハッシュ(hash_とは別の計算、キャッシュファイルのヘッダで照合)
+		std::uint32_t			srcSize_;		//画像データのバイト数(ブレンド画像を含む合計、ヘッダで照合)
+	};
+
+	//デコードキャッシュから取得したデータ
+	struct DecodeCacheData {
+		std::unique_ptr<File>	file_;			//キャッシュファイル(マップ中、破棄でマップ解除)
+		const std::uint8_t*		data_;			//格納データ(マップ先、書き込み不可)
+		std::int32_t			dataSize_;		//格納データサイズ
+		bool					isPacked_;		//圧縮有無(圧縮ありはunpackで展開する)
+		std::int32_t			width_;			//幅
+		std::int32_t			height_;		//高さ
+	};
+
+	//----------------------------------------------------------
+	//
+	// デコードキャッシュクラス
+	//
+	// デコード済みのRGBA8888画像(1行は幅*4バイト)を画像データの
+	// ハッシュをキーとしてキャッシュフォルダへ保存し、次回以降の
+	// 起動ではデコードせずにマップして参照する。
+	// 画像データが変わるとキーが変わるため古いキャッシュは参照されず、
+	// ファイル名のハッシュが偶然一致しても照合用のハッシュと画像データのバイト数で別画像と判定する。
+	// 合計サイズが上限を超えると最も長く参照されていないものから削除する。
+	// 複数スレッドから使用可能。数値は全てリトルエンディアン。
+	//
+	//  キャッシュファイル(<キー16桁>.rgba)
+	//    0: 識別子"FWDC"  4: バージョン(2byte)  6: フラグ(2byte、bit0:圧縮あり)
+	//    8: 幅(4byte)  12: 高さ(4byte)  16: 画像データのバイト数(4byte)  20: 照合用のハッシュ(4byte)
+	//   24: キー(8byte)  32: 格納データ(圧縮ありはLZ4ブロック形式、展開後は幅*高さ*4バイト)
+	//  索引ファイル(index.bin)
+	//    0: 識別子"FWDI"  4: バージョン(2byte)  8: 件数(4byte)  12: 参照カウンタ(4byte)
+	//   16: キー(8byte)、ファイルサイズ(4byte)、最終参照(4byte)の件数分の繰り返し
+	//
+	//----------------------------------------------------------
+
+	class DecodeCache {
+	public:
+		//識別子
+		static const std::uint8_t MAGIC[4];
+		//バージョン(デコード結果が変わる修正をした場合は更新し、既存のキャッシュを無効にする)
+		static const std::uint16_t VERSION = 3;
+		//キャッシュファイルのヘッダサイズ
+		static const std::uint32_t HEADER_SIZE = 32;
+		//既定のキャッシュ上限バイト数
+		static const size_t DEFAULT_MAX_BYTE = 256 * 1024 * 1024;
+
+	private:
+		//キャッシュファイル情報
+		struct CacheEntry {
+			std::uint32_t	fileSize_;		//ファイルサイズ
+			std::uint32_t	lastUse_;		//最終参照
+		};
+
+		//メンバ変数
+		std::mutex										mutex_;			//排他
+		std::string										cacheDir_;		//キャッシュフォルダ
+		size_t											maxByte_;		//キャッシュ上限バイト数
+		bool											isPack_;		//圧縮して保存するか
+		std::unordered_map<std::uint64_t, CacheEntry>	entryList_;		//キャッシュファイル一覧
+		size_t											usedByte_;		//キャッシュファイルの合計バイト数
+		std::uint32_t									useCount_;		//参照カウンタ
+		bool											isDirty_;		//索引の未保存変更有無
+		std::atomic<std::uint32_t>						tempCount_;		//一時ファイル名の連番
+
+	public:
+		//コンストラクタ(キャッシュフォルダがない場合は作成する)
+		DecodeCache(const std::string& cacheDir, const size_t maxByte = DEFAULT_MAX_BYTE, const bool isPack = false);
+		//デストラクタ(索引を保存する)
+		~DecodeCache();
+		//検索(見つかった場合はキャッシュファイルをマップして返す)
+		//ヘッダが不正なキャッシュファイルは削除し、見つからない扱いとする
+		bool find(const DecodeCacheKey& key, DecodeCacheData* const data);
+		//登録(上限を超える場合は古いキャッシュファイルを削除する)
+		bool store(const DecodeCacheKey& key, const std::uint8_t* const decode, const std::int32_t width, const std::int32_t height, const std::int32_t stride);
+		//削除
+		void remove(const std::uint64_t key);
+		//全て削除
+		void clear();
+		//キャッシュファイルの合計バイト数を取得
+		size_t getUsedByte();
+
+		//画像からキーを作成(画像データとデコード結果が変わる指定のハッシュ)
+		static DecodeCacheKey makeKey(const Image& image);
+		//圧縮データを展開(outSizeは展開後サイズ、不正なデータはfalse)
+		static bool unpack(const std::uint8_t* const data, const size_t dataSize, std::uint8_t* const outData, const size_t outSize);
+
+		//コピーコンストラクタ(禁止)
+		DecodeCache(const DecodeCache& org) = delete;
+		//代入演算子(禁止)
+		DecodeCache& operator=(const DecodeCache& org) = delete;
+
+	private:
+		//キャッシュファイルパスを取得
+		std::string getFilePath(const std::uint64_t key) const;
+		//索引読み込み
+		void loadIndex();
+		//索引保存
+		void saveIndex();
+		//上限を超えないように古いキャッシュファイルを削除
+		void trim(const size_t addByte);
+	};
+}
+
+#endif //INCLUDED_DECODECACHE_HPP
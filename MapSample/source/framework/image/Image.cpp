@@ -1,6 +1,16 @@
 ﻿#include "Image.hpp"
-
+#include "PalleteExpander.hpp"
+#include "PixelConv.hpp"
+#include "ImageBufferPool.hpp"
+#include "DecodeCache.hpp"
+#include "ThreadPool.hpp"
+#include "io/ByteIO.hpp"
+#include "io/FileStream.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 #include <png.h>
 #include <pngstruct.h>
 #include <jpeglib.h>
@@ -16,6 +26,17 @@ namespace {
 	//RGBA8888画像の1ピクセルあたりのバイト数
 	static const std::uint32_t BYTE_PER_PIXEL_RGBA8888 = 4;
 
+	//差し替えパレットの1パレットあたりのバイト数(R,G,B,A)
+	static const std::int32_t BYTE_PER_CHG_PALLETE = 4;
+
+	//後処理(ブレンド画像の合成、フォーマット変換)を行単位で並列に行う最小画素数(これ未満は1スレッドで処理)
+	static const std::int32_t POSTPROC_BAND_MIN_PIXEL = 1024 * 1024;
+	//並列処理時の1スレッドあたりの最小行数
+	static const std::int32_t POSTPROC_BAND_MIN_ROW = 64;
+
+	//デコードキャッシュ(未設定はnullptr)
+	static std::atomic<fw::DecodeCache*> gDecodeCache(nullptr);
+
 	//カラー構造体
 	struct Color {
 		std::uint8_t	r;
@@ -24,42 +45,62 @@ namespace {
 	};
 
 
+	//デコード後のサイズ(RGBA8888)を取得(大きすぎる場合は0)
+	static std::int32_t calcDecodeSize(const std::int32_t width, const std::int32_t height)
+	{
+		const std::int64_t size = std::int64_t(width) * height * BYTE_PER_PIXEL_RGBA8888;
+		if ((width <= 0) || (height <= 0) || (size > INT32_MAX)) {
+			return 0;
+		}
+		return std::int32_t(size);
+	}
+
+	//入力ストリームを指定した画像か
+	static bool isStreamImage(const fw::Image& image)
+	{
+		return (image.body_.stream_ != nullptr) || ((image.isBlend_ == 1) && (image.blend_.stream_ != nullptr));
+	}
+
 	//----------------------------------------------------------
 	//
-	// バイナリ操作メソッド群
+	// メモリ入力クラス
+	//
+	// ヘッダ解析でメモリ上のデータを入力ストリームと同じ操作で先頭から読む。
 	//
 	//----------------------------------------------------------
+	class MemoryReader {
+	private:
+		const std::uint8_t*	data_;		//未読データの先頭
+		size_t				size_;		//未読データのバイト数
 
-	class ByteReader {
 	public:
-		//1バイトを読み込み(LE)
-		static void read1ByteLe(const std::uint8_t* const data, uint8_t* const readData)
+		//コンストラクタ
+		MemoryReader(const std::uint8_t* const data, const size_t size) :
+			data_(data), size_((data != nullptr) ? size : 0)
 		{
-			*readData = *(data + 0);
 		}
 
-		//2バイトを読み込み(LE)
-		static void read2ByteLe(const std::uint8_t* const data, uint16_t* const readData)
+		//sizeバイトをdataへ読み込む(足りない場合はfalse)
+		bool read(std::uint8_t* const data, const size_t size)
 		{
-			*readData = 0;
-			uint16_t v1 = uint16_t(*(data + 0));
-			*readData |= v1 << 0;
-			uint16_t v2 = uint16_t(*(data + 1));
-			*readData |= v2 << 8;
+			if (size > this->size_) {
+				this->skip(this->size_);
+				return false;
+			}
+			(void)memcpy(data, this->data_, size);
+			this->data_ += size;
+			this->size_ -= size;
+			return true;
 		}
 
-		//4バイトを読み込み(LE)
-		static void read4ByteLe(const std::uint8_t* const data, uint32_t* const readData)
+		//sizeバイト読み飛ばす(範囲を超える場合はfalse)
+		bool skip(const std::uint64_t size)
 		{
-			*readData = 0;
-			uint32_t v1 = uint32_t(*(data + 0));
-			*readData |= v1 << 0;
-			uint32_t v2 = uint32_t(*(data + 1));
-			*readData |= v2 << 8;
-			uint32_t v3 = uint32_t(*(data + 2));
-			*readData |= v3 << 16;
-			uint32_t v4 = uint32_t(*(data + 3));
-			*readData |= v4 << 24;
+			const bool isValid = (size <= std::uint64_t(this->size_));
+			const size_t skipSize = isValid ? size_t(size) : this->size_;
+			this->data_ += skipSize;
+			this->size_ -= skipSize;
+			return isValid;
 		}
 	};
 
@@ -69,21 +110,39 @@ namespace {
 	//
 	//----------------------------------------------------------
 	class Jpeg : public fw::ImageIF {
+		//1回に読み込む最大行数
+		static const std::int32_t READ_ROW_MAXNUM = 16;
+
+		//入力ストリームの読み込み元(libjpegのデータ読み込み元を拡張)
+		struct StreamSource {
+			struct jpeg_source_mgr	pub;		//libjpegのデータ読み込み元(先頭に置くこと)
+			fw::FileStream*			stream_;	//入力ストリーム
+		};
+
 		//メンバ変数
 		std::uint8_t*	jpegData_;		//JPEGデータ
 		std::int32_t	jpegSize_;		//JPEGデータサイズ
-		std::int32_t	width_;			//画像幅
-		std::int32_t	height_;		//画像高さ
+		fw::FileStream*	stream_;		//入力ストリーム(nullptr以外の場合はJPEGデータの代わりに使用)
+		StreamSource	source_;		//入力ストリームの読み込み元
+		std::int32_t	width_;			//画像幅(指定サイズがあればそのサイズ)
+		std::int32_t	height_;		//画像高さ(指定サイズがあればそのサイズ)
+		std::int32_t	outputWidth_;	//libjpegの出力幅(縮小デコード後)
+		std::int32_t	outputHeight_;	//libjpegの出力高さ(縮小デコード後)
 		std::int32_t	bytePerPixel_;	//ピクセルあたりのバイト数
+		bool			isCrop_;		//範囲指定デコード有無
+		std::int32_t	cropX_;			//範囲指定デコードの左端
+		std::int32_t	cropY_;			//範囲指定デコードの上端
 
 		struct jpeg_decompress_struct	jdecstr;	//JPEGデコード構造
 		struct jpeg_error_mgr			jerr;		//JPEGエラー管理
 
 	public:
 		//コンストラクタ
-		Jpeg(std::uint8_t* const jpegData, const std::int32_t jpegSize) :
-			jpegData_(jpegData), jpegSize_(jpegSize), width_(0), height_(0), bytePerPixel_(0),
-			jdecstr(), jerr()
+		//targetWidth,targetHeightを指定した場合はそのサイズへデコードする(0は縦横比から計算)
+		//streamを指定した場合はJPEGデータの代わりに入力ストリームから読み込む
+		Jpeg(std::uint8_t* const jpegData, const std::int32_t jpegSize, const std::int32_t targetWidth = 0, const std::int32_t targetHeight = 0, fw::FileStream* const stream = nullptr) :
+			jpegData_(jpegData), jpegSize_(jpegSize), stream_(stream), source_(), width_(targetWidth), height_(targetHeight), outputWidth_(0), outputHeight_(0), bytePerPixel_(0),
+			isCrop_(false), cropX_(0), cropY_(0), jdecstr(), jerr()
 		{
 			//初期化処理
 			this->initialize();
@@ -96,6 +155,68 @@ namespace {
 			this->finalize();
 		}
 
+		//ヘッダのみから画像情報を取得(libjpegは使用せずSOFマーカーまで読み飛ばす)
+		//sourceはread,skipを持つ読み込み元(MemoryReader,FileStream)で、APPn等のセグメントは読み込まずに飛ばす
+		template<class T>
+		static bool probe(T* const source, const std::int32_t targetWidth, const std::int32_t targetHeight, fw::ImageInfo* const info)
+		{
+			//SOIマーカー
+			std::uint8_t data[6] = {};
+			if (!source->read(data, 2) || (data[0] != 0xFF) || (data[1] != 0xD8)) {
+				return false;
+			}
+
+			std::uint8_t prev = 0;
+			std::uint8_t marker = 0;
+			while (source->read(&marker, 1)) {
+				if ((prev != 0xFF) || (marker == 0xFF)) {
+					//マーカー間の不正なバイト(libjpegと同様に読み飛ばす)、またはフィルバイト
+					prev = marker;
+					continue;
+				}
+				prev = 0;
+				if ((marker == 0x01) || (marker == 0xD8) || ((marker >= 0xD0) && (marker <= 0xD7))) {
+					//データ長を持たないマーカー
+					continue;
+				}
+				if ((marker == 0xD9) || (marker == 0xDA)) {
+					//SOFより前にEOI,SOS
+					return false;
+				}
+
+				if (!source->read(data, 2)) {
+					return false;
+				}
+				const std::uint16_t length = fw::ByteReader::read2ByteBe(data);
+				if ((marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) && (marker != 0xC8) && (marker != 0xCC)) {
+					//SOFn(精度,高さ,幅,成分数)
+					if ((length < 8) || !source->read(data, 6)) {
+						return false;
+					}
+					std::uint16_t height = 0;
+					std::uint16_t width = 0;
+					fw::ByteReader::read2ByteBe(data + 1, &height);
+					fw::ByteReader::read2ByteBe(data + 3, &width);
+					if ((width == 0) || (height == 0)) {
+						//高さがDNLマーカーで定義される画像は未対応
+						return false;
+					}
+
+					//指定サイズがあればデコード時と同じ規則でデコード後のサイズを計算
+					info->width_ = targetWidth;
+					info->height_ = targetHeight;
+					calcTargetSize(width, height, &info->width_, &info->height_);
+					info->bitDepth_ = std::int32_t(data[0]) * std::int32_t(data[5]);
+					info->hasAlpha_ = false;
+					return true;
+				}
+				if ((length < 2) || !source->skip(length - 2)) {
+					return false;
+				}
+			}
+			return false;
+		}
+
 		//幅高さを取得
 		virtual void getWH(std::int32_t* const width, std::int32_t* const height)
 		{
@@ -103,41 +224,135 @@ namespace {
 			*height = this->height_;
 		}
 
+		//デコードに必要な作業領域のバイト数を取得
+		virtual size_t getWorkSize()
+		{
+			if (!this->isResize()) {
+				//作業領域はlibjpegのメモリプールを使用
+				return 0;
+			}
+			//残りの拡大縮小のため出力サイズ分
+			return size_t(this->outputWidth_) * size_t(this->outputHeight_) * BYTE_PER_PIXEL_RGBA8888;
+		}
+
+		//デコード範囲を設定
+		virtual bool setDecodeArea(const std::AreaI& area)
+		{
+			if (this->isResize()) {
+				//拡大縮小する場合は範囲指定デコード不可
+				return false;
+			}
+
+			//libjpegの出力座標で範囲を指定(縮小デコード後の座標)
+			this->isCrop_ = true;
+			this->cropX_ = area.xmin;
+			this->cropY_ = area.ymin;
+			this->width_ = area.xmax - area.xmin;
+			this->height_ = area.ymax - area.ymin;
+			return true;
+		}
+
 		//RGBA8888画像へデコード
-		virtual void decodeRgba8888(std::uint8_t** const outData)
+		virtual bool decodeRgba8888(std::uint8_t* const outData, const std::int32_t outStride, std::uint8_t* const work)
 		{
 			try {
 				//デコード開始
 				jpeg_start_decompress(&this->jdecstr);
 
-				//画像1行分のバッファを確保
-				std::int32_t rowByte = this->width_ * this->bytePerPixel_;
-				JSAMPARRAY buffer = (*(this->jdecstr.mem->alloc_sarray))((j_common_ptr)&this->jdecstr, JPOOL_IMAGE, rowByte, 1);
-
-				//1行ずつ読み込み
-				while (this->jdecstr.output_scanline < uint32_t(this->height_)) {
-					//1行読み込み
-					jpeg_read_scanlines(&this->jdecstr, buffer, 1);
+				//範囲指定の場合は横方向をiMCU境界に合わせて切り出し、上端まで読み飛ばす
+				std::int32_t skipX = 0;
+				if (this->isCrop_) {
+					JDIMENSION xoffset = JDIMENSION(this->cropX_);
+					JDIMENSION cropWidth = JDIMENSION(this->width_);
+					jpeg_crop_scanline(&this->jdecstr, &xoffset, &cropWidth);
+					skipX = this->cropX_ - std::int32_t(xoffset);
+					if (this->cropY_ > 0) {
+						(void)jpeg_skip_scanlines(&this->jdecstr, JDIMENSION(this->cropY_));
+					}
+				}
 
-					std::int32_t readOffset = 0;
-					std::int32_t writeOffset = (this->jdecstr.output_scanline - 1) * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-					for (int32_t w = 0; w < this->width_; w++) {
-						//出力データへRGBA値を設定
-						(void)memcpy_s((*outData) + writeOffset, this->bytePerPixel_, buffer[0] + readOffset, this->bytePerPixel_);
-						*((*outData) + writeOffset + 3) = 255;
+				//libjpegの出力サイズが指定サイズと異なる場合は作業領域へデコード
+				std::uint8_t* decode = outData;
+				std::int32_t decodeStride = outStride;
+				std::int32_t decodeWidth = this->width_;
+				std::int32_t decodeHeight = this->height_;
+				if (this->isResize()) {
+					decode = work;
+					decodeStride = this->outputWidth_ * BYTE_PER_PIXEL_RGBA8888;
+					decodeWidth = this->outputWidth_;
+					decodeHeight = this->outputHeight_;
+				}
 
-						readOffset += this->bytePerPixel_;
-						writeOffset += BYTE_PER_PIXEL_RGBA8888;
+				//1回に読み込む行数(libjpegの推奨値)
+				const std::int32_t rowNum = std::min(std::max(this->jdecstr.rec_outbuf_height, 1), std::int32_t(READ_ROW_MAXNUM));
+
+				const bool isRgba = this->isRgbaOutput();
+				if (isRgba && (skipX == 0) && (std::int32_t(this->jdecstr.output_width) == decodeWidth)) {
+					//RGBAで出力される場合はデコード先の行へ直接読み込み
+					JSAMPROW rows[READ_ROW_MAXNUM];
+					std::int32_t h = 0;
+					while (h < decodeHeight) {
+						const std::int32_t num = std::min(rowNum, decodeHeight - h);
+						for (std::int32_t i = 0; i < num; i++) {
+							rows[i] = decode + ((h + i) * decodeStride);
+						}
+						h += std::int32_t(jpeg_read_scanlines(&this->jdecstr, rows, JDIMENSION(num)));
+					}
+				}
+				else {
+					//複数行分のバッファを確保
+					std::int32_t rowByte = std::int32_t(this->jdecstr.output_width) * this->bytePerPixel_;
+					JSAMPARRAY buffer = (*(this->jdecstr.mem->alloc_sarray))((j_common_ptr)&this->jdecstr, JPOOL_IMAGE, rowByte, rowNum);
+
+					//出力ピクセルフォーマット(グレーまたはRGB、RGBAはそのままコピー、CMYKはRGBへ変換)
+					const fw::EN_PixelFormat format = (this->bytePerPixel_ == 1) ? fw::D_PIXELFORMAT_GRAY8 : fw::D_PIXELFORMAT_RGB24;
+					const bool isCmyk = (this->jdecstr.out_color_space == JCS_CMYK);
+					const std::int32_t readOffset = skipX * this->bytePerPixel_;
+					const std::int32_t copyByte = decodeWidth * BYTE_PER_PIXEL_RGBA8888;
+
+					std::int32_t h = 0;
+					while (h < decodeHeight) {
+						//複数行読み込み
+						const std::int32_t num = std::min(rowNum, decodeHeight - h);
+						const std::int32_t readNum = std::int32_t(jpeg_read_scanlines(&this->jdecstr, buffer, JDIMENSION(num)));
+
+						//読み込んだ行をRGBA8888へ変換
+						for (std::int32_t i = 0; i < readNum; i++) {
+							std::uint8_t* wp = decode + ((h + i) * decodeStride);
+							if (isRgba) {
+								(void)memcpy_s(wp, copyByte, buffer[i] + readOffset, copyByte);
+							}
+							else if (isCmyk) {
+								convRowCmykToRgba8888(buffer[i] + readOffset, wp, decodeWidth, (this->jdecstr.saw_Adobe_marker != 0));
+							}
+							else {
+								fw::PixelConv::convRowToRgba8888(format, buffer[i] + readOffset, wp, decodeWidth);
+							}
+						}
+						h += readNum;
 					}
 				}
 
+				//範囲より下の行は読み飛ばす
+				if (this->jdecstr.output_scanline < this->jdecstr.output_height) {
+					(void)jpeg_skip_scanlines(&this->jdecstr, this->jdecstr.output_height - this->jdecstr.output_scanline);
+				}
+
 				//デコード終了
 				jpeg_finish_decompress(&this->jdecstr);
+
+				if (this->isResize()) {
+					//縮小デコードで足りない分を拡大縮小
+					fw::PixelConv::resizeRgba8888(decode, this->outputWidth_, this->outputHeight_, decodeStride,
+						outData, this->width_, this->height_, outStride);
+				}
 			}
 			catch (std::exception& e) {
 				//例外を補足
 				printf("%s\n", e.what());
+				return false;
 			}
+			return true;
 		}
 
 	private:
@@ -164,24 +379,223 @@ namespace {
 				jpeg_create_decompress(&this->jdecstr);
 
 				//デコード対象のJPEGデータを設定
-				jpeg_mem_src(&this->jdecstr, this->jpegData_, this->jpegSize_);
+				if (this->stream_ != nullptr) {
+					this->setStreamSource();
+				}
+				else {
+					jpeg_mem_src(&this->jdecstr, this->jpegData_, this->jpegSize_);
+				}
 
 				//ヘッダ読み込み
 				(void)jpeg_read_header(&this->jdecstr, true);
 
+				//指定サイズに応じて縮小率を選択
+				this->selectScale();
+
+#if defined(JCS_ALPHA_EXTENSIONS)
+				//カラー画像はlibjpegでRGBAへ変換して出力(変換処理を1回で済ませる)
+				if ((this->jdecstr.jpeg_color_space == JCS_YCbCr) || (this->jdecstr.jpeg_color_space == JCS_RGB)) {
+					this->jdecstr.out_color_space = JCS_EXT_RGBA;
+				}
+#endif
+				//CMYK,YCCKはCMYKで出力してRGBへ変換(K成分をアルファとして扱わない)
+				if ((this->jdecstr.jpeg_color_space == JCS_CMYK) || (this->jdecstr.jpeg_color_space == JCS_YCCK)) {
+					this->jdecstr.out_color_space = JCS_CMYK;
+				}
+
 				//幅、高さ、ピクセルあたりのバイト数を取得
 				jpeg_calc_output_dimensions(&this->jdecstr);
 
-				this->width_ = this->jdecstr.output_width;
-				this->height_ = this->jdecstr.output_height;
+				this->outputWidth_ = this->jdecstr.output_width;
+				this->outputHeight_ = this->jdecstr.output_height;
 				this->bytePerPixel_ = this->jdecstr.output_components;
+				if (!this->isSupportedOutput()) {
+					//グレー、RGB、RGBA、CMYK以外の色空間は未対応
+					throw std::runtime_error("unsupported JPEG color space");
+				}
+				if ((this->width_ <= 0) || (this->height_ <= 0)) {
+					//指定サイズなし
+					this->width_ = this->outputWidth_;
+					this->height_ = this->outputHeight_;
+				}
 			}
 			catch (std::exception& e) {
 				//例外を補足
 				printf("%s\n", e.what());
+
+				//デコード不可
+				this->width_ = 0;
+				this->height_ = 0;
 			}
 		}
 
+		//入力ストリームを読み込み元に設定
+		void setStreamSource()
+		{
+			this->source_.pub.init_source = callbackInitSource;
+			this->source_.pub.fill_input_buffer = callbackFillInputBuffer;
+			this->source_.pub.skip_input_data = callbackSkipInputData;
+			this->source_.pub.resync_to_restart = jpeg_resync_to_restart;
+			this->source_.pub.term_source = callbackTermSource;
+			this->source_.pub.next_input_byte = nullptr;
+			this->source_.pub.bytes_in_buffer = 0;
+			this->source_.stream_ = this->stream_;
+			this->jdecstr.src = &this->source_.pub;
+		}
+
+		//読み込み開始コールバック(入力ストリームのバッファ内の未読データから参照する)
+		static void callbackInitSource(j_decompress_ptr cinfo)
+		{
+			StreamSource* const source = reinterpret_cast<StreamSource*>(cinfo->src);
+			fw::FileStream* const stream = source->stream_;
+			if (stream->getSize() == 0) {
+				(void)stream->refill();
+			}
+			source->pub.next_input_byte = stream->getData();
+			source->pub.bytes_in_buffer = stream->getSize();
+		}
+
+		//バッファ補充コールバック(libjpegが参照し終えたバッファを入力ストリームから補充)
+		static boolean callbackFillInputBuffer(j_decompress_ptr cinfo)
+		{
+			StreamSource* const source = reinterpret_cast<StreamSource*>(cinfo->src);
+			fw::FileStream* const stream = source->stream_;
+			stream->consume(stream->getSize());
+			if (!stream->refill()) {
+				//データ不足はjpeg_mem_srcと同様にEOIマーカーを補い、読み込めた分までデコードする
+				static const JOCTET EOI_MARKER[2] = { 0xFF, JPEG_EOI };
+				source->pub.next_input_byte = EOI_MARKER;
+				source->pub.bytes_in_buffer = sizeof(EOI_MARKER);
+				return TRUE;
+			}
+			source->pub.next_input_byte = stream->getData();
+			source->pub.bytes_in_buffer = stream->getSize();
+			return TRUE;
+		}
+
+		//読み飛ばしコールバック(バッファを超える分は入力ストリーム上で読み飛ばす)
+		static void callbackSkipInputData(j_decompress_ptr cinfo, long numBytes)
+		{
+			if (numBytes <= 0) {
+				return;
+			}
+			StreamSource* const source = reinterpret_cast<StreamSource*>(cinfo->src);
+			if (size_t(numBytes) <= source->pub.bytes_in_buffer) {
+				source->pub.next_input_byte += numBytes;
+				source->pub.bytes_in_buffer -= size_t(numBytes);
+				return;
+			}
+
+			//バッファを使い切り、残りを読み飛ばす(終端を超えた場合は次の補充でEOIマーカーを返す)
+			fw::FileStream* const stream = source->stream_;
+			const std::uint64_t restBytes = std::uint64_t(numBytes) - source->pub.bytes_in_buffer;
+			stream->consume(stream->getSize());
+			(void)stream->skip(restBytes);
+			source->pub.next_input_byte = stream->getData();
+			source->pub.bytes_in_buffer = stream->getSize();
+		}
+
+		//読み込み終了コールバック
+		static void callbackTermSource(j_decompress_ptr cinfo)
+		{
+			(void)cinfo;
+		}
+
+		//指定サイズに応じて縮小率を選択(jpeg_read_header後に呼ぶこと)
+		void selectScale()
+		{
+			const std::int32_t imageWidth = std::int32_t(this->jdecstr.image_width);
+			const std::int32_t imageHeight = std::int32_t(this->jdecstr.image_height);
+			if ((imageWidth <= 0) || (imageHeight <= 0)) {
+				this->width_ = 0;
+				this->height_ = 0;
+				return;
+			}
+
+			//指定サイズなし(等倍)
+			if ((this->width_ <= 0) && (this->height_ <= 0)) {
+				return;
+			}
+			calcTargetSize(imageWidth, imageHeight, &this->width_, &this->height_);
+
+			//指定サイズを下回らない最小の縮小率(1/8,1/4,1/2)を選択
+			static const std::uint32_t SCALE_DENOM[] = { 8, 4, 2 };
+			for (std::uint32_t denom : SCALE_DENOM) {
+				const std::int32_t scaledWidth = (imageWidth + denom - 1) / denom;
+				const std::int32_t scaledHeight = (imageHeight + denom - 1) / denom;
+				if ((scaledWidth >= this->width_) && (scaledHeight >= this->height_)) {
+					this->jdecstr.scale_num = 1;
+					this->jdecstr.scale_denom = denom;
+					break;
+				}
+			}
+		}
+
+		//デコード後のサイズを計算(指定サイズなしは等倍、片方のみ指定の場合は縦横比から計算)
+		static void calcTargetSize(const std::int32_t imageWidth, const std::int32_t imageHeight, std::int32_t* const width, std::int32_t* const height)
+		{
+			if ((*width > 0) && (*height <= 0)) {
+				*height = std::max(std::int32_t((std::int64_t(imageHeight) * (*width)) / imageWidth), std::int32_t(1));
+			}
+			else if ((*width <= 0) && (*height > 0)) {
+				*width = std::max(std::int32_t((std::int64_t(imageWidth) * (*height)) / imageHeight), std::int32_t(1));
+			}
+			else if ((*width <= 0) && (*height <= 0)) {
+				*width = imageWidth;
+				*height = imageHeight;
+			}
+		}
+
+		//libjpegがRGBAで出力するか
+		bool isRgbaOutput() const
+		{
+#if defined(JCS_ALPHA_EXTENSIONS)
+			return (this->jdecstr.out_color_space == JCS_EXT_RGBA);
+#else
+			return false;
+#endif
+		}
+
+		//RGBA8888へ変換できる出力の色空間か
+		bool isSupportedOutput() const
+		{
+			switch (this->jdecstr.out_color_space) {
+			case JCS_GRAYSCALE:	return (this->bytePerPixel_ == 1);
+			case JCS_RGB:		return (this->bytePerPixel_ == 3);
+			case JCS_CMYK:		return (this->bytePerPixel_ == 4);
+			default:			return this->isRgbaOutput();
+			}
+		}
+
+		//CMYKの1行をRGBA8888へ変換(isInvertはAdobeマーカーありの反転済みCMYKか)
+		static void convRowCmykToRgba8888(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const bool isInvert)
+		{
+			const std::uint8_t* sp = src;
+			std::uint8_t* dp = dst;
+			for (std::int32_t w = 0; w < width; w++) {
+				//R = (255 - C) * (255 - K) / 255(Adobeマーカーありは反転済みで格納値が255 - C)
+				const std::int32_t c = isInvert ? sp[0] : (255 - sp[0]);
+				const std::int32_t m = isInvert ? sp[1] : (255 - sp[1]);
+				const std::int32_t y = isInvert ? sp[2] : (255 - sp[2]);
+				const std::int32_t k = isInvert ? sp[3] : (255 - sp[3]);
+				dp[0] = std::uint8_t(((c * k) + 127) / 255);
+				dp[1] = std::uint8_t(((m * k) + 127) / 255);
+				dp[2] = std::uint8_t(((y * k) + 127) / 255);
+				dp[3] = 255;
+				sp += 4;
+				dp += 4;
+			}
+		}
+
+		//libjpegの出力後に拡大縮小が必要か
+		bool isResize() const
+		{
+			if (this->isCrop_) {
+				return false;
+			}
+			return ((this->outputWidth_ != this->width_) || (this->outputHeight_ != this->height_));
+		}
+
 		//終了処理
 		void finalize()
 		{
@@ -206,22 +620,25 @@ namespace {
 
 		//メンバ変数
 		std::uint8_t*	pngData_;		//PNGデータ
-		std::int32_t	pngSize_;		//PNGデータサイズ
+		std::int32_t	pngSize_;		//PNGデータサイズ(読み込み済み分を除く)
+		fw::FileStream*	stream_;		//入力ストリーム(nullptr以外の場合はPNGデータの代わりに使用)
 		std::int32_t	width_;			//幅
 		std::int32_t	height_;		//高さ
 		std::int32_t	rowByte_;		//行バイト数
 		std::uint8_t	bitDepth_;		//ビット深度
 		std::uint8_t	colorType_;		//カラータイプ
 		std::int16_t	dmy_;
+		const std::uint8_t*	chgPallete_;	//差し替えパレット(差し替えない場合はnullptr)
+		std::int32_t	chgPalleteNum_;	//差し替えパレット数
 
 		png_structp		pngStr_;		//PNG構造ポインタ(解放必要)
 		png_infop		pngInfo_;		//PNG情報ポインタ(解放必要)
 
 	public:
-		//コンストラクタ
-		Png(std::uint8_t* const pngData, const std::int32_t pngSize) :
-			pngData_(pngData), pngSize_(pngSize), width_(0), height_(0), rowByte_(0), bitDepth_(0), colorType_(0),
-			pngStr_(nullptr), pngInfo_(nullptr)
+		//コンストラクタ(streamを指定した場合はPNGデータの代わりに入力ストリームから読み込む)
+		Png(std::uint8_t* const pngData, const std::int32_t pngSize, fw::FileStream* const stream = nullptr) :
+			pngData_(pngData), pngSize_(pngSize), stream_(stream), width_(0), height_(0), rowByte_(0), bitDepth_(0), colorType_(0),
+			chgPallete_(nullptr), chgPalleteNum_(0), pngStr_(nullptr), pngInfo_(nullptr)
 		{
 			//PNG初期化処理
 			this->initialize();
@@ -234,6 +651,87 @@ namespace {
 			this->finalize();
 		}
 
+		//パレットを差し替え(パレット画像のみ、デコード前に設定する)
+		//palleteはR,G,B,Aの4バイトをpalleteNum分
+		void setPallete(const std::uint8_t* const pallete, const std::int32_t palleteNum)
+		{
+			this->chgPallete_ = pallete;
+			this->chgPalleteNum_ = palleteNum;
+		}
+
+		//ヘッダのみから画像情報を取得(libpngは使用せずIHDRとIDATまでのチャンクのみ読む、CRCは確認しない)
+		//sourceはread,skipを持つ読み込み元(MemoryReader,FileStream)で、IHDR以外のチャンクのデータは読み込まずに飛ばす
+		template<class T>
+		static bool probe(T* const source, fw::ImageInfo* const info)
+		{
+			//シグネチャ(8byte)+IHDRチャンク(長さ4byte,タイプ4byte,データ13byte)
+			static const std::uint8_t SIGNATURE[] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+			static const std::int32_t IHDR_OFS = 8;
+			std::uint8_t pngData[IHDR_OFS + 8 + 13] = {};
+			if (!source->read(pngData, sizeof(pngData)) ||
+				(memcmp(pngData, SIGNATURE, sizeof(SIGNATURE)) != 0) || (memcmp(pngData + IHDR_OFS + 4, "IHDR", 4) != 0)) {
+				return false;
+			}
+
+			std::uint32_t width = 0;
+			std::uint32_t height = 0;
+			fw::ByteReader::read4ByteBe(pngData + IHDR_OFS + 8, &width);
+			fw::ByteReader::read4ByteBe(pngData + IHDR_OFS + 12, &height);
+			const std::uint8_t bitDepth = pngData[IHDR_OFS + 16];
+			const std::uint8_t colorType = pngData[IHDR_OFS + 17];
+			if ((width == 0) || (height == 0) || (width > INT32_MAX) || (height > INT32_MAX)) {
+				return false;
+			}
+
+			//カラータイプ毎のチャンネル数(ビット深度の組み合わせも確認)
+			std::int32_t channelNum = 0;
+			bool isValidDepth = ((bitDepth == 8) || (bitDepth == 16));
+			switch (colorType) {
+			case PNG_COLOR_TYPE_GRAY:
+				channelNum = 1;
+				isValidDepth = isValidDepth || (bitDepth == 1) || (bitDepth == 2) || (bitDepth == 4);
+				break;
+			case PNG_COLOR_TYPE_RGB:
+				channelNum = 3;
+				break;
+			case PNG_COLOR_TYPE_PALETTE:
+				channelNum = 1;
+				isValidDepth = (bitDepth == 1) || (bitDepth == 2) || (bitDepth == 4) || (bitDepth == 8);
+				break;
+			case PNG_COLOR_TYPE_GRAY_ALPHA:
+				channelNum = 2;
+				break;
+			case PNG_COLOR_TYPE_RGB_ALPHA:
+				channelNum = 4;
+				break;
+			default:
+				return false;
+			}
+			if (!isValidDepth) {
+				return false;
+			}
+
+			//アルファチャンネルがなければIDATまでにtRNSチャンクがあるか調べる
+			bool hasAlpha = ((colorType & PNG_COLOR_MASK_ALPHA) != 0);
+			//IHDRのCRCから読み飛ばす
+			std::uint8_t chunk[8] = {};
+			std::uint32_t length = 0;
+			while (!hasAlpha && source->skip(std::uint64_t(length) + 4) && source->read(chunk, sizeof(chunk))) {
+				fw::ByteReader::read4ByteBe(chunk, &length);
+				const std::uint8_t* const type = chunk + 4;
+				if ((memcmp(type, "IDAT", 4) == 0) || (memcmp(type, "IEND", 4) == 0)) {
+					break;
+				}
+				hasAlpha = (memcmp(type, "tRNS", 4) == 0);
+			}
+
+			info->width_ = std::int32_t(width);
+			info->height_ = std::int32_t(height);
+			info->bitDepth_ = std::int32_t(bitDepth) * channelNum;
+			info->hasAlpha_ = hasAlpha;
+			return true;
+		}
+
 		//幅高さを取得
 		virtual void getWH(std::int32_t* const width, std::int32_t* const height)
 		{
@@ -241,56 +739,90 @@ namespace {
 			*height = this->height_;
 		}
 
+		//デコードに必要な作業領域のバイト数を取得
+		virtual size_t getWorkSize()
+		{
+			if (this->colorType_ != PNG_COLOR_TYPE_PALETTE) {
+				//デコード先の行へ直接読み込むため不要
+				return 0;
+			}
+
+			//パレット画像はインデックスの行を読み込む領域(インターレースは全行分)
+			const bool isInterlace = (png_get_interlace_type(this->pngStr_, this->pngInfo_) != PNG_INTERLACE_NONE);
+			return size_t(this->rowByte_) * (isInterlace ? size_t(this->height_) : 1);
+		}
+
 		//RGBA8888画像へデコード
 		//***Pngオブジェクト生成毎に1度しか実施できない(2度目以降は必ず失敗する)
-		virtual void decodeRgba8888(std::uint8_t** const outData)
+		virtual bool decodeRgba8888(std::uint8_t* const outData, const std::int32_t outStride, std::uint8_t* const work)
 		{
-			if (this->pngStr_ != nullptr) {
-				//デコード後の画像データを格納するメモリを確保(本関数の最後に解放)
-				png_size_t pngSize = this->height_ * sizeof(png_bytep) + this->height_ * this->rowByte_;
-				png_byte* tmp = new png_byte[pngSize];
-				png_bytepp png = (png_bytepp)tmp;
+			if ((this->pngStr_ == nullptr) || (this->width_ <= 0) || (this->height_ <= 0)) {
+				return false;
+			}
 
-				//png_read_imageには各行へのポインタを渡すため、2次元配列化
-				png_bytep wp = (png_bytep)&png[this->height_];
-				for (std::int32_t h = 0; h < this->height_; h++) {
-					png[h] = wp;
-					wp += this->rowByte_;
+			try {
+				if (this->colorType_ == PNG_COLOR_TYPE_PALETTE) {
+					//パレット画像は展開テーブルでデコード(差し替えパレットがあれば上書き)
+					return this->decodeRgba8888WithPallete(outData, outStride, work);
 				}
 
-				//PNGイメージ読み込み
-				png_read_image(this->pngStr_, png);
+				//全カラータイプをRGBA8888で出力するよう変換を設定
+				const std::int32_t passNum = this->setupTransform();
 
-				switch (this->colorType_) {
-				case PNG_COLOR_TYPE_GRAY:		//0:グレー
-					this->decodeRgba8888FromGrayScalePng(outData, png);
-					break;
-				case PNG_COLOR_TYPE_RGB:		//2:トゥルーカラー
-					this->decodeRgba8888FromTrueColorPng(outData, png);
-					break;
-				case PNG_COLOR_TYPE_PALETTE:	//3:パレット
-					this->decodeRgba8888FromPalletePng(outData, png);
-					break;
-				case PNG_COLOR_TYPE_GRAY_ALPHA:	//4:グレー+アルファ
-					break;
-				case PNG_COLOR_TYPE_RGB_ALPHA:	//6:トゥルーカラー+アルファ
-					break;
-				default:
-					break;
-				};
+				//デコード先の行へ直接読み込み
+				//インターレースはパス毎に同じ行へ重ねて読み込む
+				for (std::int32_t pass = 0; pass < passNum; pass++) {
+					for (std::int32_t h = 0; h < this->height_; h++) {
+						png_read_row(this->pngStr_, outData + (h * outStride), nullptr);
+					}
+				}
 
-				//デコード後の画像データを格納するメモリを解放
-				delete[] png;
+				//残りのチャンクを読み込み
+				png_read_end(this->pngStr_, nullptr);
+			}
+			catch (std::exception& e) {
+				//例外を補足(途中までしか読み込めていない)
+				printf("%s\n", e.what());
+				return false;
 			}
+			return true;
 		}
 
 	private:
 		//PNG読み込みコールバック
 		static void callbackReadPng(png_structp pngStr, png_bytep data, png_size_t length)
 		{
-			png_bytepp buf = (png_bytepp)png_get_io_ptr(pngStr);
-			memcpy_s(data, length, *buf, length);
-			*buf += length;
+			Png* png = (Png*)png_get_io_ptr(pngStr);
+			if (png->stream_ != nullptr) {
+				//入力ストリームから読み込み(バッファが空になった分だけファイルから補充)
+				if (!png->stream_->read(data, length)) {
+					png_error(pngStr, "png stream is truncated");
+				}
+				return;
+			}
+			if (size_t(png->pngSize_) < length) {
+				//データ不足(エラーコールバックで例外を送出)
+				png_error(pngStr, "png data is truncated");
+			}
+			memcpy_s(data, length, png->pngData_, length);
+			png->pngData_ += length;
+			png->pngSize_ -= std::int32_t(length);
+		}
+
+		//PNGエラーコールバック
+		static void callbackErrorPng(png_structp pngStr, png_const_charp msg)
+		{
+			(void)pngStr;
+			//例外を送出
+			throw std::runtime_error(msg);
+		}
+
+		//PNG警告コールバック
+		static void callbackWarningPng(png_structp pngStr, png_const_charp msg)
+		{
+			(void)pngStr;
+			(void)msg;
+			//警告は無視
 		}
 
 		//PNG初期化処理
@@ -298,188 +830,160 @@ namespace {
 		{
 			//PNGシグネチャのチェック
 			png_byte sig[PNG_BYTES_TO_CHECK];
-			(void)memcpy_s(sig, PNG_BYTES_TO_CHECK, this->pngData_, PNG_BYTES_TO_CHECK);
+			if (this->stream_ != nullptr) {
+				if (!this->stream_->read(sig, PNG_BYTES_TO_CHECK)) {
+					//PNG画像でない
+					return;
+				}
+			}
+			else {
+				if ((this->pngData_ == nullptr) || (this->pngSize_ < PNG_BYTES_TO_CHECK)) {
+					//PNG画像でない
+					return;
+				}
+				(void)memcpy_s(sig, PNG_BYTES_TO_CHECK, this->pngData_, PNG_BYTES_TO_CHECK);
+				this->pngData_ += PNG_BYTES_TO_CHECK;
+				this->pngSize_ -= PNG_BYTES_TO_CHECK;
+			}
 			if (png_sig_cmp(sig, 0, PNG_BYTES_TO_CHECK) == 0) {
 				//PNG画像
 
-				//PNG構造ポインタ作成
-				this->pngStr_ = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+				//PNG構造ポインタ作成(エラーは例外で通知)
+				this->pngStr_ = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, this->callbackErrorPng, this->callbackWarningPng);
 
 				//PNG情報ポインタ作成
 				this->pngInfo_ = png_create_info_struct(this->pngStr_);
 
-				//シグネチャ読み込み済み
-				png_set_sig_bytes(this->pngStr_, PNG_BYTES_TO_CHECK);
-				this->pngData_ += PNG_BYTES_TO_CHECK;
+				try {
+					//シグネチャ読み込み済み
+					png_set_sig_bytes(this->pngStr_, PNG_BYTES_TO_CHECK);
+
+					//PNG読み込みコールバック関数を登録
+					png_set_read_fn(this->pngStr_, this, this->callbackReadPng);
 
-				//PNG読み込みコールバック関数を登録
-				png_set_read_fn(this->pngStr_, &this->pngData_, this->callbackReadPng);
+					//PNG読み込み
+					png_read_info(this->pngStr_, this->pngInfo_);
 
-				//PNG読み込み
-				png_read_info(this->pngStr_, this->pngInfo_);
+					//IHDRチャンクの各種情報取得
+					this->height_ = png_get_image_height(this->pngStr_, this->pngInfo_);
+					this->width_ = png_get_image_width(this->pngStr_, this->pngInfo_);
+					this->rowByte_ = int32_t(png_get_rowbytes(this->pngStr_, this->pngInfo_));
+					this->bitDepth_ = png_get_bit_depth(this->pngStr_, this->pngInfo_);
+					this->colorType_ = png_get_color_type(this->pngStr_, this->pngInfo_);
+				}
+				catch (std::exception& e) {
+					//例外を補足
+					printf("%s\n", e.what());
 
-				//IHDRチャンクの各種情報取得
-				this->height_ = png_get_image_height(this->pngStr_, this->pngInfo_);
-				this->width_ = png_get_image_width(this->pngStr_, this->pngInfo_);
-				this->rowByte_ = int32_t(png_get_rowbytes(this->pngStr_, this->pngInfo_));
-				this->bitDepth_ = png_get_bit_depth(this->pngStr_, this->pngInfo_);
-				this->colorType_ = png_get_color_type(this->pngStr_, this->pngInfo_);
+					//デコード不可
+					this->width_ = 0;
+					this->height_ = 0;
+				}
 			}
 			else {
 				//PNG画像でない
 			}
 		}
 
-		//PNG終了処理
-		void finalize()
+		//RGBA8888で出力する変換を設定(読み込みパス数を返す)
+		std::int32_t setupTransform()
 		{
-			if (this->pngInfo_ != nullptr) {
-				png_destroy_info_struct(this->pngStr_, &this->pngInfo_);
+			//1,2,4bitグレー→8bit、tRNSチャンク→アルファ(パレット画像はdecodeRgba8888WithPalleteで展開)
+			const bool isTrans = (png_get_valid(this->pngStr_, this->pngInfo_, PNG_INFO_tRNS) != 0);
+			png_set_expand(this->pngStr_);
+			if (isTrans) {
+				png_set_tRNS_to_alpha(this->pngStr_);
 			}
-			if (this->pngStr_ != nullptr) {
-				png_destroy_read_struct(&this->pngStr_, nullptr, nullptr);
+
+			//16bit→8bit
+			if (this->bitDepth_ == 16) {
+				png_set_strip_16(this->pngStr_);
 			}
-		}
 
-		//グレーPNG画像からRGBA8888画像へデコード
-		void decodeRgba8888FromGrayScalePng(std::uint8_t** const outData, const png_bytepp png)
-		{
-			if (this->bitDepth_ <= 8) {
-				//ビット深度が1bit,2bit,4bit,8bitの場合
+			//グレー→RGB
+			if ((this->colorType_ & PNG_COLOR_MASK_COLOR) == 0) {
+				png_set_gray_to_rgb(this->pngStr_);
+			}
 
-				//ビット深度で表現できる最大値
-				png_byte bitMaxValue = (0x01 << this->bitDepth_) - 1;
+			//アルファがない場合は不透明のアルファを追加
+			if (((this->colorType_ & PNG_COLOR_MASK_ALPHA) == 0) && !isTrans) {
+				png_set_add_alpha(this->pngStr_, 0xFF, PNG_FILLER_AFTER);
+			}
 
-				//グレーサンプル値(輝度に応じたグレーカラー取得に必要)
-				png_byte graySample = 255 / bitMaxValue;
+			//インターレースはlibpngで展開
+			const std::int32_t passNum = png_set_interlace_handling(this->pngStr_);
 
-				//出力データへデコード後の画像データを設定
-				for (std::int32_t h = 0; h < this->height_; h++) {
-					//一行ずつ処理
-					png_bytep wp = png[h];
+			//変換後の情報に更新
+			png_read_update_info(this->pngStr_, this->pngInfo_);
+			this->rowByte_ = int32_t(png_get_rowbytes(this->pngStr_, this->pngInfo_));
 
-					//書き込み位置と読み込み位置を初期化
-					std::int32_t writeOffset = h * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-					std::int32_t readOffset = 0;
+			return passNum;
+		}
 
-					//ビット深度に応じたビットオフセット
-					png_int_16 bitOfs = 8 - this->bitDepth_;
+		//パレット画像をRGBA8888画像へデコード
+		//libpngのパレット展開は使わず、PLTE,tRNSチャンク(差し替えパレットがあれば上書き)で作成した展開テーブルでインデックスの行を展開する
+		bool decodeRgba8888WithPallete(std::uint8_t* const outData, const std::int32_t outStride, std::uint8_t* const work)
+		{
+			if (work == nullptr) {
+				return false;
+			}
 
-					for (std::int32_t w = 0; w < this->width_; w++) {
-						//輝度を取得
-						png_byte brightness = (wp[readOffset] >> bitOfs) & bitMaxValue;
-
-						//輝度に応じたグレーカラーを取得
-						png_byte grayColor = graySample * brightness;
-
-						//出力データへRGBA値を設定
-						*((*outData) + writeOffset + 0) = grayColor;
-						*((*outData) + writeOffset + 1) = grayColor;
-						*((*outData) + writeOffset + 2) = grayColor;
-						*((*outData) + writeOffset + 3) = 255;
-
-						//ビットオフセットを更新
-						bitOfs -= this->bitDepth_;
-						if (bitOfs < 0) {
-							//次の読み込み位置に更新
-							bitOfs = 8 - this->bitDepth_;
-							readOffset++;
-						}
-						//書き込み位置を更新
-						writeOffset += BYTE_PER_PIXEL_RGBA8888;
-					}
-				}
+			//PLTE,tRNSチャンクのパレットを差し替えパレットで上書きして展開テーブル化
+			fw::PalleteExpander expander(this->bitDepth_);
+			png_colorp pallete = nullptr;
+			int palleteNum = 0;
+			(void)png_get_PLTE(this->pngStr_, this->pngInfo_, &pallete, &palleteNum);
+			png_bytep alpha = nullptr;
+			int alphaNum = 0;
+			(void)png_get_tRNS(this->pngStr_, this->pngInfo_, &alpha, &alphaNum, nullptr);
+			for (std::int32_t p = 0; p < palleteNum; p++) {
+				const std::uint8_t a = (p < alphaNum) ? alpha[p] : 255;
+				expander.setColor(p, pallete[p].red, pallete[p].green, pallete[p].blue, a);
 			}
-			else {
-				//ビット深度が1bit,2bit,4bit,8bit以外の場合
-				//ビット深度が16bitの可能性があるが、現状48bitカラーは表現できないので実装しない
-				//16bit以外でここに来た場合は異常
+			const std::int32_t maxNum = std::int32_t(1) << this->bitDepth_;
+			const std::uint8_t* rp = this->chgPallete_;
+			for (std::int32_t p = 0; (p < this->chgPalleteNum_) && (p < maxNum); p++) {
+				expander.setColor(p, rp[0], rp[1], rp[2], rp[3]);
+				rp += BYTE_PER_CHG_PALLETE;
 			}
-		}
+			expander.build();
 
-		//トゥルーカラーPNG画像からRGBA8888画像へデコード
-		void decodeRgba8888FromTrueColorPng(std::uint8_t** const outData, const png_bytepp png)
-		{
-			if (this->bitDepth_ == 8) {
-				//ビット深度が8bitの場合
+			//インデックスのまま読み込む(インターレースはlibpngで展開)
+			const std::int32_t passNum = png_set_interlace_handling(this->pngStr_);
+			png_read_update_info(this->pngStr_, this->pngInfo_);
 
-				//出力データへデコード後の画像データを設定
+			if (passNum <= 1) {
+				//1行ずつ読み込んで展開
 				for (std::int32_t h = 0; h < this->height_; h++) {
-					//一行ずつ処理
-					png_bytep wp = png[h];
-
-					//書き込み位置と読み込み位置を初期化
-					std::int32_t writeOffset = h * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-					std::int32_t readOffset = 0;
-
-					for (std::int32_t w = 0; w < this->width_; w++) {
-						//出力データへRGBA値を設定
-						*((*outData) + writeOffset + 0) = wp[readOffset + 0];
-						*((*outData) + writeOffset + 1) = wp[readOffset + 1];
-						*((*outData) + writeOffset + 2) = wp[readOffset + 2];
-						*((*outData) + writeOffset + 3) = 255;
-
-						//書き込み位置を更新
-						writeOffset += BYTE_PER_PIXEL_RGBA8888;
-						readOffset += 3;
-					}
+					png_read_row(this->pngStr_, work, nullptr);
+					expander.expandRow(work, outData + (h * outStride), this->width_);
 				}
 			}
 			else {
-				//ビット深度が8bit以外は何もしない
-				//ビット深度が16bitの可能性があるが、現状48bitカラーは表現できないので実装しない
-				//16bit以外でここに来た場合は異常
+				//全パスを読み込んでから展開
+				for (std::int32_t pass = 0; pass < passNum; pass++) {
+					for (std::int32_t h = 0; h < this->height_; h++) {
+						png_read_row(this->pngStr_, work + (h * this->rowByte_), nullptr);
+					}
+				}
+				for (std::int32_t h = 0; h < this->height_; h++) {
+					expander.expandRow(work + (h * this->rowByte_), outData + (h * outStride), this->width_);
+				}
 			}
+
+			//残りのチャンクを読み込み
+			png_read_end(this->pngStr_, nullptr);
+			return true;
 		}
 
-		//パレットPNG画像からRGBA8888画像へデコード
-		void decodeRgba8888FromPalletePng(std::uint8_t** const outData, const png_bytepp png)
+		//PNG終了処理
+		void finalize()
 		{
-			//PLTEチャンク読み込み
-			png_colorp pallete = nullptr;
-			std::int32_t palleteNum = 0;
-			png_get_PLTE(this->pngStr_, this->pngInfo_, &pallete, &palleteNum);
-
-			if ((pallete != nullptr) && (palleteNum > 0)) {
-				//パレットデータ取得成功
-
-				//出力データへデコード後の画像データを設定
-				for (std::int32_t h = 0; h < this->height_; h++) {
-					//一行ずつ処理
-					png_bytep wp = png[h];
-
-					//書き込み位置と読み込み位置を初期化
-					std::int32_t writeOffset = h * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-					std::int32_t readOffset = 0;
-
-					//ビット深度に応じたビットオフセットとビットマスク
-					png_int_16 bitOfs = 8 - this->bitDepth_;
-					png_byte bitMask = (0x01 << this->bitDepth_) - 1;
-
-					for (std::int32_t w = 0; w < this->width_; w++) {
-						//画像データはパレットインデックス
-						png_byte palleteIndex = (wp[readOffset] >> bitOfs) & bitMask;
-
-						//出力データへRGBA値を設定
-						*((*outData) + writeOffset + 0) = pallete[palleteIndex].red;
-						*((*outData) + writeOffset + 1) = pallete[palleteIndex].green;
-						*((*outData) + writeOffset + 2) = pallete[palleteIndex].blue;
-						*((*outData) + writeOffset + 3) = 255;
-
-						//ビットオフセットを更新
-						bitOfs -= this->bitDepth_;
-						if (bitOfs < 0) {
-							//次の読み込み位置に更新
-							bitOfs = 8 - this->bitDepth_;
-							readOffset++;
-						}
-						//書き込み位置を更新
-						writeOffset += BYTE_PER_PIXEL_RGBA8888;
-					}
-				}
+			if (this->pngInfo_ != nullptr) {
+				png_destroy_info_struct(this->pngStr_, &this->pngInfo_);
 			}
-			else {
-				//パレットデータ取得失敗
+			if (this->pngStr_ != nullptr) {
+				png_destroy_read_struct(&this->pngStr_, nullptr, nullptr);
 			}
 		}
 	};	//Png
@@ -493,7 +997,7 @@ namespace {
 	//----------------------------------------------------------
 	class Bitmap : public fw::ImageIF {
 
-		static const std::uint32_t PALLETE_MAXNUM = 256;	//パレット最大数(256色)
+		static const std::int32_t PALLETE_MAXNUM = fw::PalleteExpander::PALLETE_MAXNUM;	//パレット最大数(256色)
 
 		//Bitmapファイルヘッダ(Windows,OS/2共通)
 		static const std::int16_t BFH_HEADERSIZE = 14;
@@ -517,6 +1021,15 @@ namespace {
 		static const std::int16_t BIH_PALLETENUM_OFS = 46;	//パレット数[使用色数]
 		static const std::int16_t BIH_IMPCOLORNUM_OFS = 50;	//重要色数
 		static const std::int16_t BIH_PALLETE_OFS = 54;		//パレット
+		static const std::int16_t BIH_REDMASK_OFS = 54;		//赤マスク(ビットフィールド)
+		static const std::int16_t BIH_GREENMASK_OFS = 58;	//緑マスク(ビットフィールド)
+		static const std::int16_t BIH_BLUEMASK_OFS = 62;	//青マスク(ビットフィールド)
+		static const std::int16_t BIH_ALPHAMASK_OFS = 66;	//アルファマスク(V3以降の情報ヘッダのみ)
+
+		//Bitmap情報ヘッダ(Windows V2以降、先頭はBitmap情報ヘッダと同じ)
+		static const std::int16_t BIH_V2_HEADERSIZE = 52;	//ヘッダ内にRGBマスクを含む
+		static const std::int16_t BIH_V3_HEADERSIZE = 56;	//ヘッダ内にRGBAマスクを含む
+		static const std::int16_t BIH_MASKSIZE = 12;		//情報ヘッダ後のRGBマスクサイズ(BITFIELDS)
 
 		//Bitmapコアヘッダ(OS/2)
 		static const std::int16_t BCH_HEADERSIZE = 12;
@@ -533,6 +1046,27 @@ namespace {
 		static const std::uint32_t COMPRESSION_BI_RLE4 = 2;			//ランレングス圧縮[4bpp]
 		static const std::uint32_t COMPRESSION_BI_BITFIELDS = 3;	//ビットフィールド
 
+		//ビットフィールドの色成分
+		enum EN_BitFieldColor {
+			D_BITFIELD_RED,
+			D_BITFIELD_GREEN,
+			D_BITFIELD_BLUE,
+			D_BITFIELD_ALPHA,
+			D_BITFIELD_NUM,
+		};
+
+		//ビットフィールドの1色成分(マスクからシフト量と8bitへの拡大テーブルを事前計算)
+		struct BitField {
+			std::int32_t	shift_;			//右シフト量(8bitを超える下位ビットも切り捨て)
+			std::uint32_t	mask_;			//シフト後のマスク(最大8bit)
+			std::uint8_t	table_[256];	//シフト後の値→8bit値
+		};
+
+		//行単位の並列デコードを行う最小画素数(これ未満は1スレッドでデコード)
+		static const std::int32_t BAND_DECODE_MIN_PIXEL = 1024 * 1024;
+		//並列デコード時の1スレッドあたりの最小行数
+		static const std::int32_t BAND_DECODE_MIN_ROW = 32;
+
 		//Bitmapフォーマットタイプ
 		enum EN_BmpFormat {
 			D_BMPFORMAT_INVALID,		//無効
@@ -554,12 +1088,18 @@ namespace {
 		std::int32_t	palleteNum_;	//パレット数
 		std::int32_t	palleteByte_;	//1パレットあたりのバイト数
 		std::int32_t	palleteOffset_;	//パレットまでのオフセット
+		std::int32_t	rowByte_;		//1行のバイト数(パディング含む)
+		bool			isTopDown_;		//上の行から格納されているか(高さが負の場合)
+		std::uint32_t	mask_[D_BITFIELD_NUM];	//ビットフィールドのマスク(16bit,32bitのみ)
+		const std::uint8_t*	chgPallete_;	//差し替えパレット(差し替えない場合はnullptr)
+		std::int32_t	chgPalleteNum_;	//差し替えパレット数
 
 	public:
 		//コンストラクタ
 		Bitmap(std::uint8_t* const bmpData, const std::int32_t bmpSize) :
 			bmpData_(bmpData), bmpSize_(bmpSize), format_(EN_BmpFormat::D_BMPFORMAT_INVALID), fileSize_(0), imageOffset_(0),
-			width_(0), height_(0), bitCount_(0), compression_(0), imageSize_(0), palleteNum_(0), palleteByte_(0), palleteOffset_(0)
+			width_(0), height_(0), bitCount_(0), compression_(0), imageSize_(0), palleteNum_(0), palleteByte_(0), palleteOffset_(0), rowByte_(0),
+			isTopDown_(false), mask_(), chgPallete_(nullptr), chgPalleteNum_(0)
 		{
 			//Bitmapヘッダ読み込み
 			readHeader();
@@ -570,6 +1110,35 @@ namespace {
 		{
 		}
 
+		//パレットを差し替え(パレット画像のみ、デコード前に設定する)
+		//palleteはR,G,B,Aの4バイトをpalleteNum分
+		void setPallete(const std::uint8_t* const pallete, const std::int32_t palleteNum)
+		{
+			this->chgPallete_ = pallete;
+			this->chgPalleteNum_ = palleteNum;
+		}
+
+		//ヘッダから画像情報を取得(ヘッダ読み込みのみでデコードはしない)
+		bool getInfo(fw::ImageInfo* const info) const
+		{
+			if ((this->width_ <= 0) || (this->height_ <= 0)) {
+				return false;
+			}
+
+			info->width_ = this->width_;
+			info->height_ = this->height_;
+			info->bitDepth_ = this->bitCount_;
+			if (this->compression_ == COMPRESSION_BI_BITFIELDS) {
+				//アルファマスクがある場合のみ
+				info->hasAlpha_ = (this->mask_[D_BITFIELD_ALPHA] != 0);
+			}
+			else {
+				//32bit無圧縮は4バイト目をアルファとしてデコードする
+				info->hasAlpha_ = (this->bitCount_ == 32);
+			}
+			return true;
+		}
+
 		//幅高さを取得
 		virtual void getWH(std::int32_t* const width, std::int32_t* const height)
 		{
@@ -577,22 +1146,48 @@ namespace {
 			*height = this->height_;
 		}
 
+		//デコードに必要な作業領域のバイト数を取得
+		virtual size_t getWorkSize()
+		{
+			//Bitmapデータから直接デコードするため不要
+			return 0;
+		}
+
 		//RGBA8888画像へデコード
-		virtual void decodeRgba8888(std::uint8_t** const outData)
+		virtual bool decodeRgba8888(std::uint8_t* const outData, const std::int32_t outStride, std::uint8_t* const work)
 		{
+			(void)work;
+			if ((this->compression_ == COMPRESSION_BI_RLE8) || (this->compression_ == COMPRESSION_BI_RLE4)) {
+				//ランレングス圧縮
+				this->decodeRgba8888FromRleBitmap(outData, outStride);
+				return true;
+			}
+
 			switch (this->bitCount_) {
 			case 1:		//1bit
 			case 4:		//4bit
 			case 8:		//8bit
-				this->decodeRgba8888FromPalleteBitmap(outData);
+				this->decodeRgba8888FromPalleteBitmap(outData, outStride);
 				break;
-			case 24:	//24bit
-			case 32:	//32bit
-				this->decodeRgba8888FromTrueColorBitmap(outData);
+			case 16:	//16bit
+				this->decodeRgba8888FromBitFieldBitmap(outData, outStride);
 				break;
-			default:
+			case 24:	//24bit
+				this->decodeRgba8888FromTrueColorBitmap(outData, outStride);
 				break;
+			case 32:	//32bit
+				if (this->compression_ == COMPRESSION_BI_BITFIELDS) {
+					this->decodeRgba8888FromBitFieldBitmap(outData, outStride);
+				}
+				else {
+					this->decodeRgba8888FromTrueColorBitmap(outData, outStride);
+				}
+				break;
+			default:
+				//未対応のビット数
+				return false;
 			}
+			return true;
 		}
 
 	private:
@@ -602,32 +1197,50 @@ namespace {
 			//ファイルヘッダ読み込み
 
 			//ファイルタイプを取得
+			if ((this->bmpData_ == nullptr) || (this->bmpSize_ < (BIH_HEADERSIZE_OFS + 4))) {
+				//ヘッダ不足
+				return;
+			}
 			std::uint8_t fileType[2];
-			ByteReader::read1ByteLe(this->bmpData_ + BFH_FILETYPE_OFS, &fileType[0]);
-			ByteReader::read1ByteLe(this->bmpData_ + BFH_FILETYPE_OFS + 1, &fileType[1]);
+			fw::ByteReader::read1ByteLe(this->bmpData_ + BFH_FILETYPE_OFS, &fileType[0]);
+			fw::ByteReader::read1ByteLe(this->bmpData_ + BFH_FILETYPE_OFS + 1, &fileType[1]);
 			if ((fileType[0] == 'B') && (fileType[1] == 'M')) {
 				//Bitmap画像
 
 				//ファイルサイズを取得
 				std::uint32_t fileSize = 0;
-				ByteReader::read4ByteLe(this->bmpData_ + BFH_FILESIZE_OFS, &fileSize);
+				fw::ByteReader::read4ByteLe(this->bmpData_ + BFH_FILESIZE_OFS, &fileSize);
 				this->fileSize_ = fileSize;
 
 				//ファイル先頭から画像データまでのオフセットを取得
 				std::uint32_t imageOffset = 0;
-				ByteReader::read4ByteLe(this->bmpData_ + BFH_IMAGEOFS_OFS, &imageOffset);
+				fw::ByteReader::read4ByteLe(this->bmpData_ + BFH_IMAGEOFS_OFS, &imageOffset);
 				this->imageOffset_ = imageOffset;
 
 				//情報ヘッダサイズを取得
 				std::uint32_t infoHeaderSize = 0;
-				ByteReader::read4ByteLe(this->bmpData_ + BIH_HEADERSIZE_OFS, &infoHeaderSize);
+				fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_HEADERSIZE_OFS, &infoHeaderSize);
+
+				//情報ヘッダに必要なサイズ(BITFIELDSの40バイト情報ヘッダのみ後ろのRGBマスクを含む)
+				std::int64_t headerSize = std::int64_t(BIH_HEADERSIZE_OFS) + infoHeaderSize;
+				if ((infoHeaderSize == BIH_HEADERSIZE) && (headerSize <= this->bmpSize_)) {
+					std::uint32_t compression = 0;
+					fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_COMPRESSION_OFS, &compression);
+					if (compression == COMPRESSION_BI_BITFIELDS) {
+						headerSize += BIH_MASKSIZE;
+					}
+				}
 
 				//情報ヘッダサイズに応じてフォーマットタイプを選択
-				if (infoHeaderSize == BIH_HEADERSIZE) {
-					//Windowsフォーマット
+				if (headerSize > this->bmpSize_) {
+					//情報ヘッダ(情報ヘッダ後のRGBマスク含む)不足
+					this->format_ = D_BMPFORMAT_INVALID;
+				}
+				else if ((infoHeaderSize == BIH_HEADERSIZE) || (infoHeaderSize >= BIH_V2_HEADERSIZE)) {
+					//Windowsフォーマット(V2以降の拡張ヘッダを含む)
 					this->format_ = D_BMPFORMAT_WINDOWS;
 					//Bitmap情報ヘッダ(Windows)読み込み
-					this->readInfoHeaderWindows();
+					this->readInfoHeaderWindows(infoHeaderSize);
 				}
 				else if (infoHeaderSize == BCH_HEADERSIZE) {
 					//OS/2フォーマット
@@ -639,6 +1252,16 @@ namespace {
 					//異常
 					this->format_ = D_BMPFORMAT_INVALID;
 				}
+
+				//1行のバイト数(4バイト境界にパディング)
+				this->rowByte_ = std::int32_t((((std::int64_t(this->width_) * this->bitCount_) + 31) / 32) * 4);
+
+				//対応していない形式、データ不足の場合はデコードしない
+				if (!this->isSupported()) {
+					this->format_ = D_BMPFORMAT_INVALID;
+					this->width_ = 0;
+					this->height_ = 0;
+				}
 			}
 			else {
 				//Bitmap画像でない
@@ -646,29 +1269,29 @@ namespace {
 		}
 
 		//Bitmap情報ヘッダ(Windows)読み込み
-		void readInfoHeaderWindows()
+		void readInfoHeaderWindows(const std::uint32_t infoHeaderSize)
 		{
 			//画像の幅と高さを取得
 			std::uint32_t width = 0;
 			std::uint32_t height = 0;
-			ByteReader::read4ByteLe(this->bmpData_ + BIH_WIDTH_OFS, &width);
-			ByteReader::read4ByteLe(this->bmpData_ + BIH_HEIGHT_OFS, &height);
+			fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_WIDTH_OFS, &width);
+			fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_HEIGHT_OFS, &height);
 
 			//色ビット数を取得
 			std::uint16_t bitCount = 0;
-			ByteReader::read2ByteLe(this->bmpData_ + BIH_BITCOUNT_OFS, &bitCount);
+			fw::ByteReader::read2ByteLe(this->bmpData_ + BIH_BITCOUNT_OFS, &bitCount);
 
 			//圧縮形式を取得
 			std::uint32_t compression = 0;
-			ByteReader::read4ByteLe(this->bmpData_ + BIH_COMPRESSION_OFS, &compression);
+			fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_COMPRESSION_OFS, &compression);
 
 			//画像データサイズを取得
 			std::uint32_t imageSize = 0;
-			ByteReader::read4ByteLe(this->bmpData_ + BIH_IMGDATASIZE_OFS, &imageSize);
+			fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_IMGDATASIZE_OFS, &imageSize);
 
 			//パレット数を取得
 			std::uint32_t palleteNum = 0;
-			ByteReader::read4ByteLe(this->bmpData_ + BIH_PALLETENUM_OFS, &palleteNum);
+			fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_PALLETENUM_OFS, &palleteNum);
 			if ((palleteNum == 0) && (bitCount <= 8)) {
 				//パレット数が0かつビット数が8以下の場合は、ビット数からパレット数を計算
 				palleteNum = (1 << bitCount);
@@ -682,7 +1305,34 @@ namespace {
 			this->imageSize_ = int32_t(imageSize);
 			this->palleteNum_ = int32_t(palleteNum);
 			this->palleteByte_ = int32_t(4);
-			this->palleteOffset_ = uint32_t(BIH_PALLETE_OFS);
+			this->palleteOffset_ = int32_t(BFH_HEADERSIZE + infoHeaderSize);
+
+			//高さが負の場合は上の行から格納されている
+			if (this->height_ < 0) {
+				this->isTopDown_ = true;
+				this->height_ = -this->height_;
+			}
+
+			//ビットフィールドのマスクを取得
+			if (this->compression_ == COMPRESSION_BI_BITFIELDS) {
+				fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_REDMASK_OFS, &this->mask_[D_BITFIELD_RED]);
+				fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_GREENMASK_OFS, &this->mask_[D_BITFIELD_GREEN]);
+				fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_BLUEMASK_OFS, &this->mask_[D_BITFIELD_BLUE]);
+				if (infoHeaderSize >= BIH_V3_HEADERSIZE) {
+					//アルファマスクはV3以降の情報ヘッダのみ
+					fw::ByteReader::read4ByteLe(this->bmpData_ + BIH_ALPHAMASK_OFS, &this->mask_[D_BITFIELD_ALPHA]);
+				}
+				if (infoHeaderSize == BIH_HEADERSIZE) {
+					//RGBマスクは情報ヘッダの後ろ
+					this->palleteOffset_ += BIH_MASKSIZE;
+				}
+			}
+			else if (this->bitCount_ == 16) {
+				//16bit無圧縮はRGB555
+				this->mask_[D_BITFIELD_RED] = 0x7C00;
+				this->mask_[D_BITFIELD_GREEN] = 0x03E0;
+				this->mask_[D_BITFIELD_BLUE] = 0x001F;
+			}
 		}
 
 		//Bitmap情報ヘッダ(OS/2)読み込み
@@ -691,12 +1341,12 @@ namespace {
 			//画像の幅と高さを取得
 			std::uint16_t width = 0;
 			std::uint16_t height = 0;
-			ByteReader::read2ByteLe(this->bmpData_ + BCH_WIDTH_OFS, &width);
-			ByteReader::read2ByteLe(this->bmpData_ + BCH_HEIGHT_OFS, &height);
+			fw::ByteReader::read2ByteLe(this->bmpData_ + BCH_WIDTH_OFS, &width);
+			fw::ByteReader::read2ByteLe(this->bmpData_ + BCH_HEIGHT_OFS, &height);
 
 			//色ビット数を取得
 			std::uint16_t bitCount = 0;
-			ByteReader::read2ByteLe(this->bmpData_ + BCH_BITCOUNT_OFS, &bitCount);
+			fw::ByteReader::read2ByteLe(this->bmpData_ + BCH_BITCOUNT_OFS, &bitCount);
 
 			//パレット数を取得
 			std::uint32_t palleteNum = 0;
@@ -716,134 +1366,296 @@ namespace {
 			this->palleteOffset_ = int32_t(BCH_PALLETE_OFS);
 		}
 
-		//パディングバイト数を取得
-		//画像データサイズ = ((((色ビット数 * 画像の幅) + パティング) × 画像の高さ) / 8)から計算
-		std::uint32_t getPaddingByte()
+		//対応している形式か
+		bool isSupported() const
 		{
-			//画像データサイズを取得
-			std::uint32_t imageSize = this->imageSize_;
-			if (imageSize == 0) {
-				imageSize = this->fileSize_ - this->imageOffset_;
+			if ((this->format_ == D_BMPFORMAT_INVALID) || (this->width_ <= 0) || (this->height_ <= 0) || (this->imageOffset_ < 0)) {
+				return false;
+			}
+			if (calcDecodeSize(this->width_, this->height_) <= 0) {
+				//デコード後のサイズが大きすぎる
+				return false;
 			}
 
-			//パディングビット数を計算
-			std::uint32_t paddingBit = ((imageSize * 8) / this->height_) - (this->width_ * this->bitCount_);
+			bool isSupported = false;
+			switch (this->compression_) {
+			case COMPRESSION_BI_RGB:
+				isSupported = ((this->bitCount_ == 1) || (this->bitCount_ == 4) || (this->bitCount_ == 8) ||
+					(this->bitCount_ == 16) || (this->bitCount_ == 24) || (this->bitCount_ == 32));
+				break;
+			case COMPRESSION_BI_RLE8:
+				return ((this->bitCount_ == 8) && !this->isTopDown_ && (this->imageOffset_ < this->bmpSize_));
+			case COMPRESSION_BI_RLE4:
+				return ((this->bitCount_ == 4) && !this->isTopDown_ && (this->imageOffset_ < this->bmpSize_));
+			case COMPRESSION_BI_BITFIELDS:
+				isSupported = ((this->bitCount_ == 16) || (this->bitCount_ == 32));
+				break;
+			default:
+				break;
+			}
+
+			//無圧縮は全行分のデータが必要
+			return (isSupported && ((std::int64_t(this->imageOffset_) + (std::int64_t(this->rowByte_) * this->height_)) <= this->bmpSize_));
+		}
 
-			return paddingBit / 8;
+		//格納順の行番号から出力先の行番号を取得
+		std::int32_t getWriteRow(const std::int32_t h) const
+		{
+			return (this->isTopDown_) ? h : (this->height_ - h - 1);
+		}
+
+		//行を帯状に分割してデコード(画素数が閾値以上の場合のみ並列)
+		template <typename T>
+		void decodeRows(const T& rowTask)
+		{
+			if ((std::int64_t(this->width_) * this->height_) >= BAND_DECODE_MIN_PIXEL) {
+				fw::ThreadPool::getDefault().parallelFor(this->height_, BAND_DECODE_MIN_ROW, rowTask);
+			}
+			else {
+				rowTask(0, this->height_);
+			}
 		}
 
 		//パレットデータを取得
-		void getPalleteData(Color* const pallete)
+		void getPalleteData(fw::PalleteExpander* const expander)
 		{
 			//パレットデータを取得
 			std::uint32_t readOffset = this->palleteOffset_;
-			std::uint32_t writeOffset = 0;
-			for (std::uint16_t p = 0; p < this->palleteNum_; p++) {
+			for (std::int32_t p = 0; (p < this->palleteNum_) && (p < PALLETE_MAXNUM); p++) {
+				if ((readOffset + 3) > std::uint32_t(this->bmpSize_)) {
+					//データ不足
+					break;
+				}
 				//青→緑→赤
-				ByteReader::read1ByteLe(this->bmpData_ + readOffset + 0, &(pallete[writeOffset].b));
-				ByteReader::read1ByteLe(this->bmpData_ + readOffset + 1, &(pallete[writeOffset].g));
-				ByteReader::read1ByteLe(this->bmpData_ + readOffset + 2, &(pallete[writeOffset].r));
+				Color color = {};
+				fw::ByteReader::read1ByteLe(this->bmpData_ + readOffset + 0, &color.b);
+				fw::ByteReader::read1ByteLe(this->bmpData_ + readOffset + 1, &color.g);
+				fw::ByteReader::read1ByteLe(this->bmpData_ + readOffset + 2, &color.r);
+				expander->setColor(p, color.r, color.g, color.b, 255);
 
-				writeOffset++;
-				readOffset += 3;
-				if (this->palleteByte_ == 4) {
-					//palleteByte_が4の場合、予約領域分を読み飛ばし
-					readOffset++;
+				readOffset += this->palleteByte_;
+			}
+
+			//差し替えパレットで上書き(展開テーブルへ直接反映されるためデコード時の負荷は変わらない)
+			if (this->chgPallete_ != nullptr) {
+				const std::int32_t maxNum = std::int32_t(1) << this->bitCount_;
+				const std::uint8_t* rp = this->chgPallete_;
+				for (std::int32_t p = 0; (p < this->chgPalleteNum_) && (p < maxNum) && (p < PALLETE_MAXNUM); p++) {
+					expander->setColor(p, rp[0], rp[1], rp[2], rp[3]);
+					rp += BYTE_PER_CHG_PALLETE;
 				}
 			}
 		}
 
 		//パレットBitmap画像からRGBA8888画像へデコード
-		void decodeRgba8888FromPalleteBitmap(std::uint8_t** const outData)
+		void decodeRgba8888FromPalleteBitmap(std::uint8_t* const outData, const std::int32_t outStride)
 		{
-			//パレットデータを取得
-			Color pallete[PALLETE_MAXNUM] = { 0 };
-			this->getPalleteData(pallete);
+			//パレットデータを取得して展開テーブル化
+			fw::PalleteExpander expander(this->bitCount_);
+			this->getPalleteData(&expander);
+			expander.build();
+
+			//出力データへデコード後の画像データを設定
+			this->decodeRows([this, &expander, outData, outStride](const std::int32_t begin, const std::int32_t end) {
+				std::int32_t readOffset = this->imageOffset_ + (begin * this->rowByte_);
+				for (std::int32_t h = begin; h < end; h++) {
+					//一行ずつ展開
+					std::int32_t writeOffset = this->getWriteRow(h) * outStride;
+					expander.expandRow(this->bmpData_ + readOffset, outData + writeOffset, this->width_);
+					readOffset += this->rowByte_;
+				}
+			});
+		}
 
-			//パディングバイト数を取得
-			std::int32_t paddingByte = this->getPaddingByte();
+		//トゥルーカラーBitmap画像からRGBA8888画像へデコード
+		void decodeRgba8888FromTrueColorBitmap(std::uint8_t* const outData, const std::int32_t outStride)
+		{
+			//画像データはBGR値(32bitの場合はBGRA値)
+			const fw::EN_PixelFormat format = (this->bitCount_ == 32) ? fw::D_PIXELFORMAT_BGRA32 : fw::D_PIXELFORMAT_BGR24;
 
 			//出力データへデコード後の画像データを設定
-			std::int32_t readOffset = this->imageOffset_;
-			for (std::int32_t h = 0; h < this->height_; h++) {
-				//一行ずつ処理
-				std::int32_t writeOffset = (this->height_ - h - 1) * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-
-				//ビット数に応じたビットオフセットとビットマスク
-				std::int32_t bitOfs = 8 - this->bitCount_;
-				std::uint8_t bitMask = (0x01 << this->bitCount_) - 1;
-
-				for (std::int32_t w = 0; w < this->width_; w++) {
-					//画像データはパレットインデックス
-					std::uint8_t index = 0;
-					ByteReader::read1ByteLe(this->bmpData_ + readOffset, &index);
-					std::int32_t palleteOffset = (index >> bitOfs) & bitMask;
-
-					//出力データへRGBA値を設定
-					*((*outData) + writeOffset + 0) = pallete[palleteOffset].r;		//赤
-					*((*outData) + writeOffset + 1) = pallete[palleteOffset].g;		//緑
-					*((*outData) + writeOffset + 2) = pallete[palleteOffset].b;		//青
-					*((*outData) + writeOffset + 3) = 255;
-
-					//ビットオフセットを更新
-					bitOfs -= this->bitCount_;
-					if (bitOfs < 0) {
-						//次の読み込み位置に更新
-						bitOfs = 8 - this->bitCount_;
-						readOffset++;
-					}
-					//書き込み位置を更新
-					writeOffset += BYTE_PER_PIXEL_RGBA8888;
+			this->decodeRows([this, format, outData, outStride](const std::int32_t begin, const std::int32_t end) {
+				std::int32_t readOffset = this->imageOffset_ + (begin * this->rowByte_);
+				for (std::int32_t h = begin; h < end; h++) {
+					//一行ずつ変換
+					std::int32_t writeOffset = this->getWriteRow(h) * outStride;
+					fw::PixelConv::convRowToRgba8888(format, this->bmpData_ + readOffset, outData + writeOffset, this->width_);
+					readOffset += this->rowByte_;
 				}
-				readOffset += paddingByte;
+			});
+		}
+
+		//ビットフィールドの1色成分を作成
+		static void makeBitField(const std::uint32_t mask, const std::uint8_t noMaskValue, BitField* const field)
+		{
+			if (mask == 0) {
+				//マスクなしは固定値
+				field->shift_ = 0;
+				field->mask_ = 0;
+				field->table_[0] = noMaskValue;
+				return;
+			}
+
+			//最下位ビット位置とビット数
+			std::int32_t shift = 0;
+			while (((mask >> shift) & 0x01) == 0) {
+				shift++;
+			}
+			std::int32_t bitNum = 0;
+			while ((shift + bitNum < 32) && (((mask >> (shift + bitNum)) & 0x01) != 0)) {
+				bitNum++;
+			}
+
+			//8bitを超える分は下位ビットを切り捨て
+			if (bitNum > 8) {
+				shift += bitNum - 8;
+				bitNum = 8;
+			}
+			field->shift_ = shift;
+			field->mask_ = (0x01U << bitNum) - 1;
+
+			//8bitへ拡大するテーブル
+			const std::uint32_t maxValue = field->mask_;
+			for (std::uint32_t v = 0; v <= maxValue; v++) {
+				field->table_[v] = std::uint8_t(((v * 255) + (maxValue / 2)) / maxValue);
 			}
 		}
 
-		//トゥルーカラーBitmap画像からRGBA8888画像へデコード
-		void decodeRgba8888FromTrueColorBitmap(std::uint8_t** const outData)
+		//ビットフィールドBitmap画像(16bit,32bit)からRGBA8888画像へデコード
+		void decodeRgba8888FromBitFieldBitmap(std::uint8_t* const outData, const std::int32_t outStride)
 		{
-			//パディングバイト数を取得
-			std::int32_t paddingByte = getPaddingByte();
+			//色成分毎のシフト量と拡大テーブル(アルファのマスクなしは不透明)
+			BitField field[D_BITFIELD_NUM];
+			makeBitField(this->mask_[D_BITFIELD_RED], 0, &field[D_BITFIELD_RED]);
+			makeBitField(this->mask_[D_BITFIELD_GREEN], 0, &field[D_BITFIELD_GREEN]);
+			makeBitField(this->mask_[D_BITFIELD_BLUE], 0, &field[D_BITFIELD_BLUE]);
+			makeBitField(this->mask_[D_BITFIELD_ALPHA], 255, &field[D_BITFIELD_ALPHA]);
+			const BitField& r = field[D_BITFIELD_RED];
+			const BitField& g = field[D_BITFIELD_GREEN];
+			const BitField& b = field[D_BITFIELD_BLUE];
+			const BitField& a = field[D_BITFIELD_ALPHA];
 
 			//出力データへデコード後の画像データを設定
-			std::int32_t readOffset = this->imageOffset_;
-			for (std::int32_t h = 0; h < this->height_; h++) {
-				//一行ずつ処理
-				std::int32_t writeIndex = (this->height_ - h - 1) * this->width_ * BYTE_PER_PIXEL_RGBA8888;
-
-				for (std::int32_t w = 0; w < this->width_; w++) {
-					//画像データはBGR値
-					std::uint8_t b = 255;
-					ByteReader::read1ByteLe(this->bmpData_ + readOffset + 0, &b);
-					std::uint8_t g = 255;
-					ByteReader::read1ByteLe(this->bmpData_ + readOffset + 1, &g);
-					std::uint8_t r = 255;
-					ByteReader::read1ByteLe(this->bmpData_ + readOffset + 2, &r);
-					std::uint8_t a = 255;
-					if (this->bitCount_ == 32) {
-						//ビット数が32bitの場合、A値を読み込み
-						ByteReader::read1ByteLe(this->bmpData_ + readOffset + 3, &a);
-
-						//読み込み位置を更新
-						readOffset++;
+			const bool is16 = (this->bitCount_ == 16);
+			this->decodeRows([this, &r, &g, &b, &a, is16, outData, outStride](const std::int32_t begin, const std::int32_t end) {
+				for (std::int32_t h = begin; h < end; h++) {
+					const std::uint8_t* rp = this->bmpData_ + this->imageOffset_ + (h * this->rowByte_);
+					std::uint8_t* wp = outData + (this->getWriteRow(h) * outStride);
+					for (std::int32_t w = 0; w < this->width_; w++) {
+						//1ピクセル読み込み(LE)
+						std::uint32_t pixel = 0;
+						if (is16) {
+							pixel = std::uint32_t(rp[0]) | (std::uint32_t(rp[1]) << 8);
+							rp += 2;
+						}
+						else {
+							pixel = std::uint32_t(rp[0]) | (std::uint32_t(rp[1]) << 8) | (std::uint32_t(rp[2]) << 16) | (std::uint32_t(rp[3]) << 24);
+							rp += 4;
+						}
+
+						//色成分毎にテーブルで8bitへ拡大
+						wp[0] = r.table_[(pixel >> r.shift_) & r.mask_];
+						wp[1] = g.table_[(pixel >> g.shift_) & g.mask_];
+						wp[2] = b.table_[(pixel >> b.shift_) & b.mask_];
+						wp[3] = a.table_[(pixel >> a.shift_) & a.mask_];
+						wp += BYTE_PER_PIXEL_RGBA8888;
 					}
+				}
+			});
+		}
 
-					//出力データへRGBA値を設定
-					*((*outData) + writeIndex + 0) = r;		//赤
-					*((*outData) + writeIndex + 1) = g;		//緑
-					*((*outData) + writeIndex + 2) = b;		//青
-					*((*outData) + writeIndex + 3) = a;		//アルファ
+		//ランレングス圧縮Bitmap画像(RLE4,RLE8)からRGBA8888画像へデコード
+		//圧縮データで描画されない画素は透明にする
+		void decodeRgba8888FromRleBitmap(std::uint8_t* const outData, const std::int32_t outStride)
+		{
+			//パレットデータを取得
+			fw::PalleteExpander expander(this->bitCount_);
+			this->getPalleteData(&expander);
 
-					//読み込み位置を更新
-					readOffset += 3;
+			//出力先を透明で初期化
+			const std::int32_t rowByte = this->width_ * BYTE_PER_PIXEL_RGBA8888;
+			for (std::int32_t h = 0; h < this->height_; h++) {
+				(void)memset(outData + (h * outStride), 0, rowByte);
+			}
 
-					//書き込み位置を更新
-					writeIndex += BYTE_PER_PIXEL_RGBA8888;
+			const bool isRle4 = (this->compression_ == COMPRESSION_BI_RLE4);
+			const std::uint8_t* rp = this->bmpData_ + this->imageOffset_;
+			const std::uint8_t* const end = this->bmpData_ + this->bmpSize_;
+			std::int32_t x = 0;
+			std::int32_t y = 0;
+			while (((rp + 2) <= end) && (y < this->height_)) {
+				const std::uint8_t count = rp[0];
+				const std::uint8_t value = rp[1];
+				rp += 2;
+
+				std::uint8_t* wp = outData + (this->getWriteRow(y) * outStride);
+				if (count > 0) {
+					//エンコードモード:同じインデックス(RLE4は2つのインデックスを交互)をcount画素
+					const std::uint32_t color0 = expander.getColor(isRle4 ? std::uint8_t(value >> 4) : value);
+					const std::uint32_t color1 = expander.getColor(isRle4 ? std::uint8_t(value & 0x0F) : value);
+					const std::int32_t num = std::min(std::int32_t(count), this->width_ - x);
+					for (std::int32_t i = 0; i < num; i++) {
+						const std::uint32_t color = ((i & 0x01) == 0) ? color0 : color1;
+						(void)memcpy(wp + ((x + i) * BYTE_PER_PIXEL_RGBA8888), &color, BYTE_PER_PIXEL_RGBA8888);
+					}
+					x += std::max(num, std::int32_t(0));
+				}
+				else if (value == 0) {
+					//行末
+					x = 0;
+					y++;
+				}
+				else if (value == 1) {
+					//画像末
+					break;
+				}
+				else if (value == 2) {
+					//位置移動
+					if ((rp + 2) > end) {
+						break;
+					}
+					x += rp[0];
+					y += rp[1];
+					rp += 2;
+				}
+				else {
+					//絶対モード:value画素分のインデックスが続く(2バイト境界にパディング)
+					const std::int32_t byteNum = isRle4 ? ((value + 1) / 2) : value;
+					if ((rp + byteNum) > end) {
+						break;
+					}
+					const std::int32_t num = std::min(std::int32_t(value), this->width_ - x);
+					for (std::int32_t i = 0; i < num; i++) {
+						std::uint8_t index = 0;
+						if (isRle4) {
+							index = ((i & 0x01) == 0) ? std::uint8_t(rp[i / 2] >> 4) : std::uint8_t(rp[i / 2] & 0x0F);
+						}
+						else {
+							index = rp[i];
+						}
+						const std::uint32_t color = expander.getColor(index);
+						(void)memcpy(wp + ((x + i) * BYTE_PER_PIXEL_RGBA8888), &color, BYTE_PER_PIXEL_RGBA8888);
+					}
+					x += std::max(num, std::int32_t(0));
+					rp += (byteNum + 1) & ~0x01;
 				}
-				readOffset += paddingByte;
 			}
 		}
 	};	//Bitmap
+
+	//ヘッダのみから画像情報を取得(PNG,JPEG、sourceはread,skipを持つ読み込み元)
+	template<class T>
+	static bool probeHeader(const fw::Image& image, T* const source, fw::ImageInfo* const info)
+	{
+		if (image.format_ == fw::EN_ImageFormat::D_IMAGEFORMAT_PNG) {
+			return Png::probe(source, info);
+		}
+		if (image.format_ == fw::EN_ImageFormat::D_IMAGEFORMAT_JPEG) {
+			//幅高さの指定があればデコード後のサイズ
+			return Jpeg::probe(source, image.body_.width_, image.body_.height_, info);
+		}
+		return false;
+	}
 }	//namespace
 
 
@@ -856,7 +1668,8 @@ namespace {
 
 //コンストラクタ
 fw::ImageDecorder::ImageDecorder() :
-	decode_(nullptr), decodeSize_(0), width_(0), height_(0)
+	decode_(nullptr), decodeSize_(0), width_(0), height_(0), stride_(0), capacity_(0),
+	format_(D_DECODEFORMAT_RGBA8888), isDither_(false), cacheFile_()
 {
 }
 
@@ -867,55 +1680,56 @@ fw::ImageDecorder::~ImageDecorder()
 	this->init();
 }
 
-//デコード
+//デコード(デコード先はバッファプールから取得)
 std::int32_t fw::ImageDecorder::decode(const Image& image)
 {
-	std::int32_t rc = 0;
-
 	//初期化
 	this->init();
 
-	//デコード
-	fw::ImageIF* bodyIF = nullptr;
-	fw::ImageIF* blendIF = nullptr;
-	if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_BMP) {
-		//BITMAP画像
-		bodyIF = new Bitmap(image.body_.data_, image.body_.dataSize_);
-		if (image.isBlend_ == 1) {
-			blendIF = new Bitmap(image.blend_.data_, image.blend_.dataSize_);
-		}
-	}
-	else if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_PNG) {
-		//PNG画像
-		bodyIF = new Png(image.body_.data_, image.body_.dataSize_);
-		if (image.isBlend_ == 1) {
-			blendIF = new Png(image.blend_.data_, image.blend_.dataSize_);
-		}
-	}
-	else if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_JPEG) {
-		//JPEG画像
-		bodyIF = new Jpeg(image.body_.data_, image.body_.dataSize_);
-		if (image.isBlend_ == 1) {
-			blendIF = new Jpeg(image.blend_.data_, image.blend_.dataSize_);
-		}
-	}
-	else {
-		rc = -1;
+	DecodeCache* const cache = gDecodeCache.load();
+	if ((cache == nullptr) || isStreamImage(image)) {
+		//デコード(入力ストリームはキーを作れないためキャッシュを参照しない)
+		return this->decodeImage(image, nullptr, this->format_, nullptr, 0, 0);
 	}
 
-	if (rc == 0) {
-		//デコード実施
-		this->procDecode(bodyIF, blendIF);
+	//デコードキャッシュを参照(キャッシュはRGBA8888で保持し、取得後にデコード後のフォーマットへ変換)
+	const DecodeCacheKey key = DecodeCache::makeKey(image);
+	if (this->decodeFromCache(cache, key)) {
+		this->convertDecodeData();
+		return D_DECODERESULT_OK;
 	}
 
-	if (bodyIF != nullptr) {
-		delete bodyIF;
+	//デコードしてキャッシュへ登録
+	const std::int32_t rc = this->decodeImage(image, nullptr, D_DECODEFORMAT_RGBA8888, nullptr, 0, 0);
+	if (rc == D_DECODERESULT_OK) {
+		(void)cache->store(key, this->decode_, this->width_, this->height_, this->stride_);
+		this->convertDecodeData();
 	}
-	if (blendIF != nullptr) {
-		delete blendIF;
+	return rc;
+}
+
+//デコード(呼び出し元が用意したデコード先へ出力)
+std::int32_t fw::ImageDecorder::decode(const Image& image, std::uint8_t* const outData, const std::int32_t outStride, const size_t outSize)
+{
+	//初期化
+	this->init();
+
+	if (outData == nullptr) {
+		return D_DECODERESULT_SHORTBUFFER;
 	}
 
-	return rc;
+	//デコード
+	return this->decodeImage(image, nullptr, this->format_, outData, outStride, outSize);
+}
+
+//範囲を指定してデコード
+std::int32_t fw::ImageDecorder::decode(const Image& image, const std::AreaI& area)
+{
+	//初期化
+	this->init();
+
+	//デコード
+	return this->decodeImage(image, &area, this->format_, nullptr, 0, 0);
 }
 
 //デコードデータ取得
@@ -933,43 +1747,485 @@ std::uint8_t* const fw::ImageDecorder::getDecodeData(std::int32_t* const decodeS
 	return this->decode_;
 }
 
+//デコードデータの1行のバイト数を取得
+std::int32_t fw::ImageDecorder::getStride() const
+{
+	return this->stride_;
+}
+
+//デコード後のピクセルフォーマットを設定
+void fw::ImageDecorder::setDecodeFormat(const EN_DecodeFormat format, const bool isDither)
+{
+	this->format_ = format;
+	this->isDither_ = isDither;
+}
+
+//デコード後のピクセルフォーマットを取得
+fw::EN_DecodeFormat fw::ImageDecorder::getDecodeFormat() const
+{
+	return this->format_;
+}
+
+//デコードキャッシュを設定
+void fw::ImageDecorder::setDecodeCache(DecodeCache* const cache)
+{
+	gDecodeCache.store(cache);
+}
+
+//一括デコード(画像毎のfutureを返す)
+std::vector<std::future<fw::ImageDecodeResult>> fw::ImageDecorder::decodeBatch(const std::vector<Image>& images, const EN_DecodeFormat format, const bool isDither)
+{
+	std::vector<std::future<ImageDecodeResult>> futures;
+	futures.reserve(images.size());
+
+	fw::ThreadPool& pool = fw::ThreadPool::getDefault();
+	for (auto itr = images.cbegin(); itr != images.cend(); itr++) {
+		//画像1枚を1タスクとしてワーカースレッドへ登録
+		const Image image = *itr;
+		std::shared_ptr<std::promise<ImageDecodeResult>> promise = std::make_shared<std::promise<ImageDecodeResult>>();
+		futures.push_back(promise->get_future());
+		pool.post([image, promise, format, isDither] {
+			ImageDecodeResult result;
+			result.decorder_.reset(new ImageDecorder());
+			result.decorder_->setDecodeFormat(format, isDither);
+			result.rc_ = result.decorder_->decode(image);
+			promise->set_value(std::move(result));
+		});
+	}
+
+	return futures;
+}
+
+//一括デコード(画像毎にデコード完了コールバックを呼ぶ)
+void fw::ImageDecorder::decodeBatch(const std::vector<Image>& images, const ImageDecodeCallback& callback, const EN_DecodeFormat format, const bool isDither)
+{
+	fw::ThreadPool& pool = fw::ThreadPool::getDefault();
+	for (size_t i = 0; i < images.size(); i++) {
+		//画像1枚を1タスクとしてワーカースレッドへ登録
+		const Image image = images[i];
+		pool.post([i, image, callback, format, isDither] {
+			ImageDecorder decorder;
+			decorder.setDecodeFormat(format, isDither);
+			const std::int32_t rc = decorder.decode(image);
+			callback(i, rc, decorder);
+		});
+	}
+}
+
 //初期化
 void fw::ImageDecorder::init()
 {
-	if (this->decode_ != nullptr) {
-		delete[] this->decode_;
-		this->decode_ = nullptr;
+	if (this->capacity_ > 0) {
+		//プールから取得したデコードデータは返却
+		//(呼び出し元が用意したデコード先は解放しない)
+		ImageBufferPool::getDefault().release(this->decode_, this->capacity_);
 	}
+	this->decode_ = nullptr;
+	this->capacity_ = 0;
+	this->cacheFile_.reset();
 	this->decodeSize_ = int32_t(0);
 	this->width_ = int32_t(0);
 	this->height_ = int32_t(0);
+	this->stride_ = int32_t(0);
+}
+
+//デコードキャッシュから取得
+bool fw::ImageDecorder::decodeFromCache(DecodeCache* const cache, const DecodeCacheKey& key)
+{
+	DecodeCacheData data;
+	if (!cache->find(key, &data)) {
+		return false;
+	}
+
+	const std::int32_t decodeSize = data.width_ * data.height_ * std::int32_t(BYTE_PER_PIXEL_RGBA8888);
+	if (data.isPacked_) {
+		//圧縮ありはプールから取得したデコード先へ展開
+		size_t capacity = 0;
+		std::uint8_t* const decode = ImageBufferPool::getDefault().acquire(size_t(decodeSize), &capacity);
+		if (!DecodeCache::unpack(data.data_, size_t(data.dataSize_), decode, size_t(decodeSize))) {
+			//壊れたキャッシュは削除してデコードし直す
+			ImageBufferPool::getDefault().release(decode, capacity);
+			data.file_.reset();
+			cache->remove(key.hash_);
+			return false;
+		}
+		this->decode_ = decode;
+		this->capacity_ = capacity;
+	}
+	else {
+		//圧縮なしはマップしたキャッシュファイルをそのまま参照
+		this->decode_ = const_cast<std::uint8_t*>(data.data_);
+		this->cacheFile_ = std::move(data.file_);
+	}
+	this->decodeSize_ = decodeSize;
+	this->width_ = data.width_;
+	this->height_ = data.height_;
+	this->stride_ = data.width_ * std::int32_t(BYTE_PER_PIXEL_RGBA8888);
+
+	return true;
+}
+
+//ヘッダのみから画像情報を取得
+fw::ImageInfo fw::ImageDecorder::probe(const Image& image)
+{
+	ImageInfo info = { image.format_, 0, 0, 0, false, 0 };
+
+	bool isValid = false;
+	FileStream* const stream = image.body_.stream_;
+	if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_BMP) {
+		//BITMAP画像(ヘッダ読み込みのみで画素は読まない、入力ストリームは未対応)
+		Bitmap body(image.body_.data_, image.body_.dataSize_);
+		isValid = (stream == nullptr) && body.getInfo(&info);
+	}
+	else if (stream != nullptr) {
+		//入力ストリームはヘッダの終端まで読み進め、デコードのため範囲の先頭へ戻す
+		isValid = probeHeader(image, stream, &info);
+		isValid = stream->rewind() && isValid;
+	}
+	else {
+		MemoryReader reader(image.body_.data_, size_t(std::max(image.body_.dataSize_, std::int32_t(0))));
+		isValid = probeHeader(image, &reader, &info);
+	}
+
+	//デコード後のサイズ(大きすぎる場合はデコード不可)
+	info.decodeSize_ = isValid ? calcDecodeSize(info.width_, info.height_) : 0;
+	if (info.decodeSize_ <= 0) {
+		info.width_ = 0;
+		info.height_ = 0;
+		info.bitDepth_ = 0;
+		info.hasAlpha_ = false;
+	}
+	return info;
+}
+
+//デコード処理(画像フォーマットに応じた処理クラスを生成)
+std::int32_t fw::ImageDecorder::decodeImage(const Image& image, const std::AreaI* const area, const EN_DecodeFormat format, std::uint8_t* const outData, const std::int32_t outStride, const size_t outSize)
+{
+	//画像処理クラスはヒープを使わずスタック上に生成する
+	std::int32_t rc = D_DECODERESULT_OK;
+	if ((image.format_ == EN_ImageFormat::D_IMAGEFORMAT_BMP) && isStreamImage(image)) {
+		//BITMAPは下の行から格納されるため入力ストリームは未対応
+		rc = D_DECODERESULT_INVALID;
+	}
+	else if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_BMP) {
+		//BITMAP画像
+		Bitmap body(image.body_.data_, image.body_.dataSize_);
+		if (image.body_.isChgPallete_ == 1) {
+			body.setPallete(image.body_.pallete_, image.body_.palleteNum_);
+		}
+		if (image.isBlend_ == 1) {
+			Bitmap blend(image.blend_.data_, image.blend_.dataSize_);
+			if (image.blend_.isChgPallete_ == 1) {
+				blend.setPallete(image.blend_.pallete_, image.blend_.palleteNum_);
+			}
+			rc = this->procDecode(&body, &blend, area, format, outData, outStride, outSize);
+		}
+		else {
+			rc = this->procDecode(&body, nullptr, area, format, outData, outStride, outSize);
+		}
+	}
+	else if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_PNG) {
+		//PNG画像
+		Png body(image.body_.data_, image.body_.dataSize_, image.body_.stream_);
+		if (image.body_.isChgPallete_ == 1) {
+			body.setPallete(image.body_.pallete_, image.body_.palleteNum_);
+		}
+		if (image.isBlend_ == 1) {
+			Png blend(image.blend_.data_, image.blend_.dataSize_, image.blend_.stream_);
+			if (image.blend_.isChgPallete_ == 1) {
+				blend.setPallete(image.blend_.pallete_, image.blend_.palleteNum_);
+			}
+			rc = this->procDecode(&body, &blend, area, format, outData, outStride, outSize);
+		}
+		else {
+			rc = this->procDecode(&body, nullptr, area, format, outData, outStride, outSize);
+		}
+	}
+	else if (image.format_ == EN_ImageFormat::D_IMAGEFORMAT_JPEG) {
+		//JPEG画像
+		//幅高さの指定があれば縮小デコード(ブレンド画像は本体と同じサイズにする)
+		Jpeg body(image.body_.data_, image.body_.dataSize_, image.body_.width_, image.body_.height_, image.body_.stream_);
+		if (image.isBlend_ == 1) {
+			Jpeg blend(image.blend_.data_, image.blend_.dataSize_, image.body_.width_, image.body_.height_, image.blend_.stream_);
+			rc = this->procDecode(&body, &blend, area, format, outData, outStride, outSize);
+		}
+		else {
+			rc = this->procDecode(&body, nullptr, area, format, outData, outStride, outSize);
+		}
+	}
+	else {
+		rc = D_DECODERESULT_INVALID;
+	}
+
+	return rc;
 }
 
 //デコード処理実施
-std::int32_t fw::ImageDecorder::procDecode(ImageIF* const bodyIF, ImageIF* const blendIF)
+std::int32_t fw::ImageDecorder::procDecode(ImageIF* const bodyIF, ImageIF* const blendIF, const std::AreaI* const area, const EN_DecodeFormat format, std::uint8_t* const outData, const std::int32_t outStride, const size_t outSize)
 {
 	//本体画像の幅高さを取得
 	std::int32_t width = 0;
 	std::int32_t height = 0;
 	bodyIF->getWH(&width, &height);
-	if ((width > 0) && (height > 0)) {
+	const std::int32_t bodyWidth = width;
+	const std::int32_t bodyHeight = height;
+	if ((width <= 0) || (height <= 0)) {
+		//ヘッダが不正、または未対応の画像
+		return D_DECODERESULT_INVALID;
+	}
 
-		//デコード後データ格納用メモリを確保
-		const std::int32_t decodeSize = width * height * BYTE_PER_PIXEL_RGBA8888;
-		std::uint8_t* decode = new std::uint8_t[decodeSize];
+	//範囲指定の場合は画像内に切り詰めた範囲の幅高さ
+	std::AreaI decodeArea = { 0, 0, width, height };
+	bool isAreaByCopy = false;
+	if (area != nullptr) {
+		decodeArea.xmin = std::max(area->xmin, std::int32_t(0));
+		decodeArea.ymin = std::max(area->ymin, std::int32_t(0));
+		decodeArea.xmax = std::min(area->xmax, width);
+		decodeArea.ymax = std::min(area->ymax, height);
+		if ((decodeArea.xmin >= decodeArea.xmax) || (decodeArea.ymin >= decodeArea.ymax)) {
+			return D_DECODERESULT_INVALID;
+		}
+		width = decodeArea.xmax - decodeArea.xmin;
+		height = decodeArea.ymax - decodeArea.ymin;
+
+		//範囲のみデコードできない画像は全体をデコードして切り出す
+		isAreaByCopy = !bodyIF->setDecodeArea(decodeArea);
+	}
+
+	this->width_ = width;
+	this->height_ = height;
+
+	ImageBufferPool& pool = ImageBufferPool::getDefault();
+	const std::int32_t rgbaRowByte = std::int32_t(width * BYTE_PER_PIXEL_RGBA8888);
+	const std::int32_t rowByte = width * PixelConv::getBytePerPixel(format);
+	std::uint8_t* decode = outData;
+	std::int32_t stride = outStride;
+	std::int32_t decodeSize = 0;
+	if (decode == nullptr) {
+		//デコード後データ格納用メモリをプールから取得
+		//RGBA8888でデコードしてから行毎に変換して先頭へ詰めるため、RGBA8888のサイズで確保する
+		stride = rowByte;
+		decodeSize = stride * height;
+		decode = pool.acquire(size_t(rgbaRowByte) * size_t(height), &this->capacity_);
+	}
+	else {
+		//呼び出し元が用意したデコード先のサイズを確認
+		decodeSize = (stride * (height - 1)) + rowByte;
+		if ((stride < rowByte) || (outSize < size_t(decodeSize))) {
+			//サイズ不足(幅高さのみ設定)
+			return D_DECODERESULT_SHORTBUFFER;
+		}
+	}
+
+	//RGBA8888のデコード先(呼び出し元が用意したデコード先へ変換する場合のみプールから取得)
+	std::uint8_t* rgba = decode;
+	std::int32_t rgbaStride = (outData == nullptr) ? rgbaRowByte : stride;
+	size_t rgbaCapacity = 0;
+	if ((outData != nullptr) && (format != D_DECODEFORMAT_RGBA8888)) {
+		rgbaStride = rgbaRowByte;
+		rgba = pool.acquire(size_t(rgbaStride) * size_t(height), &rgbaCapacity);
+	}
+
+	bool isDecoded = false;
+	if (isAreaByCopy) {
+		//本体画像を全体デコードして範囲を切り出し
+		isDecoded = this->decodeAreaByCopy(bodyIF, decodeArea, rgba, rgbaStride);
+	}
+	else {
+		//作業領域をプールから取得
+		size_t workCapacity = 0;
+		const size_t workSize = bodyIF->getWorkSize();
+		std::uint8_t* work = nullptr;
+		if (workSize > 0) {
+			work = pool.acquire(workSize, &workCapacity);
+		}
 
 		//本体画像をデコード
-		bodyIF->decodeRgba8888(&decode);
+		isDecoded = bodyIF->decodeRgba8888(rgba, rgbaStride, work);
 
-		this->width_ = width;
-		this->height_ = height;
-		this->decodeSize_ = decodeSize;
-		this->decode_ = decode;
+		pool.release(work, workCapacity);
+	}
+
+	//ブレンドあり(本体画像と同じサイズの場合のみ合成)
+	std::uint8_t* blend = nullptr;
+	size_t blendCapacity = 0;
+	if (isDecoded && (blendIF != nullptr)) {
+		std::int32_t blendWidth = 0;
+		std::int32_t blendHeight = 0;
+		blendIF->getWH(&blendWidth, &blendHeight);
+		if ((blendWidth == bodyWidth) && (blendHeight == bodyHeight)) {
+			blend = this->decodeBlend(blendIF, decodeArea, (area != nullptr), &blendCapacity);
+			isDecoded = (blend != nullptr);
+		}
+	}
+
+	if (!isDecoded) {
+		//途中で失敗した場合は未デコードの行が残るためデコードデータを返却
+		if (rgba != decode) {
+			pool.release(rgba, rgbaCapacity);
+		}
+		if (outData == nullptr) {
+			pool.release(decode, this->capacity_);
+			this->capacity_ = 0;
+		}
+		this->width_ = 0;
+		this->height_ = 0;
+		return D_DECODERESULT_INVALID;
+	}
+
+	//ブレンド画像の合成とフォーマット変換
+	this->postProcess(rgba, rgbaStride, blend, decode, stride, width, height, format);
+
+	pool.release(blend, blendCapacity);
+	if (rgba != decode) {
+		pool.release(rgba, rgbaCapacity);
+	}
+
+	this->stride_ = stride;
+	this->decodeSize_ = decodeSize;
+	this->decode_ = decode;
+
+	return D_DECODERESULT_OK;
+}
+
+//ブレンド画像をデコード
+std::uint8_t* fw::ImageDecorder::decodeBlend(ImageIF* const blendIF, const std::AreaI& decodeArea, const bool isArea, size_t* const capacity)
+{
+	const std::int32_t width = decodeArea.xmax - decodeArea.xmin;
+	const std::int32_t height = decodeArea.ymax - decodeArea.ymin;
+
+	//ブレンド画像のデコード先をプールから取得
+	ImageBufferPool& pool = ImageBufferPool::getDefault();
+	const std::int32_t blendStride = width * BYTE_PER_PIXEL_RGBA8888;
+	std::uint8_t* const blend = pool.acquire(size_t(blendStride) * size_t(height), capacity);
+
+	bool isDecoded = false;
+	if (isArea && !blendIF->setDecodeArea(decodeArea)) {
+		//範囲のみデコードできない画像は全体をデコードして切り出す
+		isDecoded = this->decodeAreaByCopy(blendIF, decodeArea, blend, blendStride);
+	}
+	else {
+		size_t workCapacity = 0;
+		const size_t workSize = blendIF->getWorkSize();
+		std::uint8_t* work = nullptr;
+		if (workSize > 0) {
+			work = pool.acquire(workSize, &workCapacity);
+		}
+		isDecoded = blendIF->decodeRgba8888(blend, blendStride, work);
+		pool.release(work, workCapacity);
+	}
+
+	if (!isDecoded) {
+		pool.release(blend, *capacity);
+		*capacity = 0;
+		return nullptr;
+	}
+	return blend;
+}
+
+//ブレンド画像の合成とデコード後のフォーマットへの変換を行単位でまとめて実施
+void fw::ImageDecorder::postProcess(std::uint8_t* const rgba, const std::int32_t rgbaStride, const std::uint8_t* const blend, std::uint8_t* const dst, const std::int32_t dstStride,
+	const std::int32_t width, const std::int32_t height, const EN_DecodeFormat format)
+{
+	const bool isConv = (format != D_DECODEFORMAT_RGBA8888);
+	if ((blend == nullptr) && !isConv) {
+		//後処理なし
+		return;
+	}
+
+	//同じ領域で行を先頭へ詰める場合、並列時は他の帯の未処理の行を上書きしないよう行内で変換してから詰める
+	const bool isParallel = ((std::int64_t(width) * height) >= POSTPROC_BAND_MIN_PIXEL);
+	const bool isCompact = (rgba == dst) && (rgbaStride != dstStride);
+	const std::int32_t convStride = (isParallel && isCompact) ? rgbaStride : dstStride;
+
+	//1行ずつ合成と変換を続けて行い、キャッシュに載っている間に書き換える
+	const std::int32_t blendStride = width * BYTE_PER_PIXEL_RGBA8888;
+	const bool isDither = this->isDither_;
+	const auto rowTask = [rgba, rgbaStride, blend, blendStride, dst, convStride, width, format, isConv, isDither](const std::int32_t begin, const std::int32_t end) {
+		for (std::int32_t h = begin; h < end; h++) {
+			std::uint8_t* const row = rgba + (h * rgbaStride);
+			if (blend != nullptr) {
+				PixelConv::blendRowRgba8888(row, blend + (h * blendStride), width);
+			}
+			if (isConv) {
+				PixelConv::convRowFromRgba8888(format, row, dst + (h * convStride), width, h, isDither);
+			}
+		}
+	};
+	if (isParallel) {
+		fw::ThreadPool::getDefault().parallelFor(height, POSTPROC_BAND_MIN_ROW, rowTask);
+	}
+	else {
+		rowTask(0, height);
+	}
+
+	if (convStride != dstStride) {
+		//変換済みの行を先頭へ詰める
+		const size_t rowByte = size_t(width) * PixelConv::getBytePerPixel(format);
+		for (std::int32_t h = 1; h < height; h++) {
+			(void)memmove(dst + (h * dstStride), rgba + (h * rgbaStride), rowByte);
+		}
+	}
+}
+
+//RGBA8888のデコードデータをデコード後のフォーマットへ変換
+void fw::ImageDecorder::convertDecodeData()
+{
+	if ((this->format_ == D_DECODEFORMAT_RGBA8888) || (this->decode_ == nullptr)) {
+		return;
+	}
+
+	const std::int32_t stride = this->width_ * PixelConv::getBytePerPixel(this->format_);
+	std::uint8_t* dst = this->decode_;
+	size_t capacity = 0;
+	if (this->cacheFile_) {
+		//マップしたキャッシュファイルは書き込み不可のため、プールから取得した領域へ変換
+		dst = ImageBufferPool::getDefault().acquire(size_t(stride) * size_t(this->height_), &capacity);
+	}
+
+	this->postProcess(this->decode_, this->stride_, nullptr, dst, stride, this->width_, this->height_, this->format_);
+
+	if (this->cacheFile_) {
+		this->cacheFile_.reset();
+		this->decode_ = dst;
+		this->capacity_ = capacity;
+	}
+	this->stride_ = stride;
+	this->decodeSize_ = stride * this->height_;
+}
+
+//範囲のみのデコードに対応していない画像を全体デコードして切り出し
+bool fw::ImageDecorder::decodeAreaByCopy(ImageIF* const imageIF, const std::AreaI& area, std::uint8_t* const outData, const std::int32_t outStride)
+{
+	std::int32_t width = 0;
+	std::int32_t height = 0;
+	imageIF->getWH(&width, &height);
+
+	//全体のデコード先と作業領域をプールから取得
+	ImageBufferPool& pool = ImageBufferPool::getDefault();
+	const std::int32_t fullStride = width * BYTE_PER_PIXEL_RGBA8888;
+	size_t fullCapacity = 0;
+	std::uint8_t* full = pool.acquire(size_t(fullStride) * size_t(height), &fullCapacity);
+	size_t workCapacity = 0;
+	const size_t workSize = imageIF->getWorkSize();
+	std::uint8_t* work = nullptr;
+	if (workSize > 0) {
+		work = pool.acquire(workSize, &workCapacity);
+	}
+
+	//全体をデコード
+	const bool isDecoded = imageIF->decodeRgba8888(full, fullStride, work);
 
-		if (blendIF != nullptr) {
-			//ブレンドあり
+	//範囲を1行ずつ切り出し
+	if (isDecoded) {
+		const std::int32_t rowByte = (area.xmax - area.xmin) * BYTE_PER_PIXEL_RGBA8888;
+		for (std::int32_t h = area.ymin; h < area.ymax; h++) {
+			const std::uint8_t* rp = full + (h * fullStride) + (area.xmin * BYTE_PER_PIXEL_RGBA8888);
+			(void)memcpy_s(outData + ((h - area.ymin) * outStride), rowByte, rp, rowByte);
 		}
 	}
 
-	return 0;
+	pool.release(work, workCapacity);
+	pool.release(full, fullCapacity);
+	return isDecoded;
 }
@@ -2,7 +2,11 @@
 #define INCLUDED_IMAGE_HPP
 
 #include "Std.hpp"
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace fw {
 	//画像タイプ
@@ -19,18 +23,32 @@ namespace fw {
 		D_IMAGEFORMAT_JPEG,			//JPEG画像
 	};
 
+	//デコード後のピクセルフォーマット
+	//16bitフォーマットは1ピクセルを2バイトの値(ネイティブエンディアン)として格納し、上位ビットから記載の順に並ぶ
+	enum EN_DecodeFormat : std::uint16_t {
+		D_DECODEFORMAT_RGBA8888,		//RGBA8888(ストレートアルファ、4バイト)
+		D_DECODEFORMAT_RGBA8888_PREMUL,	//RGBA8888(乗算済みアルファ、4バイト)
+		D_DECODEFORMAT_RGB565,			//RGB565(2バイト、アルファは捨てる)
+		D_DECODEFORMAT_RGBA4444,		//RGBA4444(2バイト)
+		D_DECODEFORMAT_RGBA5551,		//RGBA5551(2バイト、アルファは128以上を不透明)
+		D_DECODEFORMAT_A8,				//A8(アルファのみ1バイト)
+	};
+
+	class FileStream;
+
 	//画像
 	struct Image {
 		struct ImageData {
 			std::uint8_t*	data_;			//データ
 			std::int32_t	dataSize_;		//データサイズ
-			std::int32_t	width_;			//幅
-			std::int32_t	height_;		//高さ
+			std::int32_t	width_;			//幅(JPEGのみ、0以外の場合はこの幅へ縮小デコード)
+			std::int32_t	height_;		//高さ(JPEGのみ、0以外の場合はこの高さへ縮小デコード)
 			std::int32_t	transColor_;	//透過色
 			std::uint16_t	isPixelFlip_;	//ピクセル反転有無[0:反転しない 1:反転する]
 			std::uint16_t	isChgPallete_;	//パレット差し替え有無[0:差し替えない 1:差し替える]
-			std::uint8_t*	pallete_;		//パレットデータ(isChgPallete_==1の場合のみ)
-			std::int32_t	palleteNum_;	//パレット数
+			std::uint8_t*	pallete_;		//パレットデータ(isChgPallete_==1の場合のみ、1パレットはR,G,B,Aの4バイト)
+			std::int32_t	palleteNum_;	//パレット数(元画像のパレット数を超える分は無視、足りない分は元画像のパレットを使用)
+			FileStream*		stream_;		//入力ストリーム(nullptr以外の場合はdata_の代わりに先頭から順に読み込む、PNG,JPEGのみ)
 		};
 		std::uint16_t	id_;			//画像ID
 		EN_ImageType	type_;			//画像タイプ(ソフト持ち/DB持ち)
@@ -41,6 +59,16 @@ namespace fw {
 		ImageData		blend_;			//ブレンド画像データ(isBlend_==1の場合のみ)
 	};
 
+	//画像情報(ImageDecorder::probeでヘッダのみから取得)
+	struct ImageInfo {
+		EN_ImageFormat	format_;		//画像フォーマット
+		std::int32_t	width_;			//デコード後の幅(不正な画像は0)
+		std::int32_t	height_;		//デコード後の高さ(不正な画像は0)
+		std::int32_t	bitDepth_;		//元画像の1ピクセルあたりのビット数
+		bool			hasAlpha_;		//アルファ(透過色)有無
+		std::int32_t	decodeSize_;	//デコード後のバイト数(RGBA8888、1行は幅*4バイト)
+	};
+
 	// 画像処理I/Fクラス(内部でのみ使用)
 	class ImageIF {
 	public:
@@ -48,16 +76,46 @@ namespace fw {
 		virtual ~ImageIF() {}
 		//幅高さを取得
 		virtual void getWH(std::int32_t* const width, std::int32_t* const height) = 0;
-		//RGBA8888画像へデコード
-		virtual void decodeRgba8888(std::uint8_t** const outData) = 0;
+		//デコードに必要な作業領域のバイト数を取得
+		virtual size_t getWorkSize() = 0;
+		//RGBA8888画像へデコード(outStrideは出力1行のバイト数、途中で失敗した場合はfalse)
+		virtual bool decodeRgba8888(std::uint8_t* const outData, const std::int32_t outStride, std::uint8_t* const work) = 0;
+		//デコード範囲を設定(範囲のみのデコードに対応していない場合はfalse)
+		virtual bool setDecodeArea(const std::AreaI& area) { (void)area; return false; }
+	};
+
+	//画像デコード結果
+	enum EN_DecodeResult : std::int32_t {
+		D_DECODERESULT_OK = 0,				//成功
+		D_DECODERESULT_INVALID = -1,		//未対応フォーマット、不正な画像
+		D_DECODERESULT_SHORTBUFFER = -2,	//出力先のサイズ不足
 	};
 
+	class ImageDecorder;
+	class DecodeCache;
+	struct DecodeCacheKey;
+	class File;
+
+	//一括デコード結果
+	struct ImageDecodeResult {
+		std::int32_t					rc_;		//デコード結果(EN_DecodeResult)
+		std::unique_ptr<ImageDecorder>	decorder_;	//デコード済みデータを保持するデコーダ
+	};
+
+	//一括デコード完了コールバック(ワーカースレッドから呼ばれる、decorderは呼び出し後に破棄)
+	using ImageDecodeCallback = std::function<void(const size_t index, const std::int32_t rc, ImageDecorder& decorder)>;
+
 	//画像デコードクラス
 	class ImageDecorder {
 		std::uint8_t*	decode_;		//デコードデータ
 		std::int32_t	decodeSize_;	//デコードデータサイズ
 		std::int32_t	width_;			//幅
 		std::int32_t	height_;		//高さ
+		std::int32_t	stride_;		//1行のバイト数
+		size_t			capacity_;		//デコードデータの確保サイズ(プールから取得した場合のみ)
+		EN_DecodeFormat	format_;		//デコード後のピクセルフォーマット
+		bool			isDither_;		//16bitフォーマットでディザを行うか
+		std::unique_ptr<File>	cacheFile_;	//デコードキャッシュのファイル(キャッシュをマップして参照している場合のみ)
 
 	public:
 		//コンストラクタ
@@ -69,16 +127,62 @@ namespace fw {
 		//デストラクタ
 		~ImageDecorder();
 
-		//デコード
+		//デコード(デコード先はバッファプールから取得)
+		//デコードキャッシュ設定時はキャッシュを参照し、なければデコードしてキャッシュへ登録する
+		//(キャッシュをマップして参照した場合のデコードデータは書き込み不可)
+		//入力ストリームを指定した画像はキャッシュを参照せず、ストリームは1回のデコードで読み終える
 		std::int32_t decode(const Image& image);
+		//デコード(呼び出し元が用意したデコード先へ出力)
+		//outStrideはデコード後のピクセルフォーマットでの1行のバイト数
+		//サイズ不足の場合はD_DECODERESULT_SHORTBUFFERを返し、幅高さのみ取得できる
+		std::int32_t decode(const Image& image, std::uint8_t* const outData, const std::int32_t outStride, const size_t outSize);
+		//範囲を指定してデコード(areaはdecode(image)で得られる画像上の座標、xmax,ymaxは含まない)
+		//画像からはみ出す部分は切り詰め、範囲が空の場合はD_DECODERESULT_INVALIDを返す
+		std::int32_t decode(const Image& image, const std::AreaI& area);
 		//デコードデータ取得
 		std::uint8_t* const getDecodeData(std::int32_t* const decodeSize, std::int32_t* const width, std::int32_t* const height);
+		//デコードデータの1行のバイト数を取得
+		std::int32_t getStride() const;
+		//デコード後のピクセルフォーマットを設定(以降のデコードに適用、既定はRGBA8888)
+		//変換はデコードした行毎に行い、isDitherは16bitフォーマットで4x4の組織的ディザを行うか
+		void setDecodeFormat(const EN_DecodeFormat format, const bool isDither = false);
+		//デコード後のピクセルフォーマットを取得
+		EN_DecodeFormat getDecodeFormat() const;
+
+		//デコードキャッシュを設定(nullptrで解除、キャッシュはデコード中に破棄しないこと)
+		static void setDecodeCache(DecodeCache* const cache);
+
+		//ヘッダのみから画像情報を取得(画素はデコードしない)
+		//幅高さはdecode(image)で得られるサイズ、不正なヘッダは0(ヘッダ以外の破損はデコード時のみ検出)
+		//入力ストリームはヘッダの終端まで読み進め(APPn等は読み飛ばす)、終了時に範囲の先頭へ戻す
+		static ImageInfo probe(const Image& image);
+
+		//一括デコード(ワーカースレッドで並列にデコードし、画像毎のfutureを返す)
+		//画像データは全てのデコードが完了するまで保持すること
+		static std::vector<std::future<ImageDecodeResult>> decodeBatch(const std::vector<Image>& images, const EN_DecodeFormat format = D_DECODEFORMAT_RGBA8888, const bool isDither = false);
+		//一括デコード(画像毎にデコード完了コールバックを呼ぶ、完了を待たずに戻る)
+		//画像データは全てのコールバックが呼ばれるまで保持すること
+		static void decodeBatch(const std::vector<Image>& images, const ImageDecodeCallback& callback, const EN_DecodeFormat format = D_DECODEFORMAT_RGBA8888, const bool isDither = false);
 
 	private:
 		//初期化
 		void init();
+		//デコードキャッシュから取得(キャッシュなしはfalse)
+		bool decodeFromCache(DecodeCache* const cache, const DecodeCacheKey& key);
+		//デコード処理(画像フォーマットに応じた処理クラスを生成)
+		std::int32_t decodeImage(const Image& image, const std::AreaI* const area, const EN_DecodeFormat format, std::uint8_t* const outData, const std::int32_t outStride, const size_t outSize);
 		//デコード処理実施
-		std::int32_t procDecode(ImageIF* const bodyIF, ImageIF* const blendIF);
+		std::int32_t procDecode(ImageIF* const bodyIF, ImageIF* const blendIF, const std::AreaI* const area, const EN_DecodeFormat format, std::uint8_t* const outData, const std::int32_t outStride, const size_t outSize);
+		//ブレンド画像をデコード(デコード先はプールから取得、1行は幅*4バイト、失敗した場合はnullptr)
+		std::uint8_t* decodeBlend(ImageIF* const blendIF, const std::AreaI& decodeArea, const bool isArea, size_t* const capacity);
+		//ブレンド画像の合成とデコード後のフォーマットへの変換を行単位でまとめて実施
+		//rgbaとdstは同じ領域でもよい(dstStrideが小さい場合は行を先頭へ詰める)
+		void postProcess(std::uint8_t* const rgba, const std::int32_t rgbaStride, const std::uint8_t* const blend, std::uint8_t* const dst, const std::int32_t dstStride,
+			const std::int32_t width, const std::int32_t height, const EN_DecodeFormat format);
+		//RGBA8888のデコードデータをデコード後のフォーマットへ変換
+		void convertDecodeData();
+		//範囲のみのデコードに対応していない画像を全体デコードして切り出し(失敗した場合はfalse)
+		bool decodeAreaByCopy(ImageIF* const imageIF, const std::AreaI& area, std::uint8_t* const outData, const std::int32_t outStride);
 		//Bitmap画像デコード
 		//std::int32_t decodeBitmap(const Image& image);
 		//PNG画像デコード
@@ -0,0 +1,267 @@
+﻿#include "ImageArchive.hpp"
+#include <algorithm>
+#include <cstring>
+#include "io/ByteIO.hpp"
+
+namespace {
+
+	//ヘッダのオフセット
+	static const std::uint32_t HEADER_MAGIC_OFS = 0;
+	static const std::uint32_t HEADER_VERSION_OFS = 4;
+	static const std::uint32_t HEADER_ENTRYNUM_OFS = 8;
+	static const std::uint32_t HEADER_INDEXOFS_OFS = 12;
+	static const std::uint32_t HEADER_DATAOFS_OFS = 16;
+	static const std::uint32_t HEADER_ARCHIVESIZE_OFS = 20;
+
+	//索引のオフセット
+	static const std::uint32_t INDEX_ID_OFS = 0;
+	static const std::uint32_t INDEX_FORMAT_OFS = 2;
+	static const std::uint32_t INDEX_BODYOFS_OFS = 4;
+	static const std::uint32_t INDEX_BODYSIZE_OFS = 8;
+	static const std::uint32_t INDEX_BLENDOFS_OFS = 12;
+	static const std::uint32_t INDEX_BLENDSIZE_OFS = 16;
+
+	//境界に合わせて切り上げ
+	static std::uint64_t alignUp(const std::uint64_t value)
+	{
+		return (value + (fw::ImageArchive::DATA_ALIGN - 1)) & ~std::uint64_t(fw::ImageArchive::DATA_ALIGN - 1);
+	}
+
+	//ファイルを全て読み込み
+	static bool readFile(const std::string& filePath, std::vector<std::uint8_t>* const data)
+	{
+		fw::File file;
+		(void)file.create(filePath);
+		if (!file.open("rb")) {
+			return false;
+		}
+		data->resize(size_t(file.getFileSize()));
+		if (data->empty()) {
+			return true;
+		}
+		return file.read(data->data(), 0, data->size());
+	}
+}
+
+
+//----------------------------------------------------------
+//
+// 画像アーカイブクラス
+//
+//----------------------------------------------------------
+
+//識別子
+const std::uint8_t fw::ImageArchive::MAGIC[4] = { 'F', 'W', 'I', 'A' };
+
+//コンストラクタ
+fw::ImageArchive::ImageArchive() :
+	file_(), data_(nullptr), size_(0), entryNum_(0), indexOffset_(0)
+{
+}
+
+//デストラクタ
+fw::ImageArchive::~ImageArchive()
+{
+	this->close();
+}
+
+//オープン
+bool fw::ImageArchive::open(const std::string& archivePath)
+{
+	if (this->data_ != nullptr) {
+		//オープン済み
+		return false;
+	}
+
+	//アーカイブ全体をマップ(前回のパスが残らないよう、オープン毎にファイルを作り直す)
+	this->file_.reset(new File());
+	if (!this->file_->create(archivePath) || !this->file_->open("rb")) {
+		this->close();
+		return false;
+	}
+	std::uint8_t* data = this->file_->map();
+	const size_t size = size_t(this->file_->getFileSize());
+	if ((data == nullptr) || (size < HEADER_SIZE)) {
+		this->close();
+		return false;
+	}
+
+	//ヘッダを検証
+	const std::uint32_t entryNum = fw::ByteReader::read4ByteLe(data + HEADER_ENTRYNUM_OFS);
+	const std::uint32_t indexOffset = fw::ByteReader::read4ByteLe(data + HEADER_INDEXOFS_OFS);
+	if ((std::memcmp(data + HEADER_MAGIC_OFS, MAGIC, sizeof(MAGIC)) != 0) ||
+		(fw::ByteReader::read2ByteLe(data + HEADER_VERSION_OFS) != VERSION) ||
+		(fw::ByteReader::read4ByteLe(data + HEADER_ARCHIVESIZE_OFS) != size) ||
+		(entryNum > std::uint32_t(INT32_MAX / INDEX_ENTRY_SIZE)) ||
+		((std::uint64_t(indexOffset) + (std::uint64_t(entryNum) * INDEX_ENTRY_SIZE)) > size)) {
+		this->close();
+		return false;
+	}
+
+	//索引を検証(画像IDの昇順、画像データがアーカイブ内)
+	for (std::uint32_t i = 0; i < entryNum; i++) {
+		const std::uint8_t* const index = data + indexOffset + (i * INDEX_ENTRY_SIZE);
+		const std::uint64_t bodyEnd = std::uint64_t(fw::ByteReader::read4ByteLe(index + INDEX_BODYOFS_OFS)) + fw::ByteReader::read4ByteLe(index + INDEX_BODYSIZE_OFS);
+		const std::uint64_t blendEnd = std::uint64_t(fw::ByteReader::read4ByteLe(index + INDEX_BLENDOFS_OFS)) + fw::ByteReader::read4ByteLe(index + INDEX_BLENDSIZE_OFS);
+		const bool isSorted = (i == 0) || (fw::ByteReader::read2ByteLe(index - INDEX_ENTRY_SIZE + INDEX_ID_OFS) < fw::ByteReader::read2ByteLe(index + INDEX_ID_OFS));
+		if (!isSorted || (bodyEnd > size) || (blendEnd > size) ||
+			(fw::ByteReader::read4ByteLe(index + INDEX_BODYSIZE_OFS) > std::uint32_t(INT32_MAX)) || (fw::ByteReader::read4ByteLe(index + INDEX_BLENDSIZE_OFS) > std::uint32_t(INT32_MAX))) {
+			this->close();
+			return false;
+		}
+	}
+
+	//画像は画像ID順に参照されるとは限らないため、前後の画像の先読みを抑える
+	this->file_->advise(0, size, D_FILEADVICE_RANDOM);
+
+	this->data_ = data;
+	this->size_ = size;
+	this->entryNum_ = std::int32_t(entryNum);
+	this->indexOffset_ = indexOffset;
+
+	return true;
+}
+
+//クローズ
+void fw::ImageArchive::close()
+{
+	//ファイルの破棄でマップも解除
+	this->file_.reset();
+	this->data_ = nullptr;
+	this->size_ = 0;
+	this->entryNum_ = 0;
+	this->indexOffset_ = 0;
+}
+
+//画像数を取得
+std::int32_t fw::ImageArchive::getEntryNum() const
+{
+	return this->entryNum_;
+}
+
+//索引順に画像を取得
+bool fw::ImageArchive::getEntry(const std::int32_t index, ImageArchiveEntry* const entry) const
+{
+	if ((index < 0) || (index >= this->entryNum_)) {
+		return false;
+	}
+
+	const std::uint8_t* const data = this->data_ + this->indexOffset_ + (std::uint32_t(index) * INDEX_ENTRY_SIZE);
+	entry->id_ = fw::ByteReader::read2ByteLe(data + INDEX_ID_OFS);
+	entry->format_ = EN_ImageFormat(fw::ByteReader::read2ByteLe(data + INDEX_FORMAT_OFS));
+	entry->bodySize_ = std::int32_t(fw::ByteReader::read4ByteLe(data + INDEX_BODYSIZE_OFS));
+	entry->body_ = (entry->bodySize_ > 0) ? (this->data_ + fw::ByteReader::read4ByteLe(data + INDEX_BODYOFS_OFS)) : nullptr;
+	entry->blendSize_ = std::int32_t(fw::ByteReader::read4ByteLe(data + INDEX_BLENDSIZE_OFS));
+	entry->blend_ = (entry->blendSize_ > 0) ? (this->data_ + fw::ByteReader::read4ByteLe(data + INDEX_BLENDOFS_OFS)) : nullptr;
+
+	return true;
+}
+
+//画像IDで画像を検索
+bool fw::ImageArchive::find(const std::uint16_t id, ImageArchiveEntry* const entry) const
+{
+	std::int32_t low = 0;
+	std::int32_t high = this->entryNum_ - 1;
+	while (low <= high) {
+		const std::int32_t mid = (low + high) / 2;
+		const std::uint16_t midId = fw::ByteReader::read2ByteLe(this->data_ + this->indexOffset_ + (std::uint32_t(mid) * INDEX_ENTRY_SIZE) + INDEX_ID_OFS);
+		if (midId == id) {
+			return this->getEntry(mid, entry);
+		}
+		else if (midId < id) {
+			low = mid + 1;
+		}
+		else {
+			high = mid - 1;
+		}
+	}
+
+	return false;
+}
+
+//画像データの物理ページを解放
+void fw::ImageArchive::releasePages(const std::uint8_t* const data, const size_t size)
+{
+	if ((this->data_ == nullptr) || (data < this->data_) || (data >= (this->data_ + this->size_))) {
+		//アーカイブ外
+		return;
+	}
+	this->file_->releasePages(size_t(data - this->data_), size);
+}
+
+//アーカイブを作成
+bool fw::ImageArchive::write(const std::string& archivePath, const std::vector<ImageArchiveSource>& sources)
+{
+	//画像IDの昇順に並べる
+	std::vector<const ImageArchiveSource*> sorted;
+	sorted.reserve(sources.size());
+	for (const ImageArchiveSource& source : sources) {
+		sorted.push_back(&source);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const ImageArchiveSource* a, const ImageArchiveSource* b) { return (a->id_ < b->id_); });
+	for (size_t i = 1; i < sorted.size(); i++) {
+		if (sorted[i - 1]->id_ == sorted[i]->id_) {
+			//画像IDの重複
+			return false;
+		}
+	}
+
+	//画像ファイルを読み込み、配置を決める
+	const std::uint32_t entryNum = std::uint32_t(sorted.size());
+	std::vector<std::vector<std::uint8_t>> bodies(entryNum);
+	std::vector<std::vector<std::uint8_t>> blends(entryNum);
+	std::vector<std::uint8_t> header(HEADER_SIZE + (entryNum * INDEX_ENTRY_SIZE), 0);
+	const std::uint64_t dataOffset = alignUp(header.size());
+	std::uint64_t offset = dataOffset;
+	for (std::uint32_t i = 0; i < entryNum; i++) {
+		const ImageArchiveSource& source = *sorted[i];
+		if (!readFile(source.bodyPath_, &bodies[i])) {
+			return false;
+		}
+		if (!source.blendPath_.empty() && !readFile(source.blendPath_, &blends[i])) {
+			return false;
+		}
+
+		std::uint8_t* const index = header.data() + HEADER_SIZE + (i * INDEX_ENTRY_SIZE);
+		fw::ByteWriter::write2ByteLe(index + INDEX_ID_OFS, source.id_);
+		fw::ByteWriter::write2ByteLe(index + INDEX_FORMAT_OFS, std::uint16_t(source.format_));
+		fw::ByteWriter::write4ByteLe(index + INDEX_BODYOFS_OFS, std::uint32_t(offset));
+		fw::ByteWriter::write4ByteLe(index + INDEX_BODYSIZE_OFS, std::uint32_t(bodies[i].size()));
+		offset = alignUp(offset + bodies[i].size());
+		fw::ByteWriter::write4ByteLe(index + INDEX_BLENDOFS_OFS, std::uint32_t(blends[i].empty() ? 0 : offset));
+		fw::ByteWriter::write4ByteLe(index + INDEX_BLENDSIZE_OFS, std::uint32_t(blends[i].size()));
+		offset = alignUp(offset + blends[i].size());
+	}
+	if (offset > UINT32_MAX) {
+		//4GBを超えるアーカイブは作成不可
+		return false;
+	}
+
+	//ヘッダ
+	std::memcpy(header.data() + HEADER_MAGIC_OFS, MAGIC, sizeof(MAGIC));
+	fw::ByteWriter::write2ByteLe(header.data() + HEADER_VERSION_OFS, VERSION);
+	fw::ByteWriter::write4ByteLe(header.data() + HEADER_ENTRYNUM_OFS, entryNum);
+	fw::ByteWriter::write4ByteLe(header.data() + HEADER_INDEXOFS_OFS, HEADER_SIZE);
+	fw::ByteWriter::write4ByteLe(header.data() + HEADER_DATAOFS_OFS, std::uint32_t(dataOffset));
+	fw::ByteWriter::write4ByteLe(header.data() + HEADER_ARCHIVESIZE_OFS, std::uint32_t(offset));
+
+	//ヘッダ、索引、画像データの順に書き込み(各画像データは境界まで0で埋める)
+	File file;
+	(void)file.create(archivePath);
+	if (!file.open("wb")) {
+		return false;
+	}
+	static const std::uint8_t PADDING[DATA_ALIGN] = { 0 };
+	bool isOk = file.write(header.data(), header.size()) && file.write(PADDING, size_t(dataOffset - header.size()));
+	for (std::uint32_t i = 0; (i < entryNum) && isOk; i++) {
+		for (const std::vector<std::uint8_t>* blob : { &bodies[i], &blends[i] }) {
+			if (blob->empty()) {
+				continue;
+			}
+			isOk = isOk && file.write(blob->data(), blob->size());
+			isOk = isOk && file.write(PADDING, size_t(alignUp(blob->size()) - blob->size()));
+		}
+	}
+
+	return isOk;
+}
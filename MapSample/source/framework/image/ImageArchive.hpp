@@ -0,0 +1,98 @@
+﻿#ifndef INCLUDED_IMAGEARCHIVE_HPP
+#define INCLUDED_IMAGEARCHIVE_HPP
+
+#include "Std.hpp"
+#include "image/Image.hpp"
+#include "io/File.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fw {
+
+	//アーカイブに格納する画像ファイル
+	struct ImageArchiveSource {
+		std::uint16_t		id_;			//画像ID
+		EN_ImageFormat		format_;		//画像フォーマット
+		std::string			bodyPath_;		//本体画像ファイルパス
+		std::string			blendPath_;		//ブレンド画像ファイルパス(なしは空)
+	};
+
+	//アーカイブ内の画像
+	struct ImageArchiveEntry {
+		std::uint16_t		id_;			//画像ID
+		EN_ImageFormat		format_;		//画像フォーマット
+		std::uint8_t*		body_;			//本体画像データ(マップ先、書き込み不可)
+		std::int32_t		bodySize_;		//本体画像データサイズ
+		std::uint8_t*		blend_;			//ブレンド画像データ(なしはnullptr)
+		std::int32_t		blendSize_;		//ブレンド画像データサイズ
+	};
+
+	//----------------------------------------------------------
+	//
+	// 画像アーカイブクラス
+	//
+	// 複数の画像ファイルを1ファイルにまとめたアーカイブを1回のマップで参照する。
+	// 数値は全てリトルエンディアン。
+	//
+	//  ヘッダ(32byte)
+	//    0: 識別子"FWIA"  4: バージョン(2byte)  8: 画像数(4byte)
+	//   12: 索引オフセット(4byte)  16: データオフセット(4byte)  20: アーカイブサイズ(4byte)
+	//  索引(画像数*24byte、画像IDの昇順)
+	//    0: 画像ID(2byte)  2: 画像フォーマット(2byte)
+	//    4: 本体オフセット(4byte)  8: 本体サイズ(4byte)
+	//   12: ブレンドオフセット(4byte)  16: ブレンドサイズ(4byte)
+	//  データ(各画像データの先頭は16byte境界)
+	//
+	//----------------------------------------------------------
+
+	class ImageArchive {
+	public:
+		//識別子
+		static const std::uint8_t MAGIC[4];
+		//バージョン
+		static const std::uint16_t VERSION = 1;
+		//ヘッダサイズ
+		static const std::uint32_t HEADER_SIZE = 32;
+		//索引1件のサイズ
+		static const std::uint32_t INDEX_ENTRY_SIZE = 24;
+		//画像データの境界
+		static const std::uint32_t DATA_ALIGN = 16;
+
+	private:
+		//メンバ変数
+		std::unique_ptr<File>	file_;			//アーカイブファイル(オープン中のみ)
+		std::uint8_t*	data_;			//マップ先
+		size_t			size_;			//アーカイブサイズ
+		std::int32_t	entryNum_;		//画像数
+		std::uint32_t	indexOffset_;	//索引オフセット
+
+	public:
+		//コンストラクタ
+		ImageArchive();
+		//デストラクタ
+		~ImageArchive();
+		//オープン(アーカイブ全体をマップし、ヘッダと索引を検証する)
+		bool open(const std::string& archivePath);
+		//クローズ(取得した画像データは無効になる)
+		void close();
+		//画像数を取得
+		std::int32_t getEntryNum() const;
+		//索引順に画像を取得
+		bool getEntry(const std::int32_t index, ImageArchiveEntry* const entry) const;
+		//画像IDで画像を検索(索引の二分探索)
+		bool find(const std::uint16_t id, ImageArchiveEntry* const entry) const;
+		//画像データの物理ページを解放(再アクセス時はファイルから読み直される)
+		void releasePages(const std::uint8_t* const data, const size_t size);
+
+		//アーカイブを作成(画像IDの重複、読み込めないファイルがある場合は失敗)
+		static bool write(const std::string& archivePath, const std::vector<ImageArchiveSource>& sources);
+
+		//コピーコンストラクタ(禁止)
+		ImageArchive(const ImageArchive& org) = delete;
+		//代入演算子(禁止)
+		ImageArchive& operator=(const ImageArchive& org) = delete;
+	};
+}
+
+#endif //INCLUDED_IMAGEARCHIVE_HPP
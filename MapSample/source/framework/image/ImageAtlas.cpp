@@ -0,0 +1,295 @@
+﻿#include "ImageAtlas.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+	//RGBA8888画像の1ピクセルあたりのバイト数
+	static const std::int32_t BYTE_PER_PIXEL_RGBA8888 = 4;
+}
+
+
+//----------------------------------------------------------
+//
+// 画像アトラスクラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::ImageAtlas::ImageAtlas(const std::int32_t pageSize, const std::int32_t maxPageNum, const std::int32_t padding, const std::int32_t maxImageSize) :
+	pageSize_(pageSize), maxPageNum_(maxPageNum), padding_(padding), maxImageSize_(maxImageSize), pageList_(), regionMap_(), tile_(),
+	frame_(1), eviction_(0), createFunc_(nullptr), uploadFunc_(nullptr), releaseFunc_(nullptr)
+{
+}
+
+//デストラクタ
+fw::ImageAtlas::~ImageAtlas()
+{
+	//全ページを解放
+	this->clear();
+}
+
+//ページ操作関数を設定
+void fw::ImageAtlas::setPageFunc(const CreatePageFunc createFunc, const UploadPageFunc uploadFunc, const ReleasePageFunc releaseFunc)
+{
+	this->createFunc_ = createFunc;
+	this->uploadFunc_ = uploadFunc;
+	this->releaseFunc_ = releaseFunc;
+}
+
+//フレーム開始
+void fw::ImageAtlas::beginFrame()
+{
+	this->frame_++;
+}
+
+//登録可能なサイズか
+bool fw::ImageAtlas::isInsertable(const std::int32_t width, const std::int32_t height) const
+{
+	return ((width > 0) && (height > 0) && (width <= this->maxImageSize_) && (height <= this->maxImageSize_)
+		&& ((width + (this->padding_ * 2)) <= this->pageSize_) && ((height + (this->padding_ * 2)) <= this->pageSize_));
+}
+
+//検索
+const fw::ImageAtlasRegion* fw::ImageAtlas::find(const ImageCacheKey& key)
+{
+	auto itr = this->regionMap_.find(key);
+	if (itr == this->regionMap_.end()) {
+		return nullptr;
+	}
+
+	//現在のフレームで使用中
+	this->pageList_[size_t(itr->second.page_)].lastUse_ = this->frame_;
+	return &itr->second;
+}
+
+//登録
+const fw::ImageAtlasRegion* fw::ImageAtlas::insert(const ImageCacheKey& key, const std::uint8_t* const decode, const std::int32_t width, const std::int32_t height, const std::int32_t stride)
+{
+	const ImageAtlasRegion* const found = this->find(key);
+	if (found != nullptr) {
+		//登録済み
+		return found;
+	}
+	if ((decode == nullptr) || !this->isInsertable(width, height)) {
+		return nullptr;
+	}
+
+	//余白を含めて置ける位置を探す(古いページから順に)
+	const std::int32_t allocWidth = width + (this->padding_ * 2);
+	const std::int32_t allocHeight = height + (this->padding_ * 2);
+	std::int32_t pageIndex = -1;
+	std::int32_t x = 0;
+	std::int32_t y = 0;
+	size_t nodeIndex = 0;
+	std::int32_t bottom = 0;
+	for (size_t i = 0; i < this->pageList_.size(); i++) {
+		if (this->findPosition(this->pageList_[i], allocWidth, allocHeight, &x, &y, &nodeIndex, &bottom)) {
+			pageIndex = std::int32_t(i);
+			break;
+		}
+	}
+
+	if (pageIndex < 0) {
+		if (std::int32_t(this->pageList_.size()) < this->maxPageNum_) {
+			//ページ追加
+			Page page;
+			page.texId_ = (this->createFunc_ != nullptr) ? this->createFunc_(this->pageSize_) : 0;
+			page.lastUse_ = this->frame_;
+			this->pageList_.push_back(page);
+			this->resetPage(&this->pageList_.back());
+			pageIndex = std::int32_t(this->pageList_.size()) - 1;
+		}
+		else {
+			//現在のフレームで使用していない最も古いページを追い出す
+			for (size_t i = 0; i < this->pageList_.size(); i++) {
+				const std::uint64_t lastUse = this->pageList_[i].lastUse_;
+				if ((lastUse < this->frame_) && ((pageIndex < 0) || (lastUse < this->pageList_[size_t(pageIndex)].lastUse_))) {
+					pageIndex = std::int32_t(i);
+				}
+			}
+			if (pageIndex < 0) {
+				//全ページが使用中
+				return nullptr;
+			}
+			this->resetPage(&this->pageList_[size_t(pageIndex)]);
+			this->eviction_++;
+		}
+
+		//空のページには必ず置ける
+		(void)this->findPosition(this->pageList_[size_t(pageIndex)], allocWidth, allocHeight, &x, &y, &nodeIndex, &bottom);
+	}
+
+	//配置
+	Page& page = this->pageList_[size_t(pageIndex)];
+	this->addSkyline(&page, nodeIndex, x, y, allocWidth, allocHeight);
+	page.keyList_.push_back(key);
+	page.lastUse_ = this->frame_;
+
+	//余白付きの画像をページへ転送
+	this->makeTile(decode, width, height, stride);
+	if (this->uploadFunc_ != nullptr) {
+		this->uploadFunc_(page.texId_, x, y, allocWidth, allocHeight, this->tile_.data());
+	}
+
+	//位置を登録
+	const std::float_t scale = 1.0F / std::float_t(this->pageSize_);
+	ImageAtlasRegion region;
+	region.page_ = pageIndex;
+	region.texId_ = page.texId_;
+	region.x_ = x + this->padding_;
+	region.y_ = y + this->padding_;
+	region.width_ = width;
+	region.height_ = height;
+	region.u0_ = std::float_t(region.x_) * scale;
+	region.v0_ = std::float_t(region.y_) * scale;
+	region.u1_ = std::float_t(region.x_ + width) * scale;
+	region.v1_ = std::float_t(region.y_ + height) * scale;
+	return &(this->regionMap_[key] = region);
+}
+
+//全ページを解放
+void fw::ImageAtlas::clear()
+{
+	if (this->releaseFunc_ != nullptr) {
+		for (auto itr = this->pageList_.cbegin(); itr != this->pageList_.cend(); itr++) {
+			this->releaseFunc_(itr->texId_);
+		}
+	}
+	this->pageList_.clear();
+	this->regionMap_.clear();
+}
+
+//ページ数を取得
+std::int32_t fw::ImageAtlas::getPageNum() const
+{
+	return std::int32_t(this->pageList_.size());
+}
+
+//登録済みの画像数を取得
+size_t fw::ImageAtlas::getEntryNum() const
+{
+	return this->regionMap_.size();
+}
+
+//ページ追い出し数を取得
+std::uint64_t fw::ImageAtlas::getEviction() const
+{
+	return this->eviction_;
+}
+
+//ページ内で置ける位置を探す
+bool fw::ImageAtlas::findPosition(const Page& page, const std::int32_t width, const std::int32_t height, std::int32_t* const x, std::int32_t* const y, size_t* const nodeIndex, std::int32_t* const bottom) const
+{
+	//下端が最も低くなる位置(同じ場合は左)
+	bool isFound = false;
+	const std::vector<SkylineNode>& skyline = page.skyline_;
+	for (size_t i = 0; i < skyline.size(); i++) {
+		const std::int32_t left = skyline[i].x_;
+		if ((left + width) > this->pageSize_) {
+			//右端からはみ出す(以降の区間も同様)
+			break;
+		}
+
+		//矩形の幅にかかる区間の最も高い位置に置く
+		std::int32_t top = 0;
+		std::int32_t remain = width;
+		for (size_t j = i; remain > 0; j++) {
+			top = std::max(top, skyline[j].y_);
+			remain -= skyline[j].width_;
+		}
+		if ((top + height) > this->pageSize_) {
+			continue;
+		}
+
+		if (!isFound || ((top + height) < *bottom)) {
+			isFound = true;
+			*x = left;
+			*y = top;
+			*nodeIndex = i;
+			*bottom = top + height;
+		}
+	}
+
+	return isFound;
+}
+
+//スカイラインへ配置した矩形を反映
+void fw::ImageAtlas::addSkyline(Page* const page, const size_t nodeIndex, const std::int32_t x, const std::int32_t y, const std::int32_t width, const std::int32_t height)
+{
+	std::vector<SkylineNode>& skyline = page->skyline_;
+
+	//矩形の上端を新しい区間として挿入
+	SkylineNode node;
+	node.x_ = x;
+	node.y_ = y + height;
+	node.width_ = width;
+	skyline.insert(skyline.begin() + nodeIndex, node);
+
+	//矩形に隠れた区間を削る
+	for (size_t i = nodeIndex + 1; i < skyline.size();) {
+		const std::int32_t prevRight = skyline[i - 1].x_ + skyline[i - 1].width_;
+		if (skyline[i].x_ >= prevRight) {
+			break;
+		}
+		const std::int32_t shrink = prevRight - skyline[i].x_;
+		skyline[i].x_ += shrink;
+		skyline[i].width_ -= shrink;
+		if (skyline[i].width_ > 0) {
+			break;
+		}
+		skyline.erase(skyline.begin() + i);
+	}
+
+	//同じ高さの隣り合う区間をまとめる
+	for (size_t i = 1; i < skyline.size();) {
+		if (skyline[i - 1].y_ == skyline[i].y_) {
+			skyline[i - 1].width_ += skyline[i].width_;
+			skyline.erase(skyline.begin() + i);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+//ページを空にする
+void fw::ImageAtlas::resetPage(Page* const page)
+{
+	for (auto itr = page->keyList_.cbegin(); itr != page->keyList_.cend(); itr++) {
+		this->regionMap_.erase(*itr);
+	}
+	page->keyList_.clear();
+
+	SkylineNode node;
+	node.x_ = 0;
+	node.y_ = 0;
+	node.width_ = this->pageSize_;
+	page->skyline_.assign(1, node);
+}
+
+//余白付きの転送用画像を作成
+void fw::ImageAtlas::makeTile(const std::uint8_t* const decode, const std::int32_t width, const std::int32_t height, const std::int32_t stride)
+{
+	const std::int32_t padding = this->padding_;
+	const std::int32_t tileWidth = width + (padding * 2);
+	const std::int32_t tileHeight = height + (padding * 2);
+	const size_t tileStride = size_t(tileWidth) * BYTE_PER_PIXEL_RGBA8888;
+	this->tile_.resize(tileStride * size_t(tileHeight));
+
+	for (std::int32_t ty = 0; ty < tileHeight; ty++) {
+		//余白の行は上端、下端の行を複製
+		const std::int32_t sy = std::min(std::max(ty - padding, std::int32_t(0)), height - 1);
+		const std::uint8_t* const src = decode + (size_t(sy) * size_t(stride));
+		std::uint8_t* const dst = &this->tile_[size_t(ty) * tileStride];
+
+		//余白の列は左端、右端の画素を複製
+		const std::uint8_t* const last = src + (size_t(width - 1) * BYTE_PER_PIXEL_RGBA8888);
+		std::uint8_t* const right = dst + (size_t(padding + width) * BYTE_PER_PIXEL_RGBA8888);
+		for (std::int32_t i = 0; i < padding; i++) {
+			std::memcpy(dst + (size_t(i) * BYTE_PER_PIXEL_RGBA8888), src, BYTE_PER_PIXEL_RGBA8888);
+			std::memcpy(right + (size_t(i) * BYTE_PER_PIXEL_RGBA8888), last, BYTE_PER_PIXEL_RGBA8888);
+		}
+		std::memcpy(dst + (size_t(padding) * BYTE_PER_PIXEL_RGBA8888), src, size_t(width) * BYTE_PER_PIXEL_RGBA8888);
+	}
+}
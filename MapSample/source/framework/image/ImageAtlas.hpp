@@ -0,0 +1,134 @@
+﻿#ifndef INCLUDED_IMAGEATLAS_HPP
+#define INCLUDED_IMAGEATLAS_HPP
+
+#include "Std.hpp"
+#include "image/ImageCache.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace fw {
+
+	//アトラス内の画像の位置
+	struct ImageAtlasRegion {
+		std::int32_t	page_;			//ページ番号
+		std::uint32_t	texId_;			//ページのテクスチャID(描画側で使用)
+		std::int32_t	x_;				//ページ内の左上X座標(余白を除く)
+		std::int32_t	y_;				//ページ内の左上Y座標(余白を除く)
+		std::int32_t	width_;			//幅
+		std::int32_t	height_;		//高さ
+		std::float_t	u0_;			//画像の左端のU
+		std::float_t	v0_;			//画像の上端のV
+		std::float_t	u1_;			//画像の右端のU
+		std::float_t	v1_;			//画像の下端のV
+	};
+
+	//----------------------------------------------------------
+	//
+	// 画像アトラスクラス
+	//
+	// デコード済みの小さな画像を固定サイズのページ(テクスチャ)へ
+	// スカイライン法(左下詰め)で詰め込み、同じページの画像を
+	// 1回のテクスチャ割り当てでまとめて描画できるようにする。
+	// 画像の周囲には端の画素を複製した余白を付け、線形補間で
+	// 隣の画像がにじまないようにする。
+	// ページが上限に達した場合は、現在のフレームで使用していない
+	// 最も長く使われていないページを丸ごと空にして再利用する。
+	// 描画スレッドからのみ使用すること。
+	//
+	//----------------------------------------------------------
+
+	class ImageAtlas {
+	public:
+		//ページ作成関数(テクスチャIDを返す)
+		using CreatePageFunc = std::uint32_t(*)(const std::int32_t pageSize);
+		//ページ転送関数(ページ内の範囲へRGBA8888画像を転送、1行は幅*4バイト)
+		using UploadPageFunc = void(*)(const std::uint32_t texId, const std::int32_t x, const std::int32_t y, const std::int32_t width, const std::int32_t height, const std::uint8_t* const data);
+		//ページ解放関数(テクスチャ削除など)
+		using ReleasePageFunc = void(*)(const std::uint32_t texId);
+
+		//既定のページサイズ
+		static const std::int32_t DEFAULT_PAGE_SIZE = 1024;
+		//既定のページ数上限
+		static const std::int32_t DEFAULT_PAGE_NUM = 4;
+		//既定の余白
+		static const std::int32_t DEFAULT_PADDING = 1;
+		//既定の登録可能な画像の最大幅高さ(これを超える画像は個別のテクスチャで描画する)
+		static const std::int32_t DEFAULT_MAX_IMAGE_SIZE = 256;
+
+	private:
+		//スカイラインの区間
+		struct SkylineNode {
+			std::int32_t	x_;				//左端
+			std::int32_t	y_;				//高さ(この区間で次に置ける上端)
+			std::int32_t	width_;			//幅
+		};
+
+		//ページ
+		struct Page {
+			std::uint32_t				texId_;		//テクスチャID
+			std::vector<SkylineNode>	skyline_;	//スカイライン(左から順)
+			std::vector<ImageCacheKey>	keyList_;	//登録済みの画像
+			std::uint64_t				lastUse_;	//最終使用フレーム
+		};
+
+		using RegionMap = std::unordered_map<ImageCacheKey, ImageAtlasRegion, ImageCacheKeyHash>;
+
+		//メンバ変数
+		std::int32_t				pageSize_;		//ページサイズ
+		std::int32_t				maxPageNum_;	//ページ数上限
+		std::int32_t				padding_;		//余白
+		std::int32_t				maxImageSize_;	//登録可能な画像の最大幅高さ
+		std::vector<Page>			pageList_;		//ページ
+		RegionMap					regionMap_;		//キー→位置
+		std::vector<std::uint8_t>	tile_;			//余白付きの転送用画像
+		std::uint64_t				frame_;			//現在のフレーム
+		std::uint64_t				eviction_;		//ページ追い出し数
+		CreatePageFunc				createFunc_;	//ページ作成関数
+		UploadPageFunc				uploadFunc_;	//ページ転送関数
+		ReleasePageFunc				releaseFunc_;	//ページ解放関数
+
+	public:
+		//コンストラクタ
+		ImageAtlas(const std::int32_t pageSize = DEFAULT_PAGE_SIZE, const std::int32_t maxPageNum = DEFAULT_PAGE_NUM,
+			const std::int32_t padding = DEFAULT_PADDING, const std::int32_t maxImageSize = DEFAULT_MAX_IMAGE_SIZE);
+		//デストラクタ
+		~ImageAtlas();
+		//ページ操作関数を設定
+		void setPageFunc(const CreatePageFunc createFunc, const UploadPageFunc uploadFunc, const ReleasePageFunc releaseFunc);
+		//フレーム開始(前のフレームで使用したページを追い出し可能にする)
+		void beginFrame();
+		//登録可能なサイズか
+		bool isInsertable(const std::int32_t width, const std::int32_t height) const;
+		//検索(ヒットした場合はページを現在のフレームで使用中にする)
+		//返した位置は次の登録、解放まで有効
+		const ImageAtlasRegion* find(const ImageCacheKey& key);
+		//登録(登録済みの場合はその位置、空きがなく追い出せるページもない場合はnullptr)
+		//strideはデコードデータの1行のバイト数
+		const ImageAtlasRegion* insert(const ImageCacheKey& key, const std::uint8_t* const decode, const std::int32_t width, const std::int32_t height, const std::int32_t stride);
+		//全ページを解放
+		void clear();
+		//ページ数を取得
+		std::int32_t getPageNum() const;
+		//登録済みの画像数を取得
+		size_t getEntryNum() const;
+		//ページ追い出し数を取得
+		std::uint64_t getEviction() const;
+
+		//コピーコンストラクタ(禁止)
+		ImageAtlas(const ImageAtlas& org) = delete;
+		//代入演算子(禁止)
+		ImageAtlas& operator=(const ImageAtlas& org) = delete;
+
+	private:
+		//ページ内で置ける位置を探す(見つからない場合はfalse)
+		bool findPosition(const Page& page, const std::int32_t width, const std::int32_t height, std::int32_t* const x, std::int32_t* const y, size_t* const nodeIndex, std::int32_t* const bottom) const;
+		//スカイラインへ配置した矩形を反映
+		void addSkyline(Page* const page, const size_t nodeIndex, const std::int32_t x, const std::int32_t y, const std::int32_t width, const std::int32_t height);
+		//ページを空にする
+		void resetPage(Page* const page);
+		//余白付きの転送用画像を作成
+		void makeTile(const std::uint8_t* const decode, const std::int32_t width, const std::int32_t height, const std::int32_t stride);
+	};
+}
+
+#endif //INCLUDED_IMAGEATLAS_HPP
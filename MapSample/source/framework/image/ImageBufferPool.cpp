@@ -0,0 +1,112 @@
+﻿#include "ImageBufferPool.hpp"
+
+namespace {
+
+	//サイズクラス毎に保持する空きバッファ数の目安(freeListの事前確保数)
+	static const size_t FREELIST_RESERVE = 8;
+}
+
+
+//----------------------------------------------------------
+//
+// 画像バッファプールクラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::ImageBufferPool::ImageBufferPool(const size_t retainByte) :
+	mutex_(), freeList_(), retainByte_(retainByte), freeByte_(0)
+{
+	//返却時にヒープ確保が起きないよう事前に確保しておく
+	for (std::int32_t c = 0; c < CLASS_NUM; c++) {
+		this->freeList_[c].reserve(FREELIST_RESERVE);
+	}
+}
+
+//デストラクタ
+fw::ImageBufferPool::~ImageBufferPool()
+{
+	this->clear();
+}
+
+//バッファを取得
+std::uint8_t* fw::ImageBufferPool::acquire(const size_t size, size_t* const capacity)
+{
+	const std::int32_t sizeClass = getSizeClass(size);
+	if (sizeClass < 0) {
+		//サイズクラス外は直接確保
+		*capacity = size;
+		return new std::uint8_t[size];
+	}
+
+	const size_t classByte = size_t(1) << (CLASS_MIN_SHIFT + sizeClass);
+	*capacity = classByte;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		std::vector<std::uint8_t*>& freeList = this->freeList_[sizeClass];
+		if (!freeList.empty()) {
+			//空きバッファを再利用
+			std::uint8_t* buffer = freeList.back();
+			freeList.pop_back();
+			this->freeByte_ -= classByte;
+			return buffer;
+		}
+	}
+
+	//空きがないので確保
+	return new std::uint8_t[classByte];
+}
+
+//バッファを返却
+void fw::ImageBufferPool::release(std::uint8_t* const buffer, const size_t capacity)
+{
+	if (buffer == nullptr) {
+		return;
+	}
+
+	const std::int32_t sizeClass = getSizeClass(capacity);
+	if ((sizeClass >= 0) && ((size_t(1) << (CLASS_MIN_SHIFT + sizeClass)) == capacity)) {
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		std::vector<std::uint8_t*>& freeList = this->freeList_[sizeClass];
+		if (((this->freeByte_ + capacity) <= this->retainByte_) && (freeList.size() < freeList.capacity())) {
+			//保持上限内であればプールに戻す
+			freeList.push_back(buffer);
+			this->freeByte_ += capacity;
+			return;
+		}
+	}
+
+	//プールに戻せないバッファは解放
+	delete[] buffer;
+}
+
+//空きバッファを全て解放
+void fw::ImageBufferPool::clear()
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+	for (std::int32_t c = 0; c < CLASS_NUM; c++) {
+		for (auto itr = this->freeList_[c].cbegin(); itr != this->freeList_[c].cend(); itr++) {
+			delete[] *itr;
+		}
+		this->freeList_[c].clear();
+	}
+	this->freeByte_ = 0;
+}
+
+//既定のプールを取得
+fw::ImageBufferPool& fw::ImageBufferPool::getDefault()
+{
+	static ImageBufferPool pool;
+	return pool;
+}
+
+//サイズからサイズクラスを取得
+std::int32_t fw::ImageBufferPool::getSizeClass(const size_t size)
+{
+	for (std::int32_t c = 0; c < CLASS_NUM; c++) {
+		if (size <= (size_t(1) << (CLASS_MIN_SHIFT + c))) {
+			return c;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,62 @@
+﻿#ifndef INCLUDED_IMAGEBUFFERPOOL_HPP
+#define INCLUDED_IMAGEBUFFERPOOL_HPP
+
+#include "Std.hpp"
+#include <mutex>
+#include <vector>
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// 画像バッファプールクラス
+	//
+	// デコード先や作業領域のバッファを2のべき乗のサイズクラス毎に
+	// 再利用し、定常状態でのヒープ確保をなくす。
+	// 複数スレッドから使用可能。
+	//
+	//----------------------------------------------------------
+
+	class ImageBufferPool {
+	public:
+		//最小サイズクラス(4KB)
+		static const std::int32_t CLASS_MIN_SHIFT = 12;
+		//サイズクラス数(4KB～512MB)
+		static const std::int32_t CLASS_NUM = 18;
+		//既定の保持上限バイト数
+		static const size_t DEFAULT_RETAIN_BYTE = 128 * 1024 * 1024;
+
+	private:
+		//メンバ変数
+		std::mutex					mutex_;					//排他
+		std::vector<std::uint8_t*>	freeList_[CLASS_NUM];	//サイズクラス毎の空きバッファ
+		size_t						retainByte_;			//保持上限バイト数
+		size_t						freeByte_;				//保持中の空きバイト数
+
+	public:
+		//コンストラクタ
+		ImageBufferPool(const size_t retainByte = DEFAULT_RETAIN_BYTE);
+		//デストラクタ
+		~ImageBufferPool();
+		//バッファを取得(capacityには実際の確保サイズを返す)
+		std::uint8_t* acquire(const size_t size, size_t* const capacity);
+		//バッファを返却
+		void release(std::uint8_t* const buffer, const size_t capacity);
+		//空きバッファを全て解放
+		void clear();
+
+		//既定のプールを取得
+		static ImageBufferPool& getDefault();
+
+		//コピーコンストラクタ(禁止)
+		ImageBufferPool(const ImageBufferPool& org) = delete;
+		//代入演算子(禁止)
+		ImageBufferPool& operator=(const ImageBufferPool& org) = delete;
+
+	private:
+		//サイズからサイズクラスを取得(該当なしは-1)
+		static std::int32_t getSizeClass(const size_t size);
+	};
+}
+
+#endif //INCLUDED_IMAGEBUFFERPOOL_HPP
@@ -0,0 +1,253 @@
+﻿#include "ImageCache.hpp"
+
+
+//----------------------------------------------------------
+//
+// 画像キャッシュキー
+//
+//----------------------------------------------------------
+
+//比較
+bool fw::ImageCacheKey::operator==(const ImageCacheKey& key) const
+{
+	//パレットはハッシュが一致した場合のみバイト単位で比較
+	return (this->id_ == key.id_) && (this->type_ == key.type_) && (this->isFlip_ == key.isFlip_) &&
+		(this->isBlend_ == key.isBlend_) && (this->option_ == key.option_) && (this->palleteHash_ == key.palleteHash_) &&
+		(this->blendData_ == key.blendData_) && (this->blendSize_ == key.blendSize_) &&
+		(this->pallete_ == key.pallete_) && (this->blendPallete_ == key.blendPallete_);
+}
+
+//画像からキーを作成
+fw::ImageCacheKey fw::ImageCacheKey::make(const Image& image)
+{
+	ImageCacheKey key;
+	key.id_ = image.id_;
+	key.type_ = image.type_;
+	key.isFlip_ = image.isFlip_;
+	key.isBlend_ = image.isBlend_;
+	//デコードサイズの指定が異なれば別エントリ
+	key.option_ = (std::uint32_t(image.body_.width_) & 0xFFFF) | ((std::uint32_t(image.body_.height_) & 0xFFFF) << 16);
+	//ブレンド画像が異なれば別エントリ
+	key.blendData_ = nullptr;
+	key.blendSize_ = 0;
+	if (image.isBlend_ == 1) {
+		key.blendData_ = image.blend_.data_;
+		key.blendSize_ = image.blend_.dataSize_;
+	}
+	//パレットを差し替えた画像は同じ画像IDでもパレット毎に別エントリ
+	key.palleteHash_ = 0;
+	copyPallete(image.body_, &key.pallete_);
+	if (image.isBlend_ == 1) {
+		copyPallete(image.blend_, &key.blendPallete_);
+	}
+	if (!key.pallete_.empty() || !key.blendPallete_.empty()) {
+		//FNV-1a(本体、ブレンドのR,G,B,Aの4バイトをパレット数分、境界を区別するため本体のバイト数を含める)
+		std::uint64_t hash = 14695981039346656037ULL;
+		hash = (hash ^ std::uint64_t(key.pallete_.size())) * 1099511628211ULL;
+		for (const std::uint8_t v : key.pallete_) {
+			hash = (hash ^ v) * 1099511628211ULL;
+		}
+		for (const std::uint8_t v : key.blendPallete_) {
+			hash = (hash ^ v) * 1099511628211ULL;
+		}
+		//差し替えなしの0と区別
+		key.palleteHash_ = (hash != 0) ? hash : 1;
+	}
+	return key;
+}
+
+//キャッシュ可能な画像か
+bool fw::ImageCacheKey::isCacheable(const Image& image)
+{
+	//画像IDが無効な画像は同一性を判定できない
+	return (image.id_ != 0);
+}
+
+//差し替えパレットをコピー(差し替えない場合は空)
+void fw::ImageCacheKey::copyPallete(const Image::ImageData& imageData, std::vector<std::uint8_t>* const pallete)
+{
+	pallete->clear();
+	if ((imageData.isChgPallete_ == 1) && (imageData.pallete_ != nullptr) && (imageData.palleteNum_ > 0)) {
+		//R,G,B,Aの4バイトをパレット数分
+		pallete->assign(imageData.pallete_, imageData.pallete_ + (size_t(imageData.palleteNum_) * 4));
+	}
+}
+
+//画像キャッシュキーのハッシュ
+size_t fw::ImageCacheKeyHash::operator()(const ImageCacheKey& key) const
+{
+	std::uint64_t v = 0;
+	v |= std::uint64_t(key.id_) << 0;
+	v |= std::uint64_t(key.type_) << 16;
+	v |= std::uint64_t(key.isFlip_) << 32;
+	v |= std::uint64_t(key.isBlend_) << 40;
+	const size_t h1 = std::hash<std::uint64_t>()(v);
+	const size_t h2 = std::hash<std::uint64_t>()(std::uint64_t(key.option_) ^ key.palleteHash_);
+	const size_t h3 = std::hash<const std::uint8_t*>()(key.blendData_);
+	const size_t h = h1 ^ (h2 + 0x9E3779B9 + (h1 << 6) + (h1 >> 2));
+	return h ^ (h3 + 0x9E3779B9 + (h << 6) + (h >> 2));
+}
+
+
+//----------------------------------------------------------
+//
+// 画像キャッシュクラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::ImageCache::ImageCache(const size_t budgetByte) :
+	entryList_(), entryMap_(), budgetByte_(budgetByte), usedByte_(0), releaseFunc_(nullptr), hit_(0), miss_(0), eviction_(0), preparedSet_()
+{
+}
+
+//デストラクタ
+fw::ImageCache::~ImageCache()
+{
+	//全エントリを解放
+	this->clear();
+}
+
+//エントリ解放関数を設定
+void fw::ImageCache::setReleaseFunc(const ReleaseFunc releaseFunc)
+{
+	this->releaseFunc_ = releaseFunc;
+}
+
+//上限バイト数を設定
+void fw::ImageCache::setBudget(const size_t budgetByte)
+{
+	this->budgetByte_ = budgetByte;
+	this->evict(0);
+}
+
+//検索
+const fw::ImageCacheEntry* fw::ImageCache::find(const ImageCacheKey& key)
+{
+	//先読みしたキーはミスとして数え済み(描画までに追い出された場合も数えない)
+	const bool isPrepared = (!this->preparedSet_.empty()) && (this->preparedSet_.erase(key) > 0);
+
+	auto itr = this->entryMap_.find(key);
+	if (itr == this->entryMap_.end()) {
+		//キャッシュミス
+		if (!isPrepared) {
+			this->miss_++;
+		}
+		return nullptr;
+	}
+
+	//キャッシュヒット:リスト先頭(最近使用)へ移動
+	if (!isPrepared) {
+		this->hit_++;
+	}
+	this->entryList_.splice(this->entryList_.begin(), this->entryList_, itr->second);
+	return &(*itr->second);
+}
+
+//登録済みか
+bool fw::ImageCache::contains(const ImageCacheKey& key) const
+{
+	return (this->entryMap_.find(key) != this->entryMap_.end());
+}
+
+//キャッシュ以外でヒットした検索を統計へ加える
+void fw::ImageCache::addHit(const ImageCacheKey& key)
+{
+	if ((!this->preparedSet_.empty()) && (this->preparedSet_.erase(key) > 0)) {
+		//先読みしたキーはミスとして数え済み
+		return;
+	}
+	this->hit_++;
+}
+
+//先読みでデコードして登録したキーをミスとして統計へ加える
+void fw::ImageCache::addPrepared(const ImageCacheKey& key)
+{
+	if (this->preparedSet_.insert(key).second) {
+		this->miss_++;
+	}
+}
+
+//フレーム開始
+void fw::ImageCache::beginFrame()
+{
+	this->preparedSet_.clear();
+}
+
+//追加
+const fw::ImageCacheEntry* fw::ImageCache::insert(const ImageCacheEntry& entry)
+{
+	if (entry.byteSize_ > this->budgetByte_) {
+		//上限を超える画像はキャッシュしない
+		return nullptr;
+	}
+
+	auto itr = this->entryMap_.find(entry.key_);
+	if (itr != this->entryMap_.end()) {
+		//同じキーのエントリは置き換え
+		this->usedByte_ -= itr->second->byteSize_;
+		this->release(*itr->second);
+		this->entryList_.erase(itr->second);
+		this->entryMap_.erase(itr);
+	}
+
+	//上限に収まるまで追い出し
+	this->evict(entry.byteSize_);
+
+	//リスト先頭(最近使用)へ追加
+	this->entryList_.push_front(entry);
+	this->entryMap_[entry.key_] = this->entryList_.begin();
+	this->usedByte_ += entry.byteSize_;
+
+	return &this->entryList_.front();
+}
+
+//全エントリを解放
+void fw::ImageCache::clear()
+{
+	for (auto itr = this->entryList_.cbegin(); itr != this->entryList_.cend(); itr++) {
+		this->release(*itr);
+	}
+	this->entryList_.clear();
+	this->entryMap_.clear();
+	this->usedByte_ = 0;
+}
+
+//統計を取得
+fw::ImageCacheStat fw::ImageCache::getStat() const
+{
+	ImageCacheStat stat;
+	stat.hit_ = this->hit_;
+	stat.miss_ = this->miss_;
+	stat.eviction_ = this->eviction_;
+	stat.entryNum_ = this->entryList_.size();
+	stat.usedByte_ = this->usedByte_;
+	stat.budgetByte_ = this->budgetByte_;
+	return stat;
+}
+
+//上限バイト数に収まるまで追い出し
+void fw::ImageCache::evict(const size_t needByte)
+{
+	while ((!this->entryList_.empty()) && ((this->usedByte_ + needByte) > this->budgetByte_)) {
+		//リスト末尾(最も長く使用されていない)から追い出し
+		const ImageCacheEntry& last = this->entryList_.back();
+		this->usedByte_ -= last.byteSize_;
+		this->release(last);
+		this->entryMap_.erase(last.key_);
+		this->entryList_.pop_back();
+		this->eviction_++;
+	}
+}
+
+//エントリを解放
+void fw::ImageCache::release(const ImageCacheEntry& entry)
+{
+	if (this->releaseFunc_ != nullptr) {
+		//テクスチャ削除など
+		this->releaseFunc_(entry);
+	}
+	if (entry.data_ != nullptr) {
+		delete[] entry.data_;
+	}
+}
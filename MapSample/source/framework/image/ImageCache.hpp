@@ -0,0 +1,135 @@
+﻿#ifndef INCLUDED_IMAGECACHE_HPP
+#define INCLUDED_IMAGECACHE_HPP
+
+#include "Std.hpp"
+#include "image/Image.hpp"
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fw {
+
+	//画像キャッシュキー
+	struct ImageCacheKey {
+		std::uint16_t	id_;			//画像ID
+		EN_ImageType	type_;			//画像タイプ
+		std::uint8_t	isFlip_;		//上下反転有無
+		std::uint8_t	isBlend_;		//ブレンド有無
+		std::uint32_t	option_;		//デコードオプション
+		std::uint64_t	palleteHash_;	//差し替えパレット(本体、ブレンド)のハッシュ(差し替えない場合は0)
+		const std::uint8_t*	blendData_;	//ブレンド画像データ(IDを持たないためデータの位置とサイズで区別、ブレンドなしはnullptr)
+		std::int32_t	blendSize_;		//ブレンド画像データサイズ
+		std::vector<std::uint8_t>	pallete_;		//本体の差し替えパレット(ハッシュ一致時にバイト単位で比較)
+		std::vector<std::uint8_t>	blendPallete_;	//ブレンド画像の差し替えパレット
+
+		//比較
+		bool operator==(const ImageCacheKey& key) const;
+		//画像からキーを作成
+		static ImageCacheKey make(const Image& image);
+		//キャッシュ可能な画像か
+		static bool isCacheable(const Image& image);
+
+	private:
+		//差し替えパレットをコピー(差し替えない場合は空)
+		static void copyPallete(const Image::ImageData& imageData, std::vector<std::uint8_t>* const pallete);
+	};
+
+	//画像キャッシュキーのハッシュ
+	struct ImageCacheKeyHash {
+		size_t operator()(const ImageCacheKey& key) const;
+	};
+
+	//画像キャッシュエントリ
+	struct ImageCacheEntry {
+		ImageCacheKey	key_;			//キー
+		std::int32_t	width_;			//幅
+		std::int32_t	height_;		//高さ
+		size_t			byteSize_;		//使用バイト数
+		std::uint32_t	texId_;			//テクスチャID(描画側で使用)
+		std::uint8_t*	data_;			//デコードデータ(保持しない場合はnullptr)
+	};
+
+	//画像キャッシュ統計
+	struct ImageCacheStat {
+		std::uint64_t	hit_;			//ヒット数(addHitで加えたアトラスのヒットを含む)
+		std::uint64_t	miss_;			//ミス数(addPreparedで加えた先読みのデコードを含む)
+		std::uint64_t	eviction_;		//追い出し数
+		size_t			entryNum_;		//エントリ数
+		size_t			usedByte_;		//使用バイト数
+		size_t			budgetByte_;	//上限バイト数
+	};
+
+	//----------------------------------------------------------
+	//
+	// 画像キャッシュクラス
+	//
+	// デコード済み画像(とそのテクスチャ)をLRUで保持する。
+	// 描画スレッドからのみ使用すること。
+	//
+	//----------------------------------------------------------
+
+	class ImageCache {
+	public:
+		//エントリ解放関数(テクスチャ削除など)
+		using ReleaseFunc = void(*)(const ImageCacheEntry& entry);
+
+		//既定の上限バイト数
+		static const size_t DEFAULT_BUDGET_BYTE = 64 * 1024 * 1024;
+
+	private:
+		using EntryList = std::list<ImageCacheEntry>;
+		using EntryMap = std::unordered_map<ImageCacheKey, EntryList::iterator, ImageCacheKeyHash>;
+		using KeySet = std::unordered_set<ImageCacheKey, ImageCacheKeyHash>;
+
+		//メンバ変数
+		EntryList		entryList_;		//エントリリスト(先頭が最近使用)
+		EntryMap		entryMap_;		//キー→エントリ
+		size_t			budgetByte_;	//上限バイト数
+		size_t			usedByte_;		//使用バイト数
+		ReleaseFunc		releaseFunc_;	//エントリ解放関数
+		std::uint64_t	hit_;			//ヒット数
+		std::uint64_t	miss_;			//ミス数
+		std::uint64_t	eviction_;		//追い出し数
+		KeySet			preparedSet_;	//このフレームで先読みして登録したキー(ミスとして数え済み)
+
+	public:
+		//コンストラクタ
+		ImageCache(const size_t budgetByte = DEFAULT_BUDGET_BYTE);
+		//デストラクタ
+		~ImageCache();
+		//エントリ解放関数を設定
+		void setReleaseFunc(const ReleaseFunc releaseFunc);
+		//上限バイト数を設定(超過分は追い出す)
+		void setBudget(const size_t budgetByte);
+		//検索(ヒットした場合は最近使用に更新、先読みしたキーの最初の検索は統計に数えない)
+		const ImageCacheEntry* find(const ImageCacheKey& key);
+		//登録済みか(統計、最近使用は更新しない)
+		bool contains(const ImageCacheKey& key) const;
+		//キャッシュ以外(アトラスなど)でヒットした検索を統計へ加える(先読みしたキーの最初の検索は数えない)
+		void addHit(const ImageCacheKey& key);
+		//先読みでデコードして登録したキーをミスとして統計へ加える(このフレームの最初の検索は数えない)
+		void addPrepared(const ImageCacheKey& key);
+		//フレーム開始(先読みしたキーの記録を破棄する)
+		void beginFrame();
+		//追加(上限を超える場合はLRUで追い出す。追加できない場合はnullptr)
+		const ImageCacheEntry* insert(const ImageCacheEntry& entry);
+		//全エントリを解放
+		void clear();
+		//統計を取得
+		ImageCacheStat getStat() const;
+
+		//コピーコンストラクタ(禁止)
+		ImageCache(const ImageCache& org) = delete;
+		//代入演算子(禁止)
+		ImageCache& operator=(const ImageCache& org) = delete;
+
+	private:
+		//上限バイト数に収まるまで追い出し
+		void evict(const size_t needByte);
+		//エントリを解放
+		void release(const ImageCacheEntry& entry);
+	};
+}
+
+#endif //INCLUDED_IMAGECACHE_HPP
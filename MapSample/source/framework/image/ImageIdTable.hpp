@@ -0,0 +1,76 @@
+﻿#ifndef INCLUDED_IMAGEIDTABLE_HPP
+#define INCLUDED_IMAGEIDTABLE_HPP
+
+#include "Std.hpp"
+#include <memory>
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// 画像IDテーブルクラス
+	//
+	// 16bitの画像IDから登録番号を引く2段のページテーブル。
+	// IDの上位8bitでページ、下位8bitでページ内の位置を引くため
+	// 登録数によらず検索は一定時間。ページは登録時に確保する。
+	//
+	//----------------------------------------------------------
+
+	class ImageIdTable {
+	public:
+		//未登録
+		static const std::int32_t INVALID_INDEX = -1;
+
+	private:
+		//ページ数、1ページの要素数
+		static const std::int32_t PAGE_SHIFT = 8;
+		static const std::int32_t PAGE_NUM = 256;
+		static const std::int32_t PAGE_SIZE = 256;
+
+		//メンバ変数
+		std::unique_ptr<std::int32_t[]>	pages_[PAGE_NUM];	//ページ(未使用はnullptr)
+
+	public:
+		//コンストラクタ
+		ImageIdTable() :
+			pages_()
+		{
+		}
+
+		//登録(同じIDは上書き)
+		void set(const std::uint16_t id, const std::int32_t index)
+		{
+			std::unique_ptr<std::int32_t[]>& page = this->pages_[id >> PAGE_SHIFT];
+			if (!page) {
+				//ページを確保して未登録で初期化
+				page.reset(new std::int32_t[PAGE_SIZE]);
+				for (std::int32_t i = 0; i < PAGE_SIZE; i++) {
+					page[i] = INVALID_INDEX;
+				}
+			}
+			page[id & (PAGE_SIZE - 1)] = index;
+		}
+
+		//検索(未登録はINVALID_INDEX)
+		std::int32_t find(const std::uint16_t id) const
+		{
+			const std::int32_t* const page = this->pages_[id >> PAGE_SHIFT].get();
+			return (page == nullptr) ? INVALID_INDEX : page[id & (PAGE_SIZE - 1)];
+		}
+
+		//全て削除
+		void clear()
+		{
+			for (std::int32_t i = 0; i < PAGE_NUM; i++) {
+				this->pages_[i].reset();
+			}
+		}
+
+		//コピーコンストラクタ(禁止)
+		ImageIdTable(const ImageIdTable& org) = delete;
+		//代入演算子(禁止)
+		ImageIdTable& operator=(const ImageIdTable& org) = delete;
+	};
+}
+
+#endif //INCLUDED_IMAGEIDTABLE_HPP
@@ -39,6 +39,41 @@ namespace {
 		{ fw::D_IMAGEID_JPEG_01, EN_ImageFormat::D_IMAGEFORMAT_JPEG, "jpeg/testorig.jpg", "", },
 		{ fw::D_IMAGEID_JPEG_02, EN_ImageFormat::D_IMAGEFORMAT_JPEG, "jpeg/testimgint.jpg", "", },
 	};
+
+	//画像ファイルを読み込み
+	//マップしてadviceでアクセス方法を通知し、マップしたファイルはmapFileで保持する(マップできない場合は読み込む)
+	static std::uint8_t* loadFile(const std::string& filePath, const fw::EN_FileAdvice advice, std::unique_ptr<fw::File>* const mapFile, std::int32_t* const size)
+	{
+		*size = 0;
+
+		std::unique_ptr<fw::File> file(new fw::File());
+		(void)file->create(filePath);
+		if (!file->open("rb")) {
+			//オープン失敗
+			return nullptr;
+		}
+		const size_t fileSize = size_t(file->getFileSize());
+
+		std::uint8_t* data = file->map();
+		if (data != nullptr) {
+			//マップ中はファイルを開いたまま保持(デコーダはページキャッシュを直接参照する)
+			file->advise(0, fileSize, advice);
+			*size = std::int32_t(fileSize);
+			*mapFile = std::move(file);
+			return data;
+		}
+
+		//ヒープに読み込み
+		data = new std::uint8_t[fileSize];
+		if (!file->read(data, 0, fileSize)) {
+			//読み込み失敗
+			delete[] data;
+			return nullptr;
+		}
+		*size = std::int32_t(fileSize);
+
+		return data;
+	}
 }
 
 
@@ -51,7 +86,7 @@ namespace {
 
 //コンストラクタ
 fw::LocalImage::LocalImage() :
-	imageList_()
+	mutex_(), imageList_(), idTable_(), archive_(), load_(D_LOCALIMAGELOAD_EAGER), residentMax_(DEFAULT_RESIDENT_BYTE), residentByte_(0), useCount_(0)
 {
 }
 
@@ -63,59 +98,40 @@ fw::LocalImage::~LocalImage()
 }
 
 //作成
-void fw::LocalImage::create()
+void fw::LocalImage::create(const EN_LocalImageLoad load, const size_t residentMax)
 {
-	//dataフォルダパス
-	const std::string dataPath = std::D_DATA_PATH;
+	std::lock_guard<std::mutex> lock(this->mutex_);
 
 	if (this->imageList_.empty()) {
 		//未作成の場合のみ
+		this->load_ = load;
+		this->residentMax_ = residentMax;
+		this->residentByte_ = 0;
 
 		//画像データリストの領域を確保しておく(画像ファイル数分)
 		this->imageList_.resize(tblImageFiles.size());
 
-		//画像データリストのはじめのイテレータ
-		auto itrImage = this->imageList_.begin();
-
 		//画像ファイル数分ループ
-		for (auto itrFile = tblImageFiles.cbegin(); itrFile != tblImageFiles.cend(); itrFile++) {
-			std::uint8_t* body = nullptr;
-			size_t bodySize = 0;
-			std::uint8_t* blend = nullptr;
-			size_t blendSize = 0;
-
-			if (!itrFile->bodyFile_.empty()) {
-				//本体画像ファイル読み込み
-				fw::File bodyFile;
-				bodyFile.create(dataPath + "/" + itrFile->bodyFile_);
-				bodyFile.open("rb");
-				bodySize = bodyFile.getFileSize();
-				body = new std::uint8_t[bodySize];
-				(void)bodyFile.read(&body, 0, bodySize);
-			}
+		for (size_t i = 0; i < tblImageFiles.size(); i++) {
+			//画像データ作成
+			LocalImageEntry& entry = this->imageList_[i];
+			entry.data_.id_ = tblImageFiles[i].id_;
+			entry.data_.format_ = tblImageFiles[i].format_;
+			entry.data_.body_ = nullptr;
+			entry.data_.bodySize_ = 0;
+			entry.data_.blend_ = nullptr;
+			entry.data_.blendSize_ = 0;
+			entry.isLoaded_ = false;
+			entry.isResident_ = false;
+			entry.lastUse_ = 0;
 
-			if (!itrFile->blendFile_.empty()) {
-				//ブレンド画像ファイル読み込み
-				fw::File blendFile;
-				blendFile.create(dataPath + "/" + itrFile->blendFile_);
-				blendFile.open("rb");
-				blendSize = blendFile.getFileSize();
-				blend = new std::uint8_t[blendSize];
-				(void)blendFile.read(&blend, 0, blendSize);
-			}
+			//画像IDから引けるよう登録
+			this->idTable_.set(entry.data_.id_, std::int32_t(i));
 
-			//画像データ作成
-			LocalImageData imageData;
-			imageData.id_ = itrFile->id_;
-			imageData.format_ = itrFile->format_;
-			imageData.body_ = body;
-			imageData.bodySize_ = bodySize;
-			imageData.blend_ = blend;
-			imageData.blendSize_ = blendSize;
-
-			//画像データリストに追加
-			*itrImage = imageData;
-			itrImage++;
+			if (this->load_ == D_LOCALIMAGELOAD_EAGER) {
+				//画像ファイル読み込み
+				this->load(i);
+			}
 		}
 	}
 	else {
@@ -123,41 +139,204 @@ void fw::LocalImage::create()
 	}
 }
 
+//画像アーカイブから作成
+bool fw::LocalImage::createFromArchive(const std::string& archivePath, const size_t residentMax)
+{
+	std::lock_guard<std::mutex> lock(this->mutex_);
+
+	if (!this->imageList_.empty()) {
+		//作成済み
+		return false;
+	}
+	if (!this->archive_.open(archivePath)) {
+		//アーカイブなし、不正なアーカイブ
+		return false;
+	}
+	this->load_ = D_LOCALIMAGELOAD_ARCHIVE;
+	this->residentMax_ = residentMax;
+	this->residentByte_ = 0;
+
+	//画像データリストの領域を確保しておく(アーカイブ内の画像数分)
+	const std::int32_t entryNum = this->archive_.getEntryNum();
+	this->imageList_.resize(size_t(entryNum));
+
+	//画像データはマップ先をそのまま参照
+	for (std::int32_t i = 0; i < entryNum; i++) {
+		ImageArchiveEntry archiveEntry;
+		(void)this->archive_.getEntry(i, &archiveEntry);
+
+		LocalImageEntry& entry = this->imageList_[i];
+		entry.data_.id_ = archiveEntry.id_;
+		entry.data_.format_ = archiveEntry.format_;
+		entry.data_.body_ = archiveEntry.body_;
+		entry.data_.bodySize_ = archiveEntry.bodySize_;
+		entry.data_.blend_ = archiveEntry.blend_;
+		entry.data_.blendSize_ = archiveEntry.blendSize_;
+		entry.isLoaded_ = true;
+		entry.isResident_ = false;
+		entry.lastUse_ = 0;
+
+		//画像IDから引けるよう登録
+		this->idTable_.set(entry.data_.id_, i);
+	}
+
+	return true;
+}
+
 //解放
 void fw::LocalImage::free()
 {
+	std::lock_guard<std::mutex> lock(this->mutex_);
+
 	//画像データ数分ループ
 	for (auto itrImage = this->imageList_.cbegin(); itrImage != this->imageList_.cend(); itrImage++) {
-		if (itrImage->body_ != nullptr) {
-			delete[] itrImage->body_;
+		if (this->load_ == D_LOCALIMAGELOAD_ARCHIVE) {
+			//アーカイブのクローズで解除
+			break;
+		}
+
+		//マップしたデータはファイルのクローズで解除
+		if ((itrImage->data_.body_ != nullptr) && !itrImage->bodyFile_) {
+			delete[] itrImage->data_.body_;
 		}
-		if (itrImage->blend_ != nullptr) {
-			delete[] itrImage->blend_;
+		if ((itrImage->data_.blend_ != nullptr) && !itrImage->blendFile_) {
+			delete[] itrImage->data_.blend_;
 		}
 	}
 
 	//画像データリストのクリア
 	this->imageList_.clear();
+	this->idTable_.clear();
+	this->archive_.close();
+	this->residentByte_ = 0;
 }
 
 //取得
-void fw::LocalImage::getImage(const std::uint16_t id, LocalImageData* const localImage)
+const fw::LocalImageData* fw::LocalImage::getImage(const std::uint16_t id)
 {
-	//出力を初期化
-	localImage->id_ = D_IMAGEID_INVALID;
-	localImage->format_ = EN_ImageFormat::D_IMAGEFORMAT_RGBA8888;
-	localImage->body_ = nullptr;
-	localImage->bodySize_ = 0;
-	localImage->blend_ = nullptr;
-	localImage->blendSize_ = 0;
+	std::lock_guard<std::mutex> lock(this->mutex_);
 
-	//画像データ数分ループ
-	for (auto itrImage = this->imageList_.cbegin(); itrImage != this->imageList_.cend(); itrImage++) {
-		//画像IDが一致するものを検索
-		if (itrImage->id_ == id) {
-			//画像ID一致
-			*localImage = *itrImage;
+	//画像IDから画像データリストの位置を検索
+	const std::int32_t index = this->idTable_.find(id);
+	if (index == ImageIdTable::INVALID_INDEX) {
+		//未登録
+		return nullptr;
+	}
+
+	LocalImageEntry& entry = this->imageList_[index];
+	if (!entry.isLoaded_) {
+		//初回取得時に読み込み
+		this->load(size_t(index));
+	}
+	entry.lastUse_ = ++this->useCount_;
+
+	//マップした画像は常駐バイト数に計上し、上限を超えた分を解放
+	const size_t mappedByte = this->getMappedByte(entry);
+	if (!entry.isResident_ && (mappedByte > 0)) {
+		entry.isResident_ = true;
+		this->residentByte_ += mappedByte;
+		this->trim(size_t(index));
+	}
+
+	return &entry.data_;
+}
+
+//画像ファイルを読み込み
+void fw::LocalImage::load(const size_t index)
+{
+	//dataフォルダパス
+	const std::string dataPath = std::D_DATA_PATH;
+
+	const ImageFile& file = tblImageFiles[index];
+	LocalImageEntry& entry = this->imageList_[index];
+	//作成時に読み込む場合は先読みし、初回取得時の場合はすぐにデコードするため順次参照とする
+	const EN_FileAdvice advice = (this->load_ == D_LOCALIMAGELOAD_EAGER) ? D_FILEADVICE_WILLNEED : D_FILEADVICE_SEQUENTIAL;
+
+	if (!file.bodyFile_.empty()) {
+		//本体画像ファイル読み込み
+		entry.data_.body_ = loadFile(dataPath + "/" + file.bodyFile_, advice, &entry.bodyFile_, &entry.data_.bodySize_);
+	}
+
+	if (!file.blendFile_.empty()) {
+		//ブレンド画像ファイル読み込み
+		entry.data_.blend_ = loadFile(dataPath + "/" + file.blendFile_, advice, &entry.blendFile_, &entry.data_.blendSize_);
+	}
+
+	entry.isLoaded_ = true;
+}
+
+//常駐バイト数が上限以下になるまで物理ページを解放
+void fw::LocalImage::trim(const size_t except)
+{
+	while (this->residentByte_ > this->residentMax_) {
+		//最も長く取得されていない常駐中の画像を検索
+		LocalImageEntry* oldest = nullptr;
+		for (size_t i = 0; i < this->imageList_.size(); i++) {
+			LocalImageEntry& entry = this->imageList_[i];
+			if ((i != except) && entry.isResident_ && ((oldest == nullptr) || (entry.lastUse_ < oldest->lastUse_))) {
+				oldest = &entry;
+			}
+		}
+		if (oldest == nullptr) {
+			//解放できる画像なし
 			break;
 		}
+
+		//物理ページを解放(マップは維持するため取得済みのポインタは有効)
+		this->releasePages(*oldest);
+		this->residentByte_ -= this->getMappedByte(*oldest);
+		oldest->isResident_ = false;
 	}
 }
+
+//画像のうちマップしているバイト数を取得
+size_t fw::LocalImage::getMappedByte(const LocalImageEntry& entry) const
+{
+	if (this->load_ == D_LOCALIMAGELOAD_ARCHIVE) {
+		//全てアーカイブのマップ先
+		return size_t(entry.data_.bodySize_) + size_t(entry.data_.blendSize_);
+	}
+
+	size_t mappedByte = 0;
+	mappedByte += (entry.bodyFile_) ? size_t(entry.data_.bodySize_) : 0;
+	mappedByte += (entry.blendFile_) ? size_t(entry.data_.blendSize_) : 0;
+	return mappedByte;
+}
+
+//画像の物理ページを解放
+void fw::LocalImage::releasePages(const LocalImageEntry& entry)
+{
+	if (this->load_ == D_LOCALIMAGELOAD_ARCHIVE) {
+		//前後の画像と共有するページは残る
+		this->archive_.releasePages(entry.data_.body_, size_t(entry.data_.bodySize_));
+		this->archive_.releasePages(entry.data_.blend_, size_t(entry.data_.blendSize_));
+		return;
+	}
+
+	if (entry.bodyFile_) {
+		entry.bodyFile_->releasePages(0, size_t(entry.data_.bodySize_));
+	}
+	if (entry.blendFile_) {
+		entry.blendFile_->releasePages(0, size_t(entry.data_.blendSize_));
+	}
+}
+
+//画像ファイルテーブルの全画像から画像アーカイブを作成
+bool fw::LocalImage::writeArchive(const std::string& archivePath)
+{
+	//dataフォルダパス
+	const std::string dataPath = std::D_DATA_PATH;
+
+	std::vector<ImageArchiveSource> sources;
+	sources.reserve(tblImageFiles.size());
+	for (auto itrFile = tblImageFiles.cbegin(); itrFile != tblImageFiles.cend(); itrFile++) {
+		ImageArchiveSource source;
+		source.id_ = itrFile->id_;
+		source.format_ = itrFile->format_;
+		source.bodyPath_ = dataPath + "/" + itrFile->bodyFile_;
+		source.blendPath_ = (itrFile->blendFile_.empty()) ? "" : (dataPath + "/" + itrFile->blendFile_);
+		sources.push_back(source);
+	}
+
+	return ImageArchive::write(archivePath, sources);
+}
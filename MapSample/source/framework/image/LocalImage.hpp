@@ -3,6 +3,12 @@
 
 #include "Std.hpp"
 #include "image/Image.hpp"
+#include "image/ImageArchive.hpp"
+#include "image/ImageIdTable.hpp"
+#include "io/File.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace fw {
@@ -34,6 +40,16 @@ namespace fw {
 	static const std::uint16_t D_IMAGEID_JPEG_01 = D_IMAGEID_JPEG | 0x0001;
 	static const std::uint16_t D_IMAGEID_JPEG_02 = D_IMAGEID_JPEG | 0x0002;
 
+	//ソフト持ち画像の読み込みモード
+	enum EN_LocalImageLoad : std::uint16_t {
+		D_LOCALIMAGELOAD_EAGER,		//作成時に全画像ファイルをマップして先読み(マップできない場合は読み込む)
+		D_LOCALIMAGELOAD_LAZY,		//初回取得時に画像ファイルをマップ(マップできない場合は読み込む)
+		D_LOCALIMAGELOAD_ARCHIVE,	//画像アーカイブ全体をマップ(createFromArchiveで作成)
+	};
+
+	//ソフト持ち画像アーカイブのファイル名(dataフォルダ直下)
+	static const std::char_t* const D_LOCALIMAGE_ARCHIVE_FILE = "localimage.fwia";
+
 	struct LocalImageData {
 		std::uint16_t		id_;
 		fw::EN_ImageFormat	format_;
@@ -44,26 +60,68 @@ namespace fw {
 	};
 
 	//ソフト持ち画像管理クラス
+	//
+	//画像データはマップしたまま保持し(マップできない場合のみヒープへ読み込む)、
+	//常駐バイト数が上限を超えると最も長く取得されていない画像の物理ページを解放する。
+	//解放後も取得済みのポインタは有効(再アクセス時にファイルから読み直される)。
 	class LocalImage {
+	public:
+		//既定の常駐上限バイト数(マップした画像のみ)
+		static const size_t DEFAULT_RESIDENT_BYTE = 32 * 1024 * 1024;
+
+	private:
+		//画像データ(遅延読み込みの状態を含む)
+		struct LocalImageEntry {
+			LocalImageData			data_;			//画像データ
+			std::unique_ptr<File>	bodyFile_;		//本体画像ファイル(マップ中のみ)
+			std::unique_ptr<File>	blendFile_;		//ブレンド画像ファイル(マップ中のみ)
+			bool					isLoaded_;		//読み込み済み(マップ済み含む)
+			bool					isResident_;	//常駐バイト数に計上中
+			std::uint64_t			lastUse_;		//最終取得順
+		};
+
 		//メンバ変数
-		std::vector<LocalImageData> imageList_;
+		std::mutex						mutex_;			//排他
+		std::vector<LocalImageEntry>	imageList_;		//画像データリスト
+		ImageIdTable					idTable_;		//画像ID→画像データリストの位置
+		ImageArchive					archive_;		//画像アーカイブ(アーカイブから作成した場合のみ)
+		EN_LocalImageLoad				load_;			//読み込みモード
+		size_t							residentMax_;	//常駐上限バイト数
+		size_t							residentByte_;	//常駐バイト数(マップした画像のみ)
+		std::uint64_t					useCount_;		//取得回数
 
 	public:
 		//コンストラクタ
 		LocalImage();
 		//デストラクタ
 		~LocalImage();
-		//作成
-		void create();
+		//作成(遅延読み込みの場合は画像ファイルを開かない)
+		void create(const EN_LocalImageLoad load = D_LOCALIMAGELOAD_EAGER, const size_t residentMax = DEFAULT_RESIDENT_BYTE);
+		//画像アーカイブから作成(アーカイブ全体を1回でマップ、開けない場合はfalse)
+		bool createFromArchive(const std::string& archivePath, const size_t residentMax = DEFAULT_RESIDENT_BYTE);
 		//解放
 		void free();
-		//取得
-		void getImage(const std::uint16_t id, LocalImageData* const localImage);
+		//取得(遅延読み込みの場合は初回取得時に読み込む)
+		//未登録の画像IDはnullptr、戻り値はfree()まで有効
+		const LocalImageData* getImage(const std::uint16_t id);
+
+		//画像ファイルテーブルの全画像から画像アーカイブを作成
+		static bool writeArchive(const std::string& archivePath);
 
 		//コピーコンストラクタ(禁止)
 		LocalImage(const LocalImage& org) = delete;
 		//代入演算子(禁止)
 		LocalImage& operator=(const LocalImage& org) = delete;
+
+	private:
+		//画像ファイルをマップ(マップできない場合は読み込む)
+		void load(const size_t index);
+		//常駐バイト数が上限以下になるまで物理ページを解放(exceptは対象外)
+		void trim(const size_t except);
+		//画像のうちマップしているバイト数を取得
+		size_t getMappedByte(const LocalImageEntry& entry) const;
+		//画像の物理ページを解放
+		void releasePages(const LocalImageEntry& entry);
 	};
 }
 
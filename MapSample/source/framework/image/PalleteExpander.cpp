@@ -0,0 +1,379 @@
+﻿#include "PalleteExpander.hpp"
+#include "Cpu.hpp"
+
+#include <cstring>
+
+#if defined(FW_CPU_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+#if defined(FW_CPU_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+	//RGBA8888画像の1ピクセルあたりのバイト数
+	static const std::int32_t BYTE_PER_PIXEL_RGBA8888 = 4;
+
+	//1バイト展開テーブルの1エントリあたりのピクセル数(1bit時の8ピクセル分)
+	static const std::int32_t BYTETABLE_STRIDE = 8;
+}
+
+
+//----------------------------------------------------------
+//
+// パレット展開クラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::PalleteExpander::PalleteExpander(const std::int32_t bitDepth) :
+	bitDepth_(bitDepth), pixelPerByte_(0), path_(D_EXPANDPATH_SCALAR), pallete_()
+{
+	if ((bitDepth == 1) || (bitDepth == 2) || (bitDepth == 4) || (bitDepth == 8)) {
+		this->pixelPerByte_ = 8 / bitDepth;
+	}
+	else {
+		//未対応のビット深度は展開しない
+		this->bitDepth_ = 0;
+	}
+
+	//未設定のインデックスは黒(不透明)
+	for (std::int32_t i = 0; i < PALLETE_MAXNUM; i++) {
+		this->setColor(i, 0, 0, 0, 255);
+	}
+
+	//展開処理パスを選択
+	this->path_ = selectPath();
+}
+
+//パレット色を設定
+void fw::PalleteExpander::setColor(const std::int32_t index, const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a)
+{
+	if ((index >= 0) && (index < PALLETE_MAXNUM)) {
+		//メモリ上でR,G,B,Aの順に並ぶように格納
+		const std::uint8_t rgba[BYTE_PER_PIXEL_RGBA8888] = { r, g, b, a };
+		(void)std::memcpy(&this->pallete_[index], rgba, BYTE_PER_PIXEL_RGBA8888);
+	}
+}
+
+//パレット色を取得
+std::uint32_t fw::PalleteExpander::getColor(const std::uint8_t index) const
+{
+	return this->pallete_[index];
+}
+
+//展開テーブルを作成
+void fw::PalleteExpander::build()
+{
+	if ((this->bitDepth_ == 0) || (this->bitDepth_ == 8)) {
+		//8bitはパレットをそのまま引くためテーブル不要
+		return;
+	}
+
+	//バイト値毎に、含まれるピクセル分のRGBA値を上位ビットから並べる
+	const std::uint32_t bitMask = (0x01 << this->bitDepth_) - 1;
+	for (std::int32_t v = 0; v < PALLETE_MAXNUM; v++) {
+		std::uint32_t* const entry = &this->byteTable_[v * BYTETABLE_STRIDE];
+		std::int32_t bitOfs = 8 - this->bitDepth_;
+		for (std::int32_t p = 0; p < this->pixelPerByte_; p++) {
+			entry[p] = this->pallete_[(std::uint32_t(v) >> bitOfs) & bitMask];
+			bitOfs -= this->bitDepth_;
+		}
+	}
+}
+
+//展開処理パスを設定
+void fw::PalleteExpander::setPath(const EN_ExpandPath path)
+{
+	this->path_ = path;
+}
+
+//展開処理パスを取得
+fw::PalleteExpander::EN_ExpandPath fw::PalleteExpander::getPath() const
+{
+	return this->path_;
+}
+
+//1行展開
+void fw::PalleteExpander::expandRow(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	switch (this->path_) {
+	case D_EXPANDPATH_SSE2:		this->expandRowSse2(src, dst, width);	break;
+	case D_EXPANDPATH_AVX2:		this->expandRowAvx2(src, dst, width);	break;
+	case D_EXPANDPATH_NEON:		this->expandRowNeon(src, dst, width);	break;
+	default:					this->expandRowTable(src, dst, width);	break;
+	}
+}
+
+//1行展開(スカラー参照実装)
+void fw::PalleteExpander::expandRowScalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	if (this->bitDepth_ == 0) {
+		return;
+	}
+
+	//ビット深度に応じたビットオフセットとビットマスク
+	std::int32_t readOffset = 0;
+	std::int32_t bitOfs = 8 - this->bitDepth_;
+	const std::uint8_t bitMask = (0x01 << this->bitDepth_) - 1;
+
+	std::int32_t writeOffset = 0;
+	for (std::int32_t w = 0; w < width; w++) {
+		//画像データはパレットインデックス
+		const std::uint8_t index = (src[readOffset] >> bitOfs) & bitMask;
+
+		//出力データへRGBA値を設定
+		(void)std::memcpy(dst + writeOffset, &this->pallete_[index], BYTE_PER_PIXEL_RGBA8888);
+
+		//ビットオフセットを更新
+		bitOfs -= this->bitDepth_;
+		if (bitOfs < 0) {
+			//次の読み込み位置に更新
+			bitOfs = 8 - this->bitDepth_;
+			readOffset++;
+		}
+		//書き込み位置を更新
+		writeOffset += BYTE_PER_PIXEL_RGBA8888;
+	}
+}
+
+//CPU機能から展開処理パスを選択
+fw::PalleteExpander::EN_ExpandPath fw::PalleteExpander::selectPath()
+{
+	if (fw::Cpu::hasAvx2()) {
+		return D_EXPANDPATH_AVX2;
+	}
+	if (fw::Cpu::hasSse2()) {
+		return D_EXPANDPATH_SSE2;
+	}
+	if (fw::Cpu::hasNeon()) {
+		return D_EXPANDPATH_NEON;
+	}
+	return D_EXPANDPATH_SCALAR;
+}
+
+//1行展開(バイトテーブル)
+//SIMD各パスの端数処理も兼ねる
+void fw::PalleteExpander::expandRowTable(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	if (this->bitDepth_ == 0) {
+		return;
+	}
+
+	if (this->bitDepth_ == 8) {
+		//8bit:1バイト=1ピクセル
+		for (std::int32_t w = 0; w < width; w++) {
+			(void)std::memcpy(dst + (w * BYTE_PER_PIXEL_RGBA8888), &this->pallete_[src[w]], BYTE_PER_PIXEL_RGBA8888);
+		}
+		return;
+	}
+
+	//1/2/4bit:1バイト分のピクセルをまとめてコピー
+	const std::int32_t ppb = this->pixelPerByte_;
+	const std::int32_t fullByte = width / ppb;
+	const std::int32_t restPixel = width % ppb;
+	const std::int32_t byteWrite = ppb * BYTE_PER_PIXEL_RGBA8888;
+
+	std::uint8_t* wp = dst;
+	for (std::int32_t i = 0; i < fullByte; i++) {
+		(void)std::memcpy(wp, &this->byteTable_[src[i] * BYTETABLE_STRIDE], byteWrite);
+		wp += byteWrite;
+	}
+	if (restPixel > 0) {
+		//行末の端数ピクセル
+		(void)std::memcpy(wp, &this->byteTable_[src[fullByte] * BYTETABLE_STRIDE], restPixel * BYTE_PER_PIXEL_RGBA8888);
+	}
+}
+
+#if defined(FW_CPU_X86)
+
+//1行展開(SSE2)
+FW_TARGET_SSE2
+void fw::PalleteExpander::expandRowSse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	//SIMDで処理したピクセル数
+	std::int32_t done = 0;
+
+	if ((this->bitDepth_ == 8) || (this->bitDepth_ == 0)) {
+		//8bitはギャザー命令がなくパレット参照が1ピクセルずつになるため、テーブル展開と同じ処理で行う
+		this->expandRowTable(src, dst, width);
+		return;
+	}
+
+	const std::int32_t ppb = this->pixelPerByte_;
+	const std::int32_t fullByte = width / ppb;
+	std::int32_t i = 0;
+	std::uint8_t* wp = dst;
+
+	if (this->bitDepth_ == 1) {
+		//1バイト→8ピクセル(32バイト)
+		for (; i < fullByte; i++) {
+			const std::uint32_t* const e = &this->byteTable_[src[i] * BYTETABLE_STRIDE];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 0), _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + 0)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp + 16), _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + 4)));
+			wp += 32;
+		}
+	}
+	else if (this->bitDepth_ == 2) {
+		//1バイト→4ピクセル(16バイト)
+		for (; i < fullByte; i++) {
+			const std::uint32_t* const e = &this->byteTable_[src[i] * BYTETABLE_STRIDE];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp), _mm_loadu_si128(reinterpret_cast<const __m128i*>(e)));
+			wp += 16;
+		}
+	}
+	else {
+		//2バイト→4ピクセル(16バイト)
+		for (; (i + 2) <= fullByte; i += 2) {
+			const __m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 0] * BYTETABLE_STRIDE]));
+			const __m128i hi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 1] * BYTETABLE_STRIDE]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(wp), _mm_unpacklo_epi64(lo, hi));
+			wp += 16;
+		}
+	}
+
+	//端数はテーブル展開
+	done = i * ppb;
+	this->expandRowTable(src + i, wp, width - done);
+}
+
+//1行展開(AVX2)
+FW_TARGET_AVX2
+void fw::PalleteExpander::expandRowAvx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	//SIMDで処理したピクセル数
+	std::int32_t done = 0;
+
+	if (this->bitDepth_ == 8) {
+		//8ピクセルずつパレットをギャザー
+		const int* const pallete = reinterpret_cast<const int*>(this->pallete_);
+		for (; (done + 8) <= width; done += 8) {
+			const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + done)));
+			const __m256i v = _mm256_i32gather_epi32(pallete, index, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (done * BYTE_PER_PIXEL_RGBA8888)), v);
+		}
+		this->expandRowTable(src + done, dst + (done * BYTE_PER_PIXEL_RGBA8888), width - done);
+		return;
+	}
+	if (this->bitDepth_ == 0) {
+		return;
+	}
+
+	const std::int32_t ppb = this->pixelPerByte_;
+	const std::int32_t fullByte = width / ppb;
+	std::int32_t i = 0;
+	std::uint8_t* wp = dst;
+
+	if (this->bitDepth_ == 1) {
+		//1バイト→8ピクセル(32バイト)
+		for (; i < fullByte; i++) {
+			const std::uint32_t* const e = &this->byteTable_[src[i] * BYTETABLE_STRIDE];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(e)));
+			wp += 32;
+		}
+	}
+	else if (this->bitDepth_ == 2) {
+		//2バイト→8ピクセル(32バイト)
+		for (; (i + 2) <= fullByte; i += 2) {
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 0] * BYTETABLE_STRIDE]));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 1] * BYTETABLE_STRIDE]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp), _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+			wp += 32;
+		}
+	}
+	else {
+		//4バイト→8ピクセル(32バイト)
+		for (; (i + 4) <= fullByte; i += 4) {
+			const __m128i p0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 0] * BYTETABLE_STRIDE]));
+			const __m128i p1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 1] * BYTETABLE_STRIDE]));
+			const __m128i p2 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 2] * BYTETABLE_STRIDE]));
+			const __m128i p3 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&this->byteTable_[src[i + 3] * BYTETABLE_STRIDE]));
+			const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi64(p0, p1)), _mm_unpacklo_epi64(p2, p3), 1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(wp), v);
+			wp += 32;
+		}
+	}
+
+	//端数はテーブル展開
+	done = i * ppb;
+	this->expandRowTable(src + i, wp, width - done);
+}
+
+#else //FW_CPU_X86
+
+//1行展開(SSE2)
+void fw::PalleteExpander::expandRowSse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	this->expandRowTable(src, dst, width);
+}
+
+//1行展開(AVX2)
+void fw::PalleteExpander::expandRowAvx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	this->expandRowTable(src, dst, width);
+}
+
+#endif //FW_CPU_X86
+
+#if defined(FW_CPU_NEON)
+
+//1行展開(NEON)
+void fw::PalleteExpander::expandRowNeon(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	//SIMDで処理したピクセル数
+	std::int32_t done = 0;
+
+	if ((this->bitDepth_ == 8) || (this->bitDepth_ == 0)) {
+		//8bitはギャザー命令がなくパレット参照が1ピクセルずつになるため、テーブル展開と同じ処理で行う
+		this->expandRowTable(src, dst, width);
+		return;
+	}
+
+	const std::int32_t ppb = this->pixelPerByte_;
+	const std::int32_t fullByte = width / ppb;
+	std::int32_t i = 0;
+	std::uint8_t* wp = dst;
+
+	if (this->bitDepth_ == 1) {
+		//1バイト→8ピクセル(32バイト)
+		for (; i < fullByte; i++) {
+			const std::uint32_t* const e = &this->byteTable_[src[i] * BYTETABLE_STRIDE];
+			vst1q_u32(reinterpret_cast<std::uint32_t*>(wp + 0), vld1q_u32(e + 0));
+			vst1q_u32(reinterpret_cast<std::uint32_t*>(wp + 16), vld1q_u32(e + 4));
+			wp += 32;
+		}
+	}
+	else if (this->bitDepth_ == 2) {
+		//1バイト→4ピクセル(16バイト)
+		for (; i < fullByte; i++) {
+			const std::uint32_t* const e = &this->byteTable_[src[i] * BYTETABLE_STRIDE];
+			vst1q_u32(reinterpret_cast<std::uint32_t*>(wp), vld1q_u32(e));
+			wp += 16;
+		}
+	}
+	else {
+		//2バイト→4ピクセル(16バイト)
+		for (; (i + 2) <= fullByte; i += 2) {
+			const uint32x2_t lo = vld1_u32(&this->byteTable_[src[i + 0] * BYTETABLE_STRIDE]);
+			const uint32x2_t hi = vld1_u32(&this->byteTable_[src[i + 1] * BYTETABLE_STRIDE]);
+			vst1q_u32(reinterpret_cast<std::uint32_t*>(wp), vcombine_u32(lo, hi));
+			wp += 16;
+		}
+	}
+
+	//端数はテーブル展開
+	done = i * ppb;
+	this->expandRowTable(src + i, wp, width - done);
+}
+
+#else //FW_CPU_NEON
+
+//1行展開(NEON)
+void fw::PalleteExpander::expandRowNeon(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const
+{
+	this->expandRowTable(src, dst, width);
+}
+
+#endif //FW_CPU_NEON
@@ -0,0 +1,73 @@
+﻿#ifndef INCLUDED_PALLETEEXPANDER_HPP
+#define INCLUDED_PALLETEEXPANDER_HPP
+
+#include "Std.hpp"
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// パレット展開クラス
+	//
+	// パレットインデックス(1/2/4/8bit)の行をRGBA8888へ展開する。
+	// パレットは画像毎に一度だけRGBA8888テーブル化し、
+	// 1/2/4bitは1バイト分のインデックスをまとめて展開する。
+	// 8bitのSIMD展開はAVX2のギャザーのみで、SSE2,NEONはテーブル展開(スカラー)と同じ処理となる。
+	//
+	//----------------------------------------------------------
+
+	class PalleteExpander {
+	public:
+		//パレット最大数(256色)
+		static const std::int32_t PALLETE_MAXNUM = 256;
+
+		//展開処理パス
+		enum EN_ExpandPath {
+			D_EXPANDPATH_SCALAR,	//スカラー(参照実装)
+			D_EXPANDPATH_SSE2,		//SSE2
+			D_EXPANDPATH_AVX2,		//AVX2
+			D_EXPANDPATH_NEON,		//NEON
+		};
+
+	private:
+		//メンバ変数
+		std::int32_t	bitDepth_;		//ビット深度(1,2,4,8)
+		std::int32_t	pixelPerByte_;	//1バイトあたりのピクセル数
+		EN_ExpandPath	path_;			//展開処理パス
+		std::uint32_t	pallete_[PALLETE_MAXNUM];		//パレット(RGBA8888)
+		std::uint32_t	byteTable_[PALLETE_MAXNUM * 8];	//1バイト展開テーブル(1/2/4bitのみ)
+
+	public:
+		//コンストラクタ
+		PalleteExpander(const std::int32_t bitDepth);
+		//パレット色を設定
+		void setColor(const std::int32_t index, const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a);
+		//パレット色を取得(メモリ上でR,G,B,Aの順に並ぶ値)
+		std::uint32_t getColor(const std::uint8_t index) const;
+		//展開テーブルを作成(パレット色の設定後に1度だけ呼ぶ)
+		void build();
+		//展開処理パスを設定(既定はCPU機能から自動選択)
+		void setPath(const EN_ExpandPath path);
+		//展開処理パスを取得
+		EN_ExpandPath getPath() const;
+		//1行展開
+		void expandRow(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const;
+		//1行展開(スカラー参照実装)
+		void expandRowScalar(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const;
+
+		//CPU機能から展開処理パスを選択
+		static EN_ExpandPath selectPath();
+
+	private:
+		//1行展開(バイトテーブル)
+		void expandRowTable(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const;
+		//1行展開(SSE2)
+		void expandRowSse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const;
+		//1行展開(AVX2)
+		void expandRowAvx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const;
+		//1行展開(NEON)
+		void expandRowNeon(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width) const;
+	};
+}
+
+#endif //INCLUDED_PALLETEEXPANDER_HPP
@@ -0,0 +1,1091 @@
+﻿#include "PixelConv.hpp"
+#include "Cpu.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(FW_CPU_X86)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#endif
+#if defined(FW_CPU_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+	using fw::EN_PixelFormat;
+	using fw::EN_DecodeFormat;
+
+	//RGBA8888画像の1ピクセルあたりのバイト数
+	static const std::int32_t BYTE_PER_PIXEL_RGBA8888 = 4;
+
+	//ブレンド画像の輝度の重み(合計256)
+	static const std::int32_t LUMA_WEIGHT_R = 77;
+	static const std::int32_t LUMA_WEIGHT_G = 151;
+	static const std::int32_t LUMA_WEIGHT_B = 28;
+
+	//4x4の組織的ディザ行列(0～15)
+	static const std::uint8_t DITHER_MATRIX[4][4] = {
+		{  0,  8,  2, 10 },
+		{ 12,  4, 14,  6 },
+		{  3, 11,  1,  9 },
+		{ 15,  7, 13,  5 },
+	};
+
+	//16bitフォーマットの色成分の配置(R,G,B,Aの順)
+	struct Packed16Layout {
+		std::int32_t	bits_[4];		//ビット数(0は格納しない)
+		std::int32_t	pos_[4];		//格納位置(最下位ビットの位置)
+	};
+	static const Packed16Layout LAYOUT_RGB565 = { { 5, 6, 5, 0 }, { 11, 5, 0, 0 } };
+	static const Packed16Layout LAYOUT_RGBA4444 = { { 4, 4, 4, 4 }, { 12, 8, 4, 0 } };
+	static const Packed16Layout LAYOUT_RGBA5551 = { { 5, 5, 5, 1 }, { 11, 6, 1, 0 } };
+
+	//16bitフォーマットの色成分の配置を取得(16bitフォーマット以外はnullptr)
+	static const Packed16Layout* getPacked16Layout(const EN_DecodeFormat format)
+	{
+		switch (format) {
+		case EN_DecodeFormat::D_DECODEFORMAT_RGB565:	return &LAYOUT_RGB565;
+		case EN_DecodeFormat::D_DECODEFORMAT_RGBA4444:	return &LAYOUT_RGBA4444;
+		case EN_DecodeFormat::D_DECODEFORMAT_RGBA5551:	return &LAYOUT_RGBA5551;
+		default:										return nullptr;
+		}
+	}
+
+
+	//----------------------------------------------------------
+	//
+	// スカラー変換
+	//
+	//----------------------------------------------------------
+
+	//1行をRGBA8888へ変換(スカラー)
+	static void convRowScalar(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+
+		switch (format) {
+		case EN_PixelFormat::D_PIXELFORMAT_BGR24:
+			for (std::int32_t w = 0; w < width; w++) {
+				wp[0] = rp[2];
+				wp[1] = rp[1];
+				wp[2] = rp[0];
+				wp[3] = 255;
+				rp += 3;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+			break;
+		case EN_PixelFormat::D_PIXELFORMAT_BGRA32:
+			for (std::int32_t w = 0; w < width; w++) {
+				wp[0] = rp[2];
+				wp[1] = rp[1];
+				wp[2] = rp[0];
+				wp[3] = rp[3];
+				rp += 4;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+			break;
+		case EN_PixelFormat::D_PIXELFORMAT_RGB24:
+			for (std::int32_t w = 0; w < width; w++) {
+				wp[0] = rp[0];
+				wp[1] = rp[1];
+				wp[2] = rp[2];
+				wp[3] = 255;
+				rp += 3;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+			break;
+		case EN_PixelFormat::D_PIXELFORMAT_GRAY8:
+			for (std::int32_t w = 0; w < width; w++) {
+				wp[0] = rp[0];
+				wp[1] = rp[0];
+				wp[2] = rp[0];
+				wp[3] = 255;
+				rp += 1;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+			break;
+		case EN_PixelFormat::D_PIXELFORMAT_GRAYALPHA16:
+			for (std::int32_t w = 0; w < width; w++) {
+				wp[0] = rp[0];
+				wp[1] = rp[0];
+				wp[2] = rp[0];
+				wp[3] = rp[1];
+				rp += 2;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	//255で割る(255*255以下の値のみ、丸めあり)
+	static std::int32_t div255(const std::int32_t value)
+	{
+		const std::int32_t v = value + 128;
+		return (v + (v >> 8)) >> 8;
+	}
+
+	//ブレンド画像1行をアルファへ合成(スカラー)
+	static void blendRowScalar(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+	{
+		const std::uint8_t* rp = blend;
+		std::uint8_t* wp = dst;
+		for (std::int32_t w = 0; w < width; w++) {
+			const std::int32_t luma = ((rp[0] * LUMA_WEIGHT_R) + (rp[1] * LUMA_WEIGHT_G) + (rp[2] * LUMA_WEIGHT_B)) >> 8;
+			const std::int32_t mask = div255(luma * rp[3]);
+			wp[3] = std::uint8_t(div255(wp[3] * mask));
+			rp += BYTE_PER_PIXEL_RGBA8888;
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+
+
+	//16bitフォーマットへ量子化する前に加算する値を作成(4ピクセル分のR,G,B,A)
+	//ディザなしは四捨五入分、ディザありはディザ行列の値を量子化幅に合わせた値(1bitのアルファは加算しない)
+	static void makeQuantizeAdd(const Packed16Layout& layout, const std::int32_t y, const bool isDither, std::uint8_t* const add)
+	{
+		for (std::int32_t x = 0; x < 4; x++) {
+			for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+				const std::int32_t bits = layout.bits_[c];
+				std::int32_t value = 0;
+				if ((bits > 1) && (bits < 8)) {
+					const std::int32_t step = 256 >> bits;
+					value = isDither ? ((DITHER_MATRIX[y & 3][x] * step) >> 4) : (step >> 1);
+				}
+				add[(x * BYTE_PER_PIXEL_RGBA8888) + c] = std::uint8_t(value);
+			}
+		}
+	}
+
+	//1ピクセルを16bitフォーマットへ変換(スカラー)
+	static std::uint16_t packPixel16(const Packed16Layout& layout, const std::uint8_t* const src, const std::uint8_t* const add)
+	{
+		std::uint32_t value = 0;
+		for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+			const std::int32_t bits = layout.bits_[c];
+			if (bits > 0) {
+				const std::uint32_t c8 = std::min(std::uint32_t(src[c]) + add[c], std::uint32_t(255));
+				value |= (c8 >> (8 - bits)) << layout.pos_[c];
+			}
+		}
+		return std::uint16_t(value);
+	}
+
+	//RGBA8888画像1行をデコード後のフォーマットへ変換(スカラー)
+	//addは16bitフォーマットの量子化前に加算する値(先頭のピクセルがディザ行列の0列目)
+	static void convDecodeRowScalar(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint8_t* const add)
+	{
+		const std::uint8_t* rp = src;
+		std::uint8_t* wp = dst;
+		const Packed16Layout* const layout = getPacked16Layout(format);
+		if (layout != nullptr) {
+			//16bitフォーマット
+			for (std::int32_t w = 0; w < width; w++) {
+				const std::uint16_t value = packPixel16(*layout, rp, add + ((w & 3) * BYTE_PER_PIXEL_RGBA8888));
+				(void)memcpy(wp, &value, sizeof(value));
+				rp += BYTE_PER_PIXEL_RGBA8888;
+				wp += sizeof(value);
+			}
+			return;
+		}
+
+		switch (format) {
+		case EN_DecodeFormat::D_DECODEFORMAT_RGBA8888_PREMUL:
+			//色成分にアルファを乗算
+			for (std::int32_t w = 0; w < width; w++) {
+				const std::int32_t alpha = rp[3];
+				wp[0] = std::uint8_t(div255(rp[0] * alpha));
+				wp[1] = std::uint8_t(div255(rp[1] * alpha));
+				wp[2] = std::uint8_t(div255(rp[2] * alpha));
+				wp[3] = std::uint8_t(alpha);
+				rp += BYTE_PER_PIXEL_RGBA8888;
+				wp += BYTE_PER_PIXEL_RGBA8888;
+			}
+			break;
+		case EN_DecodeFormat::D_DECODEFORMAT_A8:
+			//アルファのみ
+			for (std::int32_t w = 0; w < width; w++) {
+				wp[w] = rp[(w * BYTE_PER_PIXEL_RGBA8888) + 3];
+			}
+			break;
+		default:
+			//RGBA8888はそのまま
+			if (src != dst) {
+				(void)memcpy(dst, src, size_t(width) * BYTE_PER_PIXEL_RGBA8888);
+			}
+			break;
+		}
+	}
+
+
+#if defined(FW_CPU_X86)
+
+	//----------------------------------------------------------
+	//
+	// SSE2/SSSE3変換
+	//
+	// 戻り値は変換したピクセル数(端数はスカラーで変換する)
+	//
+	//----------------------------------------------------------
+
+	//グレー→RGBA8888(SSE2:16ピクセルずつ)
+	FW_TARGET_SSE2
+	static std::int32_t convGray8Sse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i alpha = _mm_set1_epi8(-1);
+		std::int32_t w = 0;
+		for (; (w + 16) <= width; w += 16) {
+			const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + w));
+			const __m128i gg0 = _mm_unpacklo_epi8(g, g);
+			const __m128i gg1 = _mm_unpackhi_epi8(g, g);
+			const __m128i ga0 = _mm_unpacklo_epi8(g, alpha);
+			const __m128i ga1 = _mm_unpackhi_epi8(g, alpha);
+			__m128i* const wp = reinterpret_cast<__m128i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888));
+			_mm_storeu_si128(wp + 0, _mm_unpacklo_epi16(gg0, ga0));
+			_mm_storeu_si128(wp + 1, _mm_unpackhi_epi16(gg0, ga0));
+			_mm_storeu_si128(wp + 2, _mm_unpacklo_epi16(gg1, ga1));
+			_mm_storeu_si128(wp + 3, _mm_unpackhi_epi16(gg1, ga1));
+		}
+		return w;
+	}
+
+	//グレー+アルファ→RGBA8888(SSE2:8ピクセルずつ)
+	FW_TARGET_SSE2
+	static std::int32_t convGrayAlpha16Sse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i grayMask = _mm_set1_epi16(0x00FF);
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			//16bit単位で[G,A]
+			const __m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (w * 2)));
+			//16bit単位で[G,G]
+			const __m128i g = _mm_and_si128(ga, grayMask);
+			const __m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+			__m128i* const wp = reinterpret_cast<__m128i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888));
+			_mm_storeu_si128(wp + 0, _mm_unpacklo_epi16(gg, ga));
+			_mm_storeu_si128(wp + 1, _mm_unpackhi_epi16(gg, ga));
+		}
+		return w;
+	}
+
+	//3バイトピクセル→RGBA8888(SSSE3:4ピクセルずつ)
+	FW_TARGET_SSSE3
+	static std::int32_t convPixel24Ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const bool isBgr)
+	{
+		const __m128i shuffle = isBgr ?
+			_mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) :
+			_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32(std::int32_t(0xFF000000));
+		std::int32_t w = 0;
+		//16バイト読み込むため、行末の読み込み超過が起きない範囲のみ
+		for (; (w + 6) <= width; w += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (w * 3)));
+			const __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), rgba);
+		}
+		return w;
+	}
+
+	//BGRA→RGBA8888(SSSE3:4ピクセルずつ)
+	FW_TARGET_SSSE3
+	static std::int32_t convBgra32Ssse3(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		std::int32_t w = 0;
+		for (; (w + 4) <= width; w += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (w * 4)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), _mm_shuffle_epi8(v, shuffle));
+		}
+		return w;
+	}
+
+	//255で割る(SSE2:32bit単位、255*255以下の値のみ)
+	FW_TARGET_SSE2
+	static __m128i div255Sse2(const __m128i value)
+	{
+		const __m128i v = _mm_add_epi32(value, _mm_set1_epi32(128));
+		return _mm_srli_epi32(_mm_add_epi32(v, _mm_srli_epi32(v, 8)), 8);
+	}
+
+	//ブレンド画像1行をアルファへ合成(SSE2:4ピクセルずつ)
+	//各要素は32bit単位で上位16bitが0のため、16bit乗算で積が求まる
+	FW_TARGET_SSE2
+	static std::int32_t blendRowSse2(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+	{
+		const __m128i byteMask = _mm_set1_epi32(0x000000FF);
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i weightR = _mm_set1_epi32(LUMA_WEIGHT_R);
+		const __m128i weightG = _mm_set1_epi32(LUMA_WEIGHT_G);
+		const __m128i weightB = _mm_set1_epi32(LUMA_WEIGHT_B);
+		std::int32_t w = 0;
+		for (; (w + 4) <= width; w += 4) {
+			__m128i* const wp = reinterpret_cast<__m128i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888));
+			const __m128i d = _mm_loadu_si128(wp);
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blend + (w * BYTE_PER_PIXEL_RGBA8888)));
+
+			//ブレンド画像の輝度*アルファ
+			const __m128i r = _mm_mullo_epi16(_mm_and_si128(b, byteMask), weightR);
+			const __m128i g = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(b, 8), byteMask), weightG);
+			const __m128i bl = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(b, 16), byteMask), weightB);
+			const __m128i luma = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(r, g), bl), 8);
+			const __m128i mask = div255Sse2(_mm_mullo_epi16(luma, _mm_srli_epi32(b, 24)));
+
+			//本体のアルファへ合成
+			const __m128i alpha = div255Sse2(_mm_mullo_epi16(_mm_srli_epi32(d, 24), mask));
+			_mm_storeu_si128(wp, _mm_or_si128(_mm_and_si128(d, colorMask), _mm_slli_epi32(alpha, 24)));
+		}
+		return w;
+	}
+
+	//255で割る(SSE2:16bit単位、255*255以下の値のみ)
+	FW_TARGET_SSE2
+	static __m128i div255Epi16Sse2(const __m128i value)
+	{
+		const __m128i v = _mm_add_epi16(value, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+	}
+
+	//RGBA8888→乗算済みアルファ(SSE2:4ピクセルずつ)
+	FW_TARGET_SSE2
+	static std::int32_t premulRowSse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32(std::int32_t(0xFF000000));
+		std::int32_t w = 0;
+		for (; (w + 4) <= width; w += 4) {
+			const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (w * BYTE_PER_PIXEL_RGBA8888)));
+
+			//16bitへ拡張してピクセル毎のアルファを乗算
+			const __m128i lo = _mm_unpacklo_epi8(s, zero);
+			const __m128i hi = _mm_unpackhi_epi8(s, zero);
+			const __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128i d = _mm_packus_epi16(div255Epi16Sse2(_mm_mullo_epi16(lo, alphaLo)), div255Epi16Sse2(_mm_mullo_epi16(hi, alphaHi)));
+
+			//アルファは元の値
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), _mm_or_si128(_mm_andnot_si128(alphaMask, d), _mm_and_si128(s, alphaMask)));
+		}
+		return w;
+	}
+
+	//RGBA8888→16bitフォーマット(SSE2:8ピクセルずつ)
+	//32bit単位で各成分を切り出して格納位置へずらし、16bitへパックする
+	FW_TARGET_SSE2
+	static std::int32_t packRow16Sse2(const Packed16Layout& layout, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint8_t* const add)
+	{
+		const __m128i addV = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add));
+		__m128i shift[BYTE_PER_PIXEL_RGBA8888];
+		__m128i mask[BYTE_PER_PIXEL_RGBA8888];
+		__m128i pos[BYTE_PER_PIXEL_RGBA8888];
+		for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+			const std::int32_t bits = layout.bits_[c];
+			shift[c] = _mm_cvtsi32_si128((c * 8) + 8 - bits);
+			mask[c] = _mm_set1_epi32((1 << bits) - 1);
+			pos[c] = _mm_cvtsi32_si128(layout.pos_[c]);
+		}
+
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			const std::uint8_t* const rp = src + (w * BYTE_PER_PIXEL_RGBA8888);
+			const __m128i s0 = _mm_adds_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rp)), addV);
+			const __m128i s1 = _mm_adds_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 16)), addV);
+			__m128i v0 = _mm_setzero_si128();
+			__m128i v1 = _mm_setzero_si128();
+			for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+				v0 = _mm_or_si128(v0, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(s0, shift[c]), mask[c]), pos[c]));
+				v1 = _mm_or_si128(v1, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(s1, shift[c]), mask[c]), pos[c]));
+			}
+
+			//符号付き飽和を避けるため16bitを符号拡張してからパック
+			v0 = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+			v1 = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (w * 2)), _mm_packs_epi32(v0, v1));
+		}
+		return w;
+	}
+
+	//RGBA8888→A8(SSE2:16ピクセルずつ)
+	FW_TARGET_SSE2
+	static std::int32_t alphaRowSse2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		std::int32_t w = 0;
+		for (; (w + 16) <= width; w += 16) {
+			const __m128i* const rp = reinterpret_cast<const __m128i*>(src + (w * BYTE_PER_PIXEL_RGBA8888));
+			const __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(rp + 0), 24);
+			const __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(rp + 1), 24);
+			const __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(rp + 2), 24);
+			const __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(rp + 3), 24);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + w), _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3)));
+		}
+		return w;
+	}
+
+	//RGBA8888画像1行をデコード後のフォーマットへ変換(SSE2)
+	static std::int32_t convDecodeRowSse2(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint8_t* const add)
+	{
+		const Packed16Layout* const layout = getPacked16Layout(format);
+		if (layout != nullptr) {
+			return packRow16Sse2(*layout, src, dst, width, add);
+		}
+		switch (format) {
+		case EN_DecodeFormat::D_DECODEFORMAT_RGBA8888_PREMUL:	return premulRowSse2(src, dst, width);
+		case EN_DecodeFormat::D_DECODEFORMAT_A8:				return alphaRowSse2(src, dst, width);
+		default:												return 0;
+		}
+	}
+
+	//1行をRGBA8888へ変換(SSE2)
+	static std::int32_t convRowSse2(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		switch (format) {
+		case EN_PixelFormat::D_PIXELFORMAT_GRAY8:		return convGray8Sse2(src, dst, width);
+		case EN_PixelFormat::D_PIXELFORMAT_GRAYALPHA16:	return convGrayAlpha16Sse2(src, dst, width);
+		default:										return 0;
+		}
+	}
+
+	//1行をRGBA8888へ変換(SSSE3)
+	static std::int32_t convRowSsse3(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		switch (format) {
+		case EN_PixelFormat::D_PIXELFORMAT_BGR24:		return convPixel24Ssse3(src, dst, width, true);
+		case EN_PixelFormat::D_PIXELFORMAT_BGRA32:		return convBgra32Ssse3(src, dst, width);
+		case EN_PixelFormat::D_PIXELFORMAT_RGB24:		return convPixel24Ssse3(src, dst, width, false);
+		default:										return convRowSse2(format, src, dst, width);
+		}
+	}
+
+
+	//----------------------------------------------------------
+	//
+	// AVX2変換
+	//
+	//----------------------------------------------------------
+
+	//3バイトピクセル→RGBA8888(AVX2:8ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t convPixel24Avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const bool isBgr)
+	{
+		//128bitレーン毎に12バイト→16バイトへシャッフル
+		const __m256i shuffle = isBgr ?
+			_mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) :
+			_mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m256i alpha = _mm256_set1_epi32(std::int32_t(0xFF000000));
+		std::int32_t w = 0;
+		//上位レーンは12バイト目から16バイト読み込むため、行末の読み込み超過が起きない範囲のみ
+		for (; (w + 10) <= width; w += 8) {
+			const std::uint8_t* const rp = src + (w * 3);
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 0));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rp + 12));
+			const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+			const __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), rgba);
+		}
+		return w;
+	}
+
+	//BGRA→RGBA8888(AVX2:8ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t convBgra32Avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (w * 4)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), _mm256_shuffle_epi8(v, shuffle));
+		}
+		return w;
+	}
+
+	//グレー→RGBA8888(AVX2:8ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t convGray8Avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i spread = _mm256_set1_epi32(0x00010101);
+		const __m256i alpha = _mm256_set1_epi32(std::int32_t(0xFF000000));
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			const __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + w)));
+			const __m256i rgba = _mm256_or_si256(_mm256_mullo_epi32(g, spread), alpha);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), rgba);
+		}
+		return w;
+	}
+
+	//グレー+アルファ→RGBA8888(AVX2:8ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t convGrayAlpha16Avx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i spread = _mm256_set1_epi32(0x00010101);
+		const __m256i grayMask = _mm256_set1_epi32(0x000000FF);
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			//32bit単位で[G,A,0,0]
+			const __m256i ga = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (w * 2))));
+			const __m256i g = _mm256_and_si256(ga, grayMask);
+			const __m256i a = _mm256_slli_epi32(_mm256_srli_epi32(ga, 8), 24);
+			const __m256i rgba = _mm256_or_si256(_mm256_mullo_epi32(g, spread), a);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), rgba);
+		}
+		return w;
+	}
+
+	//255で割る(AVX2:32bit単位、255*255以下の値のみ)
+	FW_TARGET_AVX2
+	static __m256i div255Avx2(const __m256i value)
+	{
+		const __m256i v = _mm256_add_epi32(value, _mm256_set1_epi32(128));
+		return _mm256_srli_epi32(_mm256_add_epi32(v, _mm256_srli_epi32(v, 8)), 8);
+	}
+
+	//ブレンド画像1行をアルファへ合成(AVX2:8ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t blendRowAvx2(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+	{
+		const __m256i byteMask = _mm256_set1_epi32(0x000000FF);
+		const __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+		const __m256i weightR = _mm256_set1_epi32(LUMA_WEIGHT_R);
+		const __m256i weightG = _mm256_set1_epi32(LUMA_WEIGHT_G);
+		const __m256i weightB = _mm256_set1_epi32(LUMA_WEIGHT_B);
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			__m256i* const wp = reinterpret_cast<__m256i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888));
+			const __m256i d = _mm256_loadu_si256(wp);
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blend + (w * BYTE_PER_PIXEL_RGBA8888)));
+
+			//ブレンド画像の輝度*アルファ
+			const __m256i r = _mm256_mullo_epi16(_mm256_and_si256(b, byteMask), weightR);
+			const __m256i g = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(b, 8), byteMask), weightG);
+			const __m256i bl = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(b, 16), byteMask), weightB);
+			const __m256i luma = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(r, g), bl), 8);
+			const __m256i mask = div255Avx2(_mm256_mullo_epi16(luma, _mm256_srli_epi32(b, 24)));
+
+			//本体のアルファへ合成
+			const __m256i alpha = div255Avx2(_mm256_mullo_epi16(_mm256_srli_epi32(d, 24), mask));
+			_mm256_storeu_si256(wp, _mm256_or_si256(_mm256_and_si256(d, colorMask), _mm256_slli_epi32(alpha, 24)));
+		}
+		return w;
+	}
+
+	//255で割る(AVX2:16bit単位、255*255以下の値のみ)
+	FW_TARGET_AVX2
+	static __m256i div255Epi16Avx2(const __m256i value)
+	{
+		const __m256i v = _mm256_add_epi16(value, _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+	}
+
+	//RGBA8888→乗算済みアルファ(AVX2:8ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t premulRowAvx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i alphaMask = _mm256_set1_epi32(std::int32_t(0xFF000000));
+		std::int32_t w = 0;
+		for (; (w + 8) <= width; w += 8) {
+			const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (w * BYTE_PER_PIXEL_RGBA8888)));
+
+			//16bitへ拡張してピクセル毎のアルファを乗算(レーン内で展開してパックするため並びは変わらない)
+			const __m256i lo = _mm256_unpacklo_epi8(s, zero);
+			const __m256i hi = _mm256_unpackhi_epi8(s, zero);
+			const __m256i alphaLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m256i alphaHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m256i d = _mm256_packus_epi16(div255Epi16Avx2(_mm256_mullo_epi16(lo, alphaLo)), div255Epi16Avx2(_mm256_mullo_epi16(hi, alphaHi)));
+
+			//アルファは元の値
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (w * BYTE_PER_PIXEL_RGBA8888)), _mm256_or_si256(_mm256_andnot_si256(alphaMask, d), _mm256_and_si256(s, alphaMask)));
+		}
+		return w;
+	}
+
+	//RGBA8888→16bitフォーマット(AVX2:16ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t packRow16Avx2(const Packed16Layout& layout, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint8_t* const add)
+	{
+		const __m256i addV = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(add)));
+		__m128i shift[BYTE_PER_PIXEL_RGBA8888];
+		__m256i mask[BYTE_PER_PIXEL_RGBA8888];
+		__m128i pos[BYTE_PER_PIXEL_RGBA8888];
+		for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+			const std::int32_t bits = layout.bits_[c];
+			shift[c] = _mm_cvtsi32_si128((c * 8) + 8 - bits);
+			mask[c] = _mm256_set1_epi32((1 << bits) - 1);
+			pos[c] = _mm_cvtsi32_si128(layout.pos_[c]);
+		}
+
+		std::int32_t w = 0;
+		for (; (w + 16) <= width; w += 16) {
+			const std::uint8_t* const rp = src + (w * BYTE_PER_PIXEL_RGBA8888);
+			const __m256i s0 = _mm256_adds_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rp)), addV);
+			const __m256i s1 = _mm256_adds_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rp + 32)), addV);
+			__m256i v0 = _mm256_setzero_si256();
+			__m256i v1 = _mm256_setzero_si256();
+			for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+				v0 = _mm256_or_si256(v0, _mm256_sll_epi32(_mm256_and_si256(_mm256_srl_epi32(s0, shift[c]), mask[c]), pos[c]));
+				v1 = _mm256_or_si256(v1, _mm256_sll_epi32(_mm256_and_si256(_mm256_srl_epi32(s1, shift[c]), mask[c]), pos[c]));
+			}
+
+			//符号付き飽和を避けるため16bitを符号拡張してからパックし、レーン間の並びを戻す
+			v0 = _mm256_srai_epi32(_mm256_slli_epi32(v0, 16), 16);
+			v1 = _mm256_srai_epi32(_mm256_slli_epi32(v1, 16), 16);
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (w * 2)), packed);
+		}
+		return w;
+	}
+
+	//RGBA8888→A8(AVX2:32ピクセルずつ)
+	FW_TARGET_AVX2
+	static std::int32_t alphaRowAvx2(const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		//レーン内のパックで4ピクセル単位に入れ替わった並びを戻す
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		std::int32_t w = 0;
+		for (; (w + 32) <= width; w += 32) {
+			const __m256i* const rp = reinterpret_cast<const __m256i*>(src + (w * BYTE_PER_PIXEL_RGBA8888));
+			const __m256i a0 = _mm256_srli_epi32(_mm256_loadu_si256(rp + 0), 24);
+			const __m256i a1 = _mm256_srli_epi32(_mm256_loadu_si256(rp + 1), 24);
+			const __m256i a2 = _mm256_srli_epi32(_mm256_loadu_si256(rp + 2), 24);
+			const __m256i a3 = _mm256_srli_epi32(_mm256_loadu_si256(rp + 3), 24);
+			const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a0, a1), _mm256_packs_epi32(a2, a3));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + w), _mm256_permutevar8x32_epi32(packed, order));
+		}
+		return w;
+	}
+
+	//RGBA8888画像1行をデコード後のフォーマットへ変換(AVX2)
+	static std::int32_t convDecodeRowAvx2(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint8_t* const add)
+	{
+		const Packed16Layout* const layout = getPacked16Layout(format);
+		if (layout != nullptr) {
+			return packRow16Avx2(*layout, src, dst, width, add);
+		}
+		switch (format) {
+		case EN_DecodeFormat::D_DECODEFORMAT_RGBA8888_PREMUL:	return premulRowAvx2(src, dst, width);
+		case EN_DecodeFormat::D_DECODEFORMAT_A8:				return alphaRowAvx2(src, dst, width);
+		default:												return 0;
+		}
+	}
+
+	//1行をRGBA8888へ変換(AVX2)
+	static std::int32_t convRowAvx2(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		switch (format) {
+		case EN_PixelFormat::D_PIXELFORMAT_BGR24:		return convPixel24Avx2(src, dst, width, true);
+		case EN_PixelFormat::D_PIXELFORMAT_BGRA32:		return convBgra32Avx2(src, dst, width);
+		case EN_PixelFormat::D_PIXELFORMAT_RGB24:		return convPixel24Avx2(src, dst, width, false);
+		case EN_PixelFormat::D_PIXELFORMAT_GRAY8:		return convGray8Avx2(src, dst, width);
+		case EN_PixelFormat::D_PIXELFORMAT_GRAYALPHA16:	return convGrayAlpha16Avx2(src, dst, width);
+		default:										return 0;
+		}
+	}
+
+#endif //FW_CPU_X86
+
+
+#if defined(FW_CPU_NEON)
+
+	//----------------------------------------------------------
+	//
+	// NEON変換
+	//
+	//----------------------------------------------------------
+
+	//1行をRGBA8888へ変換(NEON:16ピクセルずつ)
+	static std::int32_t convRowNeon(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+	{
+		const uint8x16_t alpha = vdupq_n_u8(255);
+		std::int32_t w = 0;
+		for (; (w + 16) <= width; w += 16) {
+			uint8x16x4_t rgba;
+			switch (format) {
+			case EN_PixelFormat::D_PIXELFORMAT_BGR24:
+			{
+				const uint8x16x3_t v = vld3q_u8(src + (w * 3));
+				rgba.val[0] = v.val[2];
+				rgba.val[1] = v.val[1];
+				rgba.val[2] = v.val[0];
+				rgba.val[3] = alpha;
+				break;
+			}
+			case EN_PixelFormat::D_PIXELFORMAT_BGRA32:
+			{
+				const uint8x16x4_t v = vld4q_u8(src + (w * 4));
+				rgba.val[0] = v.val[2];
+				rgba.val[1] = v.val[1];
+				rgba.val[2] = v.val[0];
+				rgba.val[3] = v.val[3];
+				break;
+			}
+			case EN_PixelFormat::D_PIXELFORMAT_RGB24:
+			{
+				const uint8x16x3_t v = vld3q_u8(src + (w * 3));
+				rgba.val[0] = v.val[0];
+				rgba.val[1] = v.val[1];
+				rgba.val[2] = v.val[2];
+				rgba.val[3] = alpha;
+				break;
+			}
+			case EN_PixelFormat::D_PIXELFORMAT_GRAY8:
+			{
+				const uint8x16_t g = vld1q_u8(src + w);
+				rgba.val[0] = g;
+				rgba.val[1] = g;
+				rgba.val[2] = g;
+				rgba.val[3] = alpha;
+				break;
+			}
+			case EN_PixelFormat::D_PIXELFORMAT_GRAYALPHA16:
+			{
+				const uint8x16x2_t v = vld2q_u8(src + (w * 2));
+				rgba.val[0] = v.val[0];
+				rgba.val[1] = v.val[0];
+				rgba.val[2] = v.val[0];
+				rgba.val[3] = v.val[1];
+				break;
+			}
+			default:
+				return w;
+			}
+			vst4q_u8(dst + (w * BYTE_PER_PIXEL_RGBA8888), rgba);
+		}
+		return w;
+	}
+
+	//255で割る(NEON:16bit単位、255*255以下の値のみ、8bitへ縮小)
+	static uint8x8_t div255Neon(const uint16x8_t value)
+	{
+		const uint16x8_t v = vaddq_u16(value, vdupq_n_u16(128));
+		return vshrn_n_u16(vaddq_u16(v, vshrq_n_u16(v, 8)), 8);
+	}
+
+	//ブレンド画像1行をアルファへ合成(NEON:16ピクセルずつ)
+	static std::int32_t blendRowNeon(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+	{
+		const uint8x8_t weightR = vdup_n_u8(std::uint8_t(LUMA_WEIGHT_R));
+		const uint8x8_t weightG = vdup_n_u8(std::uint8_t(LUMA_WEIGHT_G));
+		const uint8x8_t weightB = vdup_n_u8(std::uint8_t(LUMA_WEIGHT_B));
+		std::int32_t w = 0;
+		for (; (w + 16) <= width; w += 16) {
+			uint8x16x4_t d = vld4q_u8(dst + (w * BYTE_PER_PIXEL_RGBA8888));
+			const uint8x16x4_t b = vld4q_u8(blend + (w * BYTE_PER_PIXEL_RGBA8888));
+
+			//ブレンド画像の輝度(前半8ピクセル、後半8ピクセル)
+			uint16x8_t lumaLo = vmull_u8(vget_low_u8(b.val[0]), weightR);
+			lumaLo = vmlal_u8(lumaLo, vget_low_u8(b.val[1]), weightG);
+			lumaLo = vmlal_u8(lumaLo, vget_low_u8(b.val[2]), weightB);
+			uint16x8_t lumaHi = vmull_u8(vget_high_u8(b.val[0]), weightR);
+			lumaHi = vmlal_u8(lumaHi, vget_high_u8(b.val[1]), weightG);
+			lumaHi = vmlal_u8(lumaHi, vget_high_u8(b.val[2]), weightB);
+
+			//輝度*アルファ
+			const uint8x8_t maskLo = div255Neon(vmull_u8(vshrn_n_u16(lumaLo, 8), vget_low_u8(b.val[3])));
+			const uint8x8_t maskHi = div255Neon(vmull_u8(vshrn_n_u16(lumaHi, 8), vget_high_u8(b.val[3])));
+
+			//本体のアルファへ合成
+			const uint8x8_t alphaLo = div255Neon(vmull_u8(vget_low_u8(d.val[3]), maskLo));
+			const uint8x8_t alphaHi = div255Neon(vmull_u8(vget_high_u8(d.val[3]), maskHi));
+			d.val[3] = vcombine_u8(alphaLo, alphaHi);
+			vst4q_u8(dst + (w * BYTE_PER_PIXEL_RGBA8888), d);
+		}
+		return w;
+	}
+
+	//RGBA8888画像1行をデコード後のフォーマットへ変換(NEON)
+	//乗算済みアルファとA8は16ピクセルずつ、16bitフォーマットは8ピクセルずつ
+	static std::int32_t convDecodeRowNeon(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::uint8_t* const add)
+	{
+		std::int32_t w = 0;
+		const Packed16Layout* const layout = getPacked16Layout(format);
+		if (layout != nullptr) {
+			//32bit単位で各成分を切り出して格納位置へずらし、16bitへ縮小(負のシフトは右シフト)
+			const uint8x16_t addV = vld1q_u8(add);
+			int32x4_t shift[BYTE_PER_PIXEL_RGBA8888];
+			uint32x4_t mask[BYTE_PER_PIXEL_RGBA8888];
+			int32x4_t pos[BYTE_PER_PIXEL_RGBA8888];
+			for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+				const std::int32_t bits = layout->bits_[c];
+				shift[c] = vdupq_n_s32(-((c * 8) + 8 - bits));
+				mask[c] = vdupq_n_u32((1u << bits) - 1);
+				pos[c] = vdupq_n_s32(layout->pos_[c]);
+			}
+			for (; (w + 8) <= width; w += 8) {
+				const std::uint8_t* const rp = src + (w * BYTE_PER_PIXEL_RGBA8888);
+				const uint32x4_t s0 = vreinterpretq_u32_u8(vqaddq_u8(vld1q_u8(rp), addV));
+				const uint32x4_t s1 = vreinterpretq_u32_u8(vqaddq_u8(vld1q_u8(rp + 16), addV));
+				uint32x4_t v0 = vdupq_n_u32(0);
+				uint32x4_t v1 = vdupq_n_u32(0);
+				for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+					v0 = vorrq_u32(v0, vshlq_u32(vandq_u32(vshlq_u32(s0, shift[c]), mask[c]), pos[c]));
+					v1 = vorrq_u32(v1, vshlq_u32(vandq_u32(vshlq_u32(s1, shift[c]), mask[c]), pos[c]));
+				}
+				vst1q_u16(reinterpret_cast<std::uint16_t*>(dst + (w * 2)), vcombine_u16(vmovn_u32(v0), vmovn_u32(v1)));
+			}
+			return w;
+		}
+
+		switch (format) {
+		case EN_DecodeFormat::D_DECODEFORMAT_RGBA8888_PREMUL:
+			//色成分にアルファを乗算
+			for (; (w + 16) <= width; w += 16) {
+				uint8x16x4_t d = vld4q_u8(src + (w * BYTE_PER_PIXEL_RGBA8888));
+				const uint8x16_t alpha = d.val[3];
+				for (std::int32_t c = 0; c < 3; c++) {
+					const uint8x8_t lo = div255Neon(vmull_u8(vget_low_u8(d.val[c]), vget_low_u8(alpha)));
+					const uint8x8_t hi = div255Neon(vmull_u8(vget_high_u8(d.val[c]), vget_high_u8(alpha)));
+					d.val[c] = vcombine_u8(lo, hi);
+				}
+				vst4q_u8(dst + (w * BYTE_PER_PIXEL_RGBA8888), d);
+			}
+			break;
+		case EN_DecodeFormat::D_DECODEFORMAT_A8:
+			//アルファのみ
+			for (; (w + 16) <= width; w += 16) {
+				const uint8x16x4_t s = vld4q_u8(src + (w * BYTE_PER_PIXEL_RGBA8888));
+				vst1q_u8(dst + w, s.val[3]);
+			}
+			break;
+		default:
+			break;
+		}
+		return w;
+	}
+
+#endif //FW_CPU_NEON
+
+
+	//CPU機能から変換処理パスを選択
+	static fw::PixelConv::EN_ConvPath selectConvPath()
+	{
+		if (fw::Cpu::hasAvx2()) {
+			return fw::PixelConv::D_CONVPATH_AVX2;
+		}
+		if (fw::Cpu::hasSsse3()) {
+			return fw::PixelConv::D_CONVPATH_SSSE3;
+		}
+		if (fw::Cpu::hasSse2()) {
+			return fw::PixelConv::D_CONVPATH_SSE2;
+		}
+		if (fw::Cpu::hasNeon()) {
+			return fw::PixelConv::D_CONVPATH_NEON;
+		}
+		return fw::PixelConv::D_CONVPATH_SCALAR;
+	}
+
+	//拡大縮小時の変換元座標(16.16固定小数点、画素中心を合わせる)
+	static std::int32_t calcResizeCoord(const std::int32_t dstPos, const std::int32_t srcSize, const std::int32_t dstSize)
+	{
+		std::int64_t pos = ((std::int64_t(2 * dstPos + 1) * srcSize) << 16) / (std::int64_t(2) * dstSize) - 0x8000;
+		if (pos < 0) {
+			pos = 0;
+		}
+		const std::int64_t maxPos = std::int64_t(srcSize - 1) << 16;
+		if (pos > maxPos) {
+			pos = maxPos;
+		}
+		return std::int32_t(pos);
+	}
+}
+
+
+//----------------------------------------------------------
+//
+// ピクセル変換クラス
+//
+//----------------------------------------------------------
+
+//1行をRGBA8888へ変換
+void fw::PixelConv::convRowToRgba8888(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+{
+	convRowToRgba8888(getPath(), format, src, dst, width);
+}
+
+//1行をRGBA8888へ変換(変換処理パス指定)
+void fw::PixelConv::convRowToRgba8888(const EN_ConvPath path, const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+{
+	//SIMDで変換したピクセル数
+	std::int32_t done = 0;
+
+	switch (path) {
+#if defined(FW_CPU_X86)
+	case D_CONVPATH_SSE2:	done = convRowSse2(format, src, dst, width);	break;
+	case D_CONVPATH_SSSE3:	done = convRowSsse3(format, src, dst, width);	break;
+	case D_CONVPATH_AVX2:	done = convRowAvx2(format, src, dst, width);	break;
+#endif //FW_CPU_X86
+#if defined(FW_CPU_NEON)
+	case D_CONVPATH_NEON:	done = convRowNeon(format, src, dst, width);	break;
+#endif //FW_CPU_NEON
+	default:																break;
+	}
+
+	//端数はスカラーで変換
+	const std::int32_t srcByte = done * getBytePerPixel(format);
+	const std::int32_t dstByte = done * BYTE_PER_PIXEL_RGBA8888;
+	convRowScalar(format, src + srcByte, dst + dstByte, width - done);
+}
+
+//1行をRGBA8888へ変換(スカラー参照実装)
+void fw::PixelConv::convRowToRgba8888Scalar(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width)
+{
+	convRowScalar(format, src, dst, width);
+}
+
+//ブレンド画像1行をRGBA8888画像1行のアルファへ合成
+void fw::PixelConv::blendRowRgba8888(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+{
+	blendRowRgba8888(getPath(), dst, blend, width);
+}
+
+//ブレンド画像1行をRGBA8888画像1行のアルファへ合成(変換処理パス指定)
+void fw::PixelConv::blendRowRgba8888(const EN_ConvPath path, std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+{
+	//SIMDで合成したピクセル数
+	std::int32_t done = 0;
+
+	switch (path) {
+#if defined(FW_CPU_X86)
+	case D_CONVPATH_SSE2:	done = blendRowSse2(dst, blend, width);	break;
+	case D_CONVPATH_SSSE3:	done = blendRowSse2(dst, blend, width);	break;
+	case D_CONVPATH_AVX2:	done = blendRowAvx2(dst, blend, width);	break;
+#endif //FW_CPU_X86
+#if defined(FW_CPU_NEON)
+	case D_CONVPATH_NEON:	done = blendRowNeon(dst, blend, width);	break;
+#endif //FW_CPU_NEON
+	default:														break;
+	}
+
+	//端数はスカラーで合成
+	const std::int32_t byte = done * BYTE_PER_PIXEL_RGBA8888;
+	blendRowScalar(dst + byte, blend + byte, width - done);
+}
+
+//ブレンド画像1行をRGBA8888画像1行のアルファへ合成(スカラー参照実装)
+void fw::PixelConv::blendRowRgba8888Scalar(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width)
+{
+	blendRowScalar(dst, blend, width);
+}
+
+//RGBA8888画像1行をデコード後のフォーマットへ変換
+void fw::PixelConv::convRowFromRgba8888(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::int32_t y, const bool isDither)
+{
+	convRowFromRgba8888(getPath(), format, src, dst, width, y, isDither);
+}
+
+//RGBA8888画像1行をデコード後のフォーマットへ変換(変換処理パス指定)
+void fw::PixelConv::convRowFromRgba8888(const EN_ConvPath path, const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::int32_t y, const bool isDither)
+{
+	//16bitフォーマットの量子化前に加算する値(行毎に4ピクセル分)
+	std::uint8_t add[BYTE_PER_PIXEL_RGBA8888 * 4] = { 0 };
+	const Packed16Layout* const layout = getPacked16Layout(format);
+	if (layout != nullptr) {
+		makeQuantizeAdd(*layout, y, isDither, add);
+	}
+
+	//SIMDで変換したピクセル数(4の倍数のためディザ行列の列は端数も0列目から)
+	std::int32_t done = 0;
+
+	switch (path) {
+#if defined(FW_CPU_X86)
+	case D_CONVPATH_SSE2:	done = convDecodeRowSse2(format, src, dst, width, add);	break;
+	case D_CONVPATH_SSSE3:	done = convDecodeRowSse2(format, src, dst, width, add);	break;
+	case D_CONVPATH_AVX2:	done = convDecodeRowAvx2(format, src, dst, width, add);	break;
+#endif //FW_CPU_X86
+#if defined(FW_CPU_NEON)
+	case D_CONVPATH_NEON:	done = convDecodeRowNeon(format, src, dst, width, add);	break;
+#endif //FW_CPU_NEON
+	default:																		break;
+	}
+
+	//端数はスカラーで変換
+	convDecodeRowScalar(format, src + (done * BYTE_PER_PIXEL_RGBA8888), dst + (done * getBytePerPixel(format)), width - done, add);
+}
+
+//RGBA8888画像1行をデコード後のフォーマットへ変換(スカラー参照実装)
+void fw::PixelConv::convRowFromRgba8888Scalar(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::int32_t y, const bool isDither)
+{
+	std::uint8_t add[BYTE_PER_PIXEL_RGBA8888 * 4] = { 0 };
+	const Packed16Layout* const layout = getPacked16Layout(format);
+	if (layout != nullptr) {
+		makeQuantizeAdd(*layout, y, isDither, add);
+	}
+	convDecodeRowScalar(format, src, dst, width, add);
+}
+
+//RGBA8888画像を拡大縮小(バイリニア)
+void fw::PixelConv::resizeRgba8888(const std::uint8_t* const src, const std::int32_t srcWidth, const std::int32_t srcHeight, const std::int32_t srcStride,
+	std::uint8_t* const dst, const std::int32_t dstWidth, const std::int32_t dstHeight, const std::int32_t dstStride)
+{
+	if ((srcWidth <= 0) || (srcHeight <= 0) || (dstWidth <= 0) || (dstHeight <= 0)) {
+		return;
+	}
+
+	for (std::int32_t y = 0; y < dstHeight; y++) {
+		//上下の参照行と重み(8bit)
+		const std::int32_t sy = calcResizeCoord(y, srcHeight, dstHeight);
+		const std::int32_t y0 = sy >> 16;
+		const std::int32_t y1 = (y0 + 1 < srcHeight) ? (y0 + 1) : y0;
+		const std::int32_t fy = (sy >> 8) & 0xFF;
+		const std::uint8_t* row0 = src + (y0 * srcStride);
+		const std::uint8_t* row1 = src + (y1 * srcStride);
+		std::uint8_t* wp = dst + (y * dstStride);
+
+		for (std::int32_t x = 0; x < dstWidth; x++) {
+			//左右の参照画素と重み(8bit)
+			const std::int32_t sx = calcResizeCoord(x, srcWidth, dstWidth);
+			const std::int32_t x0 = sx >> 16;
+			const std::int32_t x1 = (x0 + 1 < srcWidth) ? (x0 + 1) : x0;
+			const std::int32_t fx = (sx >> 8) & 0xFF;
+			const std::uint8_t* p00 = row0 + (x0 * BYTE_PER_PIXEL_RGBA8888);
+			const std::uint8_t* p01 = row0 + (x1 * BYTE_PER_PIXEL_RGBA8888);
+			const std::uint8_t* p10 = row1 + (x0 * BYTE_PER_PIXEL_RGBA8888);
+			const std::uint8_t* p11 = row1 + (x1 * BYTE_PER_PIXEL_RGBA8888);
+
+			for (std::int32_t c = 0; c < BYTE_PER_PIXEL_RGBA8888; c++) {
+				const std::int32_t top = (p00[c] << 8) + ((p01[c] - p00[c]) * fx);
+				const std::int32_t bottom = (p10[c] << 8) + ((p11[c] - p10[c]) * fx);
+				const std::int32_t v = (top << 8) + ((bottom - top) * fy);
+				wp[c] = std::uint8_t((v + 0x8000) >> 16);
+			}
+			wp += BYTE_PER_PIXEL_RGBA8888;
+		}
+	}
+}
+
+//変換元1ピクセルあたりのバイト数を取得
+std::int32_t fw::PixelConv::getBytePerPixel(const EN_PixelFormat format)
+{
+	switch (format) {
+	case EN_PixelFormat::D_PIXELFORMAT_BGR24:		return 3;
+	case EN_PixelFormat::D_PIXELFORMAT_BGRA32:		return 4;
+	case EN_PixelFormat::D_PIXELFORMAT_RGB24:		return 3;
+	case EN_PixelFormat::D_PIXELFORMAT_GRAY8:		return 1;
+	case EN_PixelFormat::D_PIXELFORMAT_GRAYALPHA16:	return 2;
+	default:										return 0;
+	}
+}
+
+//デコード後の1ピクセルあたりのバイト数を取得
+std::int32_t fw::PixelConv::getBytePerPixel(const EN_DecodeFormat format)
+{
+	switch (format) {
+	case EN_DecodeFormat::D_DECODEFORMAT_RGBA8888:			return 4;
+	case EN_DecodeFormat::D_DECODEFORMAT_RGBA8888_PREMUL:	return 4;
+	case EN_DecodeFormat::D_DECODEFORMAT_RGB565:			return 2;
+	case EN_DecodeFormat::D_DECODEFORMAT_RGBA4444:			return 2;
+	case EN_DecodeFormat::D_DECODEFORMAT_RGBA5551:			return 2;
+	case EN_DecodeFormat::D_DECODEFORMAT_A8:				return 1;
+	default:												return 0;
+	}
+}
+
+//CPU機能から選択した変換処理パスを取得
+fw::PixelConv::EN_ConvPath fw::PixelConv::getPath()
+{
+	static const EN_ConvPath path = selectConvPath();
+	return path;
+}
@@ -0,0 +1,71 @@
+﻿#ifndef INCLUDED_PIXELCONV_HPP
+#define INCLUDED_PIXELCONV_HPP
+
+#include "Std.hpp"
+#include "Image.hpp"
+
+namespace fw {
+
+	//変換元ピクセルフォーマット
+	enum EN_PixelFormat {
+		D_PIXELFORMAT_BGR24,		//B,G,R(3バイト)
+		D_PIXELFORMAT_BGRA32,		//B,G,R,A(4バイト)
+		D_PIXELFORMAT_RGB24,		//R,G,B(3バイト)
+		D_PIXELFORMAT_GRAY8,		//グレー(1バイト)
+		D_PIXELFORMAT_GRAYALPHA16,	//グレー,アルファ(2バイト)
+	};
+
+	//----------------------------------------------------------
+	//
+	// ピクセル変換クラス
+	//
+	// 1行分のピクセルをRGBA8888へ変換する。
+	// 変換処理パスは初回にCPU機能から選択する。
+	// RGBA8888画像の拡大縮小、ブレンド画像の合成、デコード後のフォーマットへの変換も行う。
+	//
+	//----------------------------------------------------------
+
+	class PixelConv {
+	public:
+		//変換処理パス
+		enum EN_ConvPath {
+			D_CONVPATH_SCALAR,		//スカラー(参照実装)
+			D_CONVPATH_SSE2,		//SSE2(グレーのみ、他はスカラー)
+			D_CONVPATH_SSSE3,		//SSSE3
+			D_CONVPATH_AVX2,		//AVX2
+			D_CONVPATH_NEON,		//NEON
+		};
+
+		//1行をRGBA8888へ変換
+		static void convRowToRgba8888(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width);
+		//1行をRGBA8888へ変換(変換処理パス指定)
+		static void convRowToRgba8888(const EN_ConvPath path, const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width);
+		//1行をRGBA8888へ変換(スカラー参照実装)
+		static void convRowToRgba8888Scalar(const EN_PixelFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width);
+		//ブレンド画像1行をRGBA8888画像1行のアルファへ合成(dstを直接更新)
+		//アルファ = 本体のアルファ * ブレンド画像の輝度 * ブレンド画像のアルファ / (255 * 255)
+		static void blendRowRgba8888(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width);
+		//ブレンド画像1行をRGBA8888画像1行のアルファへ合成(変換処理パス指定)
+		static void blendRowRgba8888(const EN_ConvPath path, std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width);
+		//ブレンド画像1行をRGBA8888画像1行のアルファへ合成(スカラー参照実装)
+		static void blendRowRgba8888Scalar(std::uint8_t* const dst, const std::uint8_t* const blend, const std::int32_t width);
+		//RGBA8888画像1行をデコード後のフォーマットへ変換(srcとdstは同じ領域でもよい)
+		//yは行の位置(ディザのパターン選択に使用)、isDitherは16bitフォーマットで4x4の組織的ディザを行うか
+		static void convRowFromRgba8888(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::int32_t y, const bool isDither);
+		//RGBA8888画像1行をデコード後のフォーマットへ変換(変換処理パス指定)
+		static void convRowFromRgba8888(const EN_ConvPath path, const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::int32_t y, const bool isDither);
+		//RGBA8888画像1行をデコード後のフォーマットへ変換(スカラー参照実装)
+		static void convRowFromRgba8888Scalar(const EN_DecodeFormat format, const std::uint8_t* const src, std::uint8_t* const dst, const std::int32_t width, const std::int32_t y, const bool isDither);
+		//RGBA8888画像を拡大縮小(バイリニア)
+		static void resizeRgba8888(const std::uint8_t* const src, const std::int32_t srcWidth, const std::int32_t srcHeight, const std::int32_t srcStride,
+			std::uint8_t* const dst, const std::int32_t dstWidth, const std::int32_t dstHeight, const std::int32_t dstStride);
+		//変換元1ピクセルあたりのバイト数を取得
+		static std::int32_t getBytePerPixel(const EN_PixelFormat format);
+		//デコード後の1ピクセルあたりのバイト数を取得
+		static std::int32_t getBytePerPixel(const EN_DecodeFormat format);
+		//CPU機能から選択した変換処理パスを取得
+		static EN_ConvPath getPath();
+	};
+}
+
+#endif //INCLUDED_PIXELCONV_HPP
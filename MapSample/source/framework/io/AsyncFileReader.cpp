@@ -0,0 +1,463 @@
+﻿#include "AsyncFileReader.hpp"
+#include "File.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+//io_uring使用可否(Linuxでカーネルヘッダがある場合のみ、ライブラリは使わずシステムコールを直接呼ぶ)
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FW_IO_URING
+#endif
+#endif
+
+#if defined(FW_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	//1タスクでまとめて読み込む要求数(io_uringは1回で投入する数)
+	static const size_t READ_CHUNK_NUM = 16;
+	//io_uringで1回に読み込む最大バイト数(超える要求はpreadで読み込む)
+	static const size_t URING_MAX_SIZE = size_t(1) << 30;
+
+	//同じファイルへの要求のまとまり(オープンは最初に実行されたタスクが行う)
+	struct ReadGroup {
+		std::string		filePath_;	//ファイルパス
+		std::once_flag	once_;		//オープン済み
+		fw::File		file_;		//ファイル
+		bool			isOpen_;	//オープン成功
+	};
+
+	//読み込み結果の通知先
+	using ReadDeliver = std::function<void(const size_t index, fw::FileReadResult& result)>;
+
+	//要求の読み込みバイト数を確定(範囲外はfalse)
+	static bool getReadSize(const fw::FileReadRequest& request, const std::uint64_t fileSize, size_t* const size)
+	{
+		if (request.offset_ > fileSize) {
+			return false;
+		}
+		const std::uint64_t restSize = fileSize - request.offset_;
+		if (request.size_ == 0) {
+			//ファイル末尾まで
+			if (restSize > std::uint64_t(SIZE_MAX)) {
+				return false;
+			}
+			*size = size_t(restSize);
+			return true;
+		}
+		if (std::uint64_t(request.size_) > restSize) {
+			return false;
+		}
+		*size = request.size_;
+		return true;
+	}
+
+#if defined(FW_IO_URING)
+
+	//----------------------------------------------------------
+	//
+	// io_uring(読み込みのみ、1スレッド専用)
+	//
+	//----------------------------------------------------------
+
+	class Uring {
+		//メンバ変数
+		int					fd_;			//io_uringのファイルディスクリプタ
+		void*				sqRing_;		//投入キューのマップ先
+		size_t				sqRingSize_;	//投入キューのマップサイズ
+		void*				cqRing_;		//完了キューのマップ先(投入キューと共有の場合は同じ)
+		size_t				cqRingSize_;	//完了キューのマップサイズ
+		io_uring_sqe*		sqes_;			//投入エントリ
+		size_t				sqesSize_;		//投入エントリのマップサイズ
+		unsigned*			sqTail_;		//投入キューの末尾
+		unsigned*			sqMask_;		//投入キューのマスク
+		unsigned*			sqArray_;		//投入キューの配列
+		unsigned*			cqHead_;		//完了キューの先頭
+		unsigned*			cqTail_;		//完了キューの末尾
+		unsigned*			cqMask_;		//完了キューのマスク
+		io_uring_cqe*		cqes_;			//完了エントリ
+		unsigned			entryNum_;		//投入キューのエントリ数
+
+	public:
+		//コンストラクタ
+		Uring() :
+			fd_(-1), sqRing_(MAP_FAILED), sqRingSize_(0), cqRing_(MAP_FAILED), cqRingSize_(0), sqes_(nullptr), sqesSize_(0),
+			sqTail_(nullptr), sqMask_(nullptr), sqArray_(nullptr), cqHead_(nullptr), cqTail_(nullptr), cqMask_(nullptr), cqes_(nullptr), entryNum_(0)
+		{
+		}
+
+		//デストラクタ
+		~Uring()
+		{
+			if (this->sqes_ != nullptr) {
+				(void)munmap(this->sqes_, this->sqesSize_);
+			}
+			if ((this->cqRing_ != MAP_FAILED) && (this->cqRing_ != this->sqRing_)) {
+				(void)munmap(this->cqRing_, this->cqRingSize_);
+			}
+			if (this->sqRing_ != MAP_FAILED) {
+				(void)munmap(this->sqRing_, this->sqRingSize_);
+			}
+			if (this->fd_ >= 0) {
+				(void)close(this->fd_);
+			}
+		}
+
+		//初期化(カーネルが未対応、制限されている場合はfalse)
+		bool init(const unsigned entryNum)
+		{
+			io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+			this->fd_ = int(syscall(__NR_io_uring_setup, entryNum, &params));
+			if (this->fd_ < 0) {
+				return false;
+			}
+
+			//投入キュー、完了キューをマップ(対応していれば1回のマップで共有)
+			this->sqRingSize_ = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+			this->cqRingSize_ = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+			const bool isSingleMap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+			if (isSingleMap) {
+				this->sqRingSize_ = std::max(this->sqRingSize_, this->cqRingSize_);
+				this->cqRingSize_ = this->sqRingSize_;
+			}
+			this->sqRing_ = mmap(nullptr, this->sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd_, IORING_OFF_SQ_RING);
+			if (this->sqRing_ == MAP_FAILED) {
+				return false;
+			}
+			this->cqRing_ = isSingleMap ? this->sqRing_ : mmap(nullptr, this->cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd_, IORING_OFF_CQ_RING);
+			if (this->cqRing_ == MAP_FAILED) {
+				return false;
+			}
+			this->sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+			void* sqes = mmap(nullptr, this->sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd_, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED) {
+				return false;
+			}
+			this->sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+			std::uint8_t* const sq = static_cast<std::uint8_t*>(this->sqRing_);
+			std::uint8_t* const cq = static_cast<std::uint8_t*>(this->cqRing_);
+			this->sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			this->sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			this->sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			this->cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			this->cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			this->cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			this->cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			this->entryNum_ = params.sq_entries;
+
+			return true;
+		}
+
+		//投入キューのエントリ数を取得
+		unsigned getEntryNum() const
+		{
+			return this->entryNum_;
+		}
+
+		//読み込みを投入して全ての完了を待つ(resultsへ読み込んだバイト数または-errnoを格納、未投入の分は変更しない)
+		//numはエントリ数以下とし、投入できなかった場合はfalse(以降は使わないこと)
+		bool read(const int fd, std::uint8_t* const* const data, const std::uint64_t* const offsets, const size_t* const sizes, const unsigned num, std::int32_t* const results)
+		{
+			//投入エントリを作成(カーネルが参照する末尾は最後に更新する)
+			const unsigned mask = *this->sqMask_;
+			unsigned tail = *this->sqTail_;
+			for (unsigned i = 0; i < num; i++) {
+				const unsigned index = tail & mask;
+				io_uring_sqe* const sqe = &this->sqes_[index];
+				std::memset(sqe, 0, sizeof(*sqe));
+				sqe->opcode = IORING_OP_READ;
+				sqe->fd = fd;
+				sqe->off = offsets[i];
+				sqe->addr = std::uint64_t(reinterpret_cast<uintptr_t>(data[i]));
+				sqe->len = std::uint32_t(sizes[i]);
+				sqe->user_data = i;
+				this->sqArray_[index] = index;
+				tail++;
+			}
+			__atomic_store_n(this->sqTail_, tail, __ATOMIC_RELEASE);
+
+			//投入と完了待ち(割り込まれた場合は残りを待つ)
+			bool isOk = true;
+			unsigned submitNum = num;
+			unsigned waitNum = num;
+			unsigned doneNum = 0;
+			while (doneNum < waitNum) {
+				const int rc = int(syscall(__NR_io_uring_enter, this->fd_, submitNum, waitNum - doneNum, IORING_ENTER_GETEVENTS, nullptr, 0));
+				if (rc < 0) {
+					if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY)) {
+						continue;
+					}
+					if (submitNum == 0) {
+						//投入済みの完了を待てない(読み込み先を解放できないため呼び出し元は中断する)
+						std::abort();
+					}
+					//投入できなかった分は取り消し、投入済みの分の完了のみ待つ
+					tail -= submitNum;
+					__atomic_store_n(this->sqTail_, tail, __ATOMIC_RELEASE);
+					waitNum -= submitNum;
+					submitNum = 0;
+					isOk = false;
+					continue;
+				}
+				submitNum -= std::min(submitNum, unsigned(rc));
+
+				//完了エントリを回収
+				unsigned head = *this->cqHead_;
+				const unsigned cqTail = __atomic_load_n(this->cqTail_, __ATOMIC_ACQUIRE);
+				while (head != cqTail) {
+					const io_uring_cqe& cqe = this->cqes_[head & *this->cqMask_];
+					if (cqe.user_data < num) {
+						results[cqe.user_data] = cqe.res;
+						doneNum++;
+					}
+					head++;
+				}
+				__atomic_store_n(this->cqHead_, head, __ATOMIC_RELEASE);
+			}
+
+			return isOk;
+		}
+	};
+
+	//I/Oスレッド毎のio_uringを取得(使えない場合は空)
+	static std::unique_ptr<Uring>& getThreadUring()
+	{
+		static thread_local std::unique_ptr<Uring> uring;
+		static thread_local bool isInit = false;
+		if (!isInit) {
+			isInit = true;
+			std::unique_ptr<Uring> newUring(new Uring());
+			if (newUring->init(unsigned(READ_CHUNK_NUM))) {
+				uring = std::move(newUring);
+			}
+		}
+		return uring;
+	}
+
+	//io_uringで読み込み(途中までしか読めなかった要求、io_uringで失敗した要求はpreadで読み直す)
+	//投入できなかった場合はfalse
+	static bool readByUring(Uring* const uring, const fw::File& file, const std::vector<std::uint64_t>& offsets, std::vector<fw::FileReadResult>* const results)
+	{
+		std::vector<std::uint8_t*> data;
+		std::vector<std::uint64_t> uringOffsets;
+		std::vector<size_t> sizes;
+		std::vector<size_t> targets;
+		for (size_t i = 0; i < results->size(); i++) {
+			fw::FileReadResult& result = (*results)[i];
+			if (!result.isOk_ || result.data_.empty() || (result.data_.size() > URING_MAX_SIZE)) {
+				continue;
+			}
+			data.push_back(result.data_.data());
+			uringOffsets.push_back(offsets[i]);
+			sizes.push_back(result.data_.size());
+			targets.push_back(i);
+		}
+
+		bool isOk = true;
+		std::vector<std::int32_t> readSizes(targets.size(), -1);
+		for (size_t begin = 0; isOk && (begin < targets.size()); begin += uring->getEntryNum()) {
+			const unsigned num = unsigned(std::min(targets.size() - begin, size_t(uring->getEntryNum())));
+			isOk = uring->read(file.getFd(), &data[begin], &uringOffsets[begin], &sizes[begin], num, &readSizes[begin]);
+		}
+
+		for (size_t i = 0; i < targets.size(); i++) {
+			if ((readSizes[i] >= 0) && (size_t(readSizes[i]) == sizes[i])) {
+				continue;
+			}
+			const size_t doneSize = (readSizes[i] > 0) ? size_t(readSizes[i]) : 0;
+			fw::FileReadResult& result = (*results)[targets[i]];
+			result.isOk_ = file.read(result.data_.data() + doneSize, uringOffsets[i] + doneSize, sizes[i] - doneSize);
+		}
+
+		return isOk;
+	}
+#endif
+
+	//オープン済みのファイルから要求をまとめて読み込み、結果を通知(fileがnullptrの場合はオープン失敗として通知)
+	static void readFile(const fw::File* const file, const std::vector<fw::FileReadRequest>* const requests, const std::vector<size_t>& targets,
+		const bool isUring, const ReadDeliver& deliver)
+	{
+		//読み込み先を確保
+		std::vector<fw::FileReadResult> results(targets.size());
+		std::vector<std::uint64_t> offsets(targets.size(), 0);
+		for (size_t i = 0; i < targets.size(); i++) {
+			const fw::FileReadRequest& request = (*requests)[targets[i]];
+			size_t size = 0;
+			results[i].isOk_ = (file != nullptr) && getReadSize(request, file->getFileSize(), &size);
+			if (results[i].isOk_) {
+				results[i].data_.resize(size);
+			}
+			offsets[i] = request.offset_;
+		}
+
+		//読み込み
+		bool isRead = false;
+#if defined(FW_IO_URING)
+		if (isUring && (file != nullptr)) {
+			std::unique_ptr<Uring>& uring = getThreadUring();
+			if (uring) {
+				if (!readByUring(uring.get(), *file, offsets, &results)) {
+					//以降このスレッドはpreadで読み込む
+					uring.reset();
+				}
+				isRead = true;
+			}
+		}
+#else
+		(void)isUring;
+#endif
+		if (!isRead) {
+			for (size_t i = 0; i < targets.size(); i++) {
+				fw::FileReadResult& result = results[i];
+				if (result.isOk_ && !result.data_.empty()) {
+					result.isOk_ = file->read(result.data_.data(), offsets[i], result.data_.size());
+				}
+			}
+		}
+
+		//結果を通知
+		for (size_t i = 0; i < targets.size(); i++) {
+			if (!results[i].isOk_) {
+				results[i].data_.clear();
+			}
+			deliver(targets[i], results[i]);
+		}
+	}
+
+	//同じファイルへの要求をまとめて読み込み、結果を通知(オープンはグループで1回のみ)
+	static void readChunk(ReadGroup* const group, const std::vector<fw::FileReadRequest>* const requests, const std::vector<size_t>& targets,
+		const bool isUring, const ReadDeliver& deliver)
+	{
+		std::call_once(group->once_, [group] {
+			group->isOpen_ = group->file_.create(group->filePath_) && group->file_.open("rb");
+		});
+
+		readFile(group->isOpen_ ? &group->file_ : nullptr, requests, targets, isUring, deliver);
+	}
+
+	//要求をファイル毎にまとめてI/Oスレッドへ登録
+	static void postRequests(fw::ThreadPool& pool, const std::vector<fw::FileReadRequest>& requests, const bool isUring, const ReadDeliver& deliver)
+	{
+		//要求はタスクから参照するため共有で保持
+		std::shared_ptr<std::vector<fw::FileReadRequest>> shared = std::make_shared<std::vector<fw::FileReadRequest>>(requests);
+
+		//ファイル毎に読み込み位置の順で並べる
+		std::map<std::string, std::vector<size_t>> fileTargets;
+		for (size_t i = 0; i < requests.size(); i++) {
+			fileTargets[requests[i].filePath_].push_back(i);
+		}
+
+		for (auto itr = fileTargets.begin(); itr != fileTargets.end(); itr++) {
+			std::vector<size_t>& targets = itr->second;
+			std::stable_sort(targets.begin(), targets.end(), [&requests](const size_t a, const size_t b) { return (requests[a].offset_ < requests[b].offset_); });
+
+			//一定数毎に1タスクとし、同じファイルの要求も複数スレッドで読み込めるようにする
+			std::shared_ptr<ReadGroup> group = std::make_shared<ReadGroup>();
+			group->filePath_ = itr->first;
+			group->isOpen_ = false;
+			for (size_t begin = 0; begin < targets.size(); begin += READ_CHUNK_NUM) {
+				const size_t end = std::min(begin + READ_CHUNK_NUM, targets.size());
+				const std::vector<size_t> chunk(targets.begin() + begin, targets.begin() + end);
+				pool.post([group, shared, chunk, isUring, deliver] {
+					readChunk(group.get(), shared.get(), chunk, isUring, deliver);
+				});
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------
+//
+// 非同期ファイル読み込みクラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::AsyncFileReader::AsyncFileReader(const std::int32_t threadNum, const bool isUring) :
+	pool_(std::max(threadNum, std::int32_t(1))), isUring_(false)
+{
+#if defined(FW_IO_URING)
+	if (isUring) {
+		//カーネルが対応しているか確認
+		Uring uring;
+		this->isUring_ = uring.init(unsigned(READ_CHUNK_NUM));
+	}
+#else
+	(void)isUring;
+#endif
+}
+
+//デストラクタ
+fw::AsyncFileReader::~AsyncFileReader()
+{
+	//登録済みの要求はスレッドプールの破棄で全て完了する
+}
+
+//一括読み込み(要求毎のfutureを返す)
+std::vector<std::future<fw::FileReadResult>> fw::AsyncFileReader::read(const std::vector<FileReadRequest>& requests)
+{
+	std::shared_ptr<std::vector<std::promise<FileReadResult>>> promises = std::make_shared<std::vector<std::promise<FileReadResult>>>(requests.size());
+	std::vector<std::future<FileReadResult>> futures;
+	futures.reserve(requests.size());
+	for (auto itr = promises->begin(); itr != promises->end(); itr++) {
+		futures.push_back(itr->get_future());
+	}
+
+	postRequests(this->pool_, requests, this->isUring_, [promises](const size_t index, FileReadResult& result) {
+		(*promises)[index].set_value(std::move(result));
+	});
+
+	return futures;
+}
+
+//一括読み込み(要求毎に読み込み完了コールバックを呼ぶ)
+void fw::AsyncFileReader::read(const std::vector<FileReadRequest>& requests, const FileReadCallback& callback)
+{
+	postRequests(this->pool_, requests, this->isUring_, callback);
+}
+
+//オープン済みのファイルから読み込み
+std::future<fw::FileReadResult> fw::AsyncFileReader::read(const std::shared_ptr<const File>& file, const std::uint64_t offset, const size_t size)
+{
+	std::shared_ptr<std::promise<FileReadResult>> promise = std::make_shared<std::promise<FileReadResult>>();
+	std::future<FileReadResult> future = promise->get_future();
+
+	//ファイルパスは使わない
+	const FileReadRequest request = { std::string(), offset, size };
+	std::shared_ptr<std::vector<FileReadRequest>> shared = std::make_shared<std::vector<FileReadRequest>>(1, request);
+	const bool isUring = this->isUring_;
+	this->pool_.post([file, shared, promise, isUring] {
+		readFile(file.get(), shared.get(), std::vector<size_t>(1, 0), isUring, [&promise](const size_t index, FileReadResult& result) {
+			(void)index;
+			promise->set_value(std::move(result));
+		});
+	});
+
+	return future;
+}
+
+//io_uringを使っているか
+bool fw::AsyncFileReader::isUring() const
+{
+	return this->isUring_;
+}
+
+//既定の非同期ファイル読み込みを取得
+fw::AsyncFileReader& fw::AsyncFileReader::getDefault()
+{
+	static AsyncFileReader reader;
+	return reader;
+}
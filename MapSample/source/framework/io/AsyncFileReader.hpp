@@ -0,0 +1,79 @@
+﻿#ifndef INCLUDED_ASYNCFILEREADER_HPP
+#define INCLUDED_ASYNCFILEREADER_HPP
+
+#include "Std.hpp"
+#include "ThreadPool.hpp"
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fw {
+
+	class File;
+
+	//ファイル読み込み要求
+	struct FileReadRequest {
+		std::string		filePath_;	//ファイルパス
+		std::uint64_t	offset_;	//読み込み位置
+		size_t			size_;		//読み込みバイト数(0は読み込み位置からファイル末尾まで)
+	};
+
+	//ファイル読み込み結果
+	struct FileReadResult {
+		bool						isOk_;	//成功有無(オープン失敗、範囲がファイルサイズを超える場合はfalse)
+		std::vector<std::uint8_t>	data_;	//読み込んだデータ(失敗時は空)
+	};
+
+	//読み込み完了コールバック(I/Oスレッドから呼ばれる、indexは要求の位置、resultはムーブしてよい)
+	using FileReadCallback = std::function<void(const size_t index, FileReadResult& result)>;
+
+	//----------------------------------------------------------
+	//
+	// 非同期ファイル読み込みクラス
+	//
+	// 読み込み要求をまとめて受け取り、I/O専用の少数のスレッドで読み込む。
+	// 同じファイルへの要求は1回だけオープンし、読み込み位置の順に位置指定で読み込む。
+	// Linuxでio_uringを有効にした場合は要求をまとめて投入し、使えない場合はpreadで読み込む。
+	// デストラクタは登録済みの要求を全て完了してから終了する。
+	//
+	//----------------------------------------------------------
+
+	class AsyncFileReader {
+	public:
+		//既定のI/Oスレッド数
+		static const std::int32_t DEFAULT_THREAD_NUM = 2;
+
+	private:
+		//メンバ変数
+		ThreadPool		pool_;		//I/Oスレッド
+		bool			isUring_;	//io_uringを使うか
+
+	public:
+		//コンストラクタ
+		//isUringがtrueの場合はio_uringを使う(Linux以外、カーネルが未対応の場合は無視してpreadを使う)
+		AsyncFileReader(const std::int32_t threadNum = DEFAULT_THREAD_NUM, const bool isUring = false);
+		//デストラクタ
+		~AsyncFileReader();
+		//一括読み込み(要求毎のfutureを返す)
+		std::vector<std::future<FileReadResult>> read(const std::vector<FileReadRequest>& requests);
+		//一括読み込み(要求毎に読み込み完了コールバックを呼ぶ、完了を待たずに戻る)
+		void read(const std::vector<FileReadRequest>& requests, const FileReadCallback& callback);
+		//オープン済みのファイルからoffsetの位置のsizeバイト(0はファイル末尾まで)を読み込む
+		//ファイルは読み込み完了まで共有で保持し、要求毎にオープンし直さない(同じファイルを順に読み込むストリーム向け)
+		std::future<FileReadResult> read(const std::shared_ptr<const File>& file, const std::uint64_t offset, const size_t size);
+		//io_uringを使っているか
+		bool isUring() const;
+
+		//既定の非同期ファイル読み込みを取得(io_uringは使わない)
+		static AsyncFileReader& getDefault();
+
+		//コピーコンストラクタ(禁止)
+		AsyncFileReader(const AsyncFileReader& org) = delete;
+		//代入演算子(禁止)
+		AsyncFileReader& operator=(const AsyncFileReader& org) = delete;
+	};
+}
+
+#endif //INCLUDED_ASYNCFILEREADER_HPP
@@ -0,0 +1,106 @@
+﻿#ifndef INCLUDED_BYTEIO_HPP
+#define INCLUDED_BYTEIO_HPP
+
+#include "Std.hpp"
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// バイト列読み込みクラス
+	//
+	// バイト列から指定のバイトオーダーで数値を読み込む(アラインメント不要)。
+	//
+	//----------------------------------------------------------
+
+	class ByteReader {
+	public:
+		//1バイトを読み込み(LE)
+		static void read1ByteLe(const std::uint8_t* const data, std::uint8_t* const readData)
+		{
+			*readData = *(data + 0);
+		}
+
+		//2バイトを読み込み(LE)
+		static std::uint16_t read2ByteLe(const std::uint8_t* const data)
+		{
+			return std::uint16_t(std::uint16_t(*(data + 0)) | (std::uint16_t(*(data + 1)) << 8));
+		}
+		static void read2ByteLe(const std::uint8_t* const data, std::uint16_t* const readData)
+		{
+			*readData = read2ByteLe(data);
+		}
+
+		//4バイトを読み込み(LE)
+		static std::uint32_t read4ByteLe(const std::uint8_t* const data)
+		{
+			return (std::uint32_t(*(data + 0)) << 0) | (std::uint32_t(*(data + 1)) << 8) | (std::uint32_t(*(data + 2)) << 16) | (std::uint32_t(*(data + 3)) << 24);
+		}
+		static void read4ByteLe(const std::uint8_t* const data, std::uint32_t* const readData)
+		{
+			*readData = read4ByteLe(data);
+		}
+
+		//8バイトを読み込み(LE)
+		static std::uint64_t read8ByteLe(const std::uint8_t* const data)
+		{
+			return std::uint64_t(read4ByteLe(data)) | (std::uint64_t(read4ByteLe(data + 4)) << 32);
+		}
+
+		//2バイトを読み込み(BE)
+		static std::uint16_t read2ByteBe(const std::uint8_t* const data)
+		{
+			return std::uint16_t((std::uint16_t(*(data + 0)) << 8) | std::uint16_t(*(data + 1)));
+		}
+		static void read2ByteBe(const std::uint8_t* const data, std::uint16_t* const readData)
+		{
+			*readData = read2ByteBe(data);
+		}
+
+		//4バイトを読み込み(BE)
+		static std::uint32_t read4ByteBe(const std::uint8_t* const data)
+		{
+			return (std::uint32_t(*(data + 0)) << 24) | (std::uint32_t(*(data + 1)) << 16) | (std::uint32_t(*(data + 2)) << 8) | (std::uint32_t(*(data + 3)) << 0);
+		}
+		static void read4ByteBe(const std::uint8_t* const data, std::uint32_t* const readData)
+		{
+			*readData = read4ByteBe(data);
+		}
+	};
+
+	//----------------------------------------------------------
+	//
+	// バイト列書き込みクラス
+	//
+	// 数値を指定のバイトオーダーでバイト列へ書き込む(アラインメント不要)。
+	//
+	//----------------------------------------------------------
+
+	class ByteWriter {
+	public:
+		//2バイトを書き込み(LE)
+		static void write2ByteLe(std::uint8_t* const data, const std::uint16_t value)
+		{
+			*(data + 0) = std::uint8_t(value >> 0);
+			*(data + 1) = std::uint8_t(value >> 8);
+		}
+
+		//4バイトを書き込み(LE)
+		static void write4ByteLe(std::uint8_t* const data, const std::uint32_t value)
+		{
+			*(data + 0) = std::uint8_t(value >> 0);
+			*(data + 1) = std::uint8_t(value >> 8);
+			*(data + 2) = std::uint8_t(value >> 16);
+			*(data + 3) = std::uint8_t(value >> 24);
+		}
+
+		//8バイトを書き込み(LE)
+		static void write8ByteLe(std::uint8_t* const data, const std::uint64_t value)
+		{
+			write4ByteLe(data, std::uint32_t(value));
+			write4ByteLe(data + 4, std::uint32_t(value >> 32));
+		}
+	};
+}
+
+#endif //INCLUDED_BYTEIO_HPP
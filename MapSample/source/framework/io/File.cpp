@@ -1,15 +1,83 @@
 ﻿#include "File.hpp"
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	//1回の読み書きの最大バイト数(ReadFile,WriteFileの指定がDWORDのため分割する)
+	static const size_t IO_MAX_SIZE = size_t(1) << 30;
+
+	//オープンモード
+	struct OpenMode {
+		bool	isRead_;		//読み込み可
+		bool	isWrite_;		//書き込み可
+		bool	isCreate_;		//なければ作成
+		bool	isTruncate_;	//既存の内容を破棄
+		bool	isAppend_;		//末尾へ追加
+	};
+
+	//fopen形式のモード文字列を解析
+	static bool parseMode(const std::string& mode, OpenMode* const openMode)
+	{
+		if (mode.empty()) {
+			return false;
+		}
+		const bool isPlus = (mode.find('+') != std::string::npos);
+		switch (mode[0]) {
+		case 'r':
+			*openMode = { true, isPlus, false, false, false };
+			break;
+		case 'w':
+			*openMode = { isPlus, true, true, true, false };
+			break;
+		case 'a':
+			*openMode = { isPlus, true, true, false, true };
+			break;
+		default:
+			return false;
+		}
+		return true;
+	}
+
+	//ページサイズを取得
+	static size_t getPageSize()
+	{
+#if defined(_WIN32)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return size_t(info.dwPageSize);
+#else
+		return size_t(sysconf(_SC_PAGESIZE));
+#endif
+	}
+}
 
 
 //----------------------------------------------------------
 //
 // ファイルクラス
 //
+// 読み書きは位置を指定して行い(Windowsは位置指定のReadFile,WriteFile、それ以外はpread,pwrite)、
+// ファイル位置を共有しないため1つのファイルを複数スレッドから同時に読み込める。
+//
 //----------------------------------------------------------
 
 //コンストラクタ
 fw::File::File()
-	: filePath_(), fileSize_(0), fp_(nullptr)
+#if defined(_WIN32)
+	: filePath_(), fileSize_(0), writePos_(0), handle_(nullptr), mapData_(nullptr), mapHandle_(nullptr)
+#else
+	: filePath_(), fileSize_(0), writePos_(0), fd_(-1), mapData_(nullptr), mapHandle_(nullptr)
+#endif
 {
 }
 
@@ -40,24 +108,64 @@ bool fw::File::open(const std::string& mode)
 		//未作成
 		return false;
 	}
-	if (this->fp_ != nullptr) {
+	OpenMode openMode;
+	if (!parseMode(mode, &openMode)) {
+		//不正なモード
+		return false;
+	}
+
+#if defined(_WIN32)
+	if (this->handle_ != nullptr) {
+		//オープン済み
+		return false;
+	}
+
+	//ファイルオープン(fopenと同様に他からの読み書きは許可する)
+	const DWORD access = (openMode.isRead_ ? GENERIC_READ : 0) | (openMode.isWrite_ ? GENERIC_WRITE : 0);
+	const DWORD disposition = openMode.isTruncate_ ? CREATE_ALWAYS : (openMode.isCreate_ ? OPEN_ALWAYS : OPEN_EXISTING);
+	HANDLE handle = CreateFileA(this->filePath_.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		//オープン失敗
+		return false;
+	}
+
+	//ファイルサイズ取得
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size)) {
+		(void)CloseHandle(handle);
+		return false;
+	}
+	this->handle_ = handle;
+	this->fileSize_ = std::uint64_t(size.QuadPart);
+#else
+	if (this->fd_ >= 0) {
 		//オープン済み
 		return false;
 	}
 
 	//ファイルオープン
-	(void)fopen_s(&this->fp_, this->filePath_.c_str(), mode.c_str());
-	if (this->fp_ == nullptr) {
+	//追加モードも書き込み位置を末尾から管理するためO_APPENDは使わない(pwriteの位置指定が無視されるため)
+	int flags = (openMode.isRead_ && openMode.isWrite_) ? O_RDWR : (openMode.isWrite_ ? O_WRONLY : O_RDONLY);
+	flags |= (openMode.isCreate_ ? O_CREAT : 0) | (openMode.isTruncate_ ? O_TRUNC : 0) | O_CLOEXEC;
+	int fd = -1;
+	do {
+		fd = ::open(this->filePath_.c_str(), flags, 0644);
+	} while ((fd < 0) && (errno == EINTR));
+	if (fd < 0) {
 		//オープン失敗
 		return false;
 	}
 
 	//ファイルサイズ取得
-	fpos_t pos;
-	(void)fseek(this->fp_, 0, SEEK_END);
-	(void)fgetpos(this->fp_, &pos);
-	(void)fseek(this->fp_, 0, SEEK_SET);
-	this->fileSize_ = static_cast<size_t>(pos);
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		(void)::close(fd);
+		return false;
+	}
+	this->fd_ = fd;
+	this->fileSize_ = std::uint64_t(st.st_size);
+#endif
+	this->writePos_ = openMode.isAppend_ ? this->fileSize_ : 0;
 
 	return true;
 }
@@ -65,47 +173,291 @@ bool fw::File::open(const std::string& mode)
 //ファイルクローズ
 void fw::File::close()
 {
-	if (this->fp_ != nullptr) {
+	//マップ解除
+	this->unmap();
+
+#if defined(_WIN32)
+	if (this->handle_ != nullptr) {
 		//ファイルクローズ
-		(void)fclose(this->fp_);
-		this->fp_ = nullptr;
+		(void)CloseHandle(HANDLE(this->handle_));
+		this->handle_ = nullptr;
 	}
+#else
+	if (this->fd_ >= 0) {
+		//ファイルクローズ
+		(void)::close(this->fd_);
+		this->fd_ = -1;
+	}
+#endif
 	this->fileSize_ = 0;
+	this->writePos_ = 0;
 }
 
 //ファイル読み込み
-bool fw::File::read(std::uint8_t** const data, const std::int32_t offset, const size_t size)
+bool fw::File::read(std::uint8_t* const data, const std::uint64_t offset, const size_t size) const
 {
 	if (this->filePath_.empty()) {
 		//未作成
 		return false;
 	}
-	if (this->fp_ == nullptr) {
+#if defined(_WIN32)
+	if (this->handle_ == nullptr) {
+#else
+	if (this->fd_ < 0) {
+#endif
 		//未オープン
 		return false;
 	}
-	if (this->fileSize_ < (offset + size)) {
+	if ((offset > this->fileSize_) || (std::uint64_t(size) > (this->fileSize_ - offset))) {
 		//読み込み範囲がファイルサイズを超える
 		return false;
 	}
 
-	FILE* fp = this->fp_;
+	//ファイル読み込み(途中までしか読めなかった場合は続きを読む)
+	size_t readSize = 0;
+	while (readSize < size) {
+		const std::uint64_t pos = offset + readSize;
+		const size_t reqSize = ((size - readSize) < IO_MAX_SIZE) ? (size - readSize) : IO_MAX_SIZE;
+#if defined(_WIN32)
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = DWORD(pos);
+		overlapped.OffsetHigh = DWORD(pos >> 32);
+		DWORD n = 0;
+		if (!ReadFile(HANDLE(this->handle_), data + readSize, DWORD(reqSize), &n, &overlapped) || (n == 0)) {
+			//読み込み失敗
+			return false;
+		}
+#else
+		const ssize_t n = pread(this->fd_, data + readSize, reqSize, off_t(pos));
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			//読み込み失敗
+			return false;
+		}
+		if (n == 0) {
+			//ファイルが途中で切り詰められた
+			return false;
+		}
+#endif
+		readSize += size_t(n);
+	}
 
-	//読み込み位置を移動
-	(void)fseek(this->fp_, offset, SEEK_SET);
+	return true;
+}
 
-	//ファイル読み込み
-	size_t readSize = fread_s(*data, size, 1, size, fp);
-	if (readSize != size) {
-		//読み込み失敗
+//ファイル書き込み
+bool fw::File::write(const std::uint8_t* const data, const size_t size)
+{
+	if (this->filePath_.empty()) {
+		//未作成
+		return false;
+	}
+#if defined(_WIN32)
+	if (this->handle_ == nullptr) {
+#else
+	if (this->fd_ < 0) {
+#endif
+		//未オープン
 		return false;
 	}
 
+	//ファイル書き込み
+	size_t writeSize = 0;
+	while (writeSize < size) {
+		const std::uint64_t pos = this->writePos_ + writeSize;
+		const size_t reqSize = ((size - writeSize) < IO_MAX_SIZE) ? (size - writeSize) : IO_MAX_SIZE;
+#if defined(_WIN32)
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = DWORD(pos);
+		overlapped.OffsetHigh = DWORD(pos >> 32);
+		DWORD n = 0;
+		if (!WriteFile(HANDLE(this->handle_), data + writeSize, DWORD(reqSize), &n, &overlapped) || (n == 0)) {
+			//書き込み失敗
+			return false;
+		}
+#else
+		const ssize_t n = pwrite(this->fd_, data + writeSize, reqSize, off_t(pos));
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			//書き込み失敗
+			return false;
+		}
+		if (n == 0) {
+			//書き込み失敗
+			return false;
+		}
+#endif
+		writeSize += size_t(n);
+	}
+
+	//書き込み位置、ファイルサイズ更新
+	this->writePos_ += size;
+	if (this->writePos_ > this->fileSize_) {
+		this->fileSize_ = this->writePos_;
+	}
+
 	return true;
 }
 
 //ファイルサイズ取得
-size_t fw::File::getFileSize()
+std::uint64_t fw::File::getFileSize() const
 {
 	return this->fileSize_;
 }
+
+#if !defined(_WIN32)
+//ファイルディスクリプタ取得
+int fw::File::getFd() const
+{
+	return this->fd_;
+}
+#endif
+
+//ファイル全体を読み込み専用でマップ
+std::uint8_t* fw::File::map()
+{
+	if (this->mapData_ != nullptr) {
+		//マップ済み
+		return this->mapData_;
+	}
+	if (this->fileSize_ == 0) {
+		//未オープン、空ファイルはマップ不可
+		return nullptr;
+	}
+	if (this->fileSize_ > std::uint64_t(SIZE_MAX)) {
+		//アドレス空間に収まらない
+		return nullptr;
+	}
+
+#if defined(_WIN32)
+	HANDLE mapping = CreateFileMappingW(HANDLE(this->handle_), nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		return nullptr;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size_t(this->fileSize_));
+	if (data == nullptr) {
+		(void)CloseHandle(mapping);
+		return nullptr;
+	}
+	this->mapHandle_ = mapping;
+#else
+	void* data = mmap(nullptr, size_t(this->fileSize_), PROT_READ, MAP_PRIVATE, this->fd_, 0);
+	if (data == MAP_FAILED) {
+		return nullptr;
+	}
+#endif
+	this->mapData_ = static_cast<std::uint8_t*>(data);
+
+	return this->mapData_;
+}
+
+//マップ先の参照を取得
+fw::FileView fw::File::view(const size_t offset, const size_t size)
+{
+	FileView fileView = { nullptr, 0 };
+	const std::uint8_t* const data = this->map();
+	if (data == nullptr) {
+		//マップ失敗
+		return fileView;
+	}
+
+	const size_t fileSize = size_t(this->fileSize_);
+	if ((offset > fileSize) || (size > (fileSize - offset))) {
+		//範囲がファイルサイズを超える
+		return fileView;
+	}
+	fileView.data_ = data + offset;
+	fileView.size_ = size;
+
+	return fileView;
+}
+
+//マップした範囲のアクセス方法を通知
+void fw::File::advise(const size_t offset, const size_t size, const EN_FileAdvice advice)
+{
+	//マップ済みの場合はファイルサイズがsize_tに収まる
+	const size_t fileSize = size_t(this->fileSize_);
+	if ((this->mapData_ == nullptr) || (offset >= fileSize) || (size == 0)) {
+		return;
+	}
+
+	//範囲を含むページ全体に広げる(通知のみのため前後の画像と共有するページも含めてよい)
+	const size_t pageSize = getPageSize();
+	const size_t end = (size < (fileSize - offset)) ? (offset + size) : fileSize;
+	const size_t begin = (offset / pageSize) * pageSize;
+
+#if defined(_WIN32)
+	//Windowsは先読みのみ対応(順次、不規則の指定はマップに対して行えない)
+#if defined(_WIN32_WINNT_WIN8) && (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+	if (advice == D_FILEADVICE_WILLNEED) {
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = this->mapData_ + begin;
+		range.NumberOfBytes = end - begin;
+		(void)PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#endif
+#else
+	int madv = MADV_NORMAL;
+	switch (advice) {
+	case D_FILEADVICE_SEQUENTIAL:
+		madv = MADV_SEQUENTIAL;
+		break;
+	case D_FILEADVICE_RANDOM:
+		madv = MADV_RANDOM;
+		break;
+	case D_FILEADVICE_WILLNEED:
+		madv = MADV_WILLNEED;
+		break;
+	default:
+		break;
+	}
+	(void)madvise(this->mapData_ + begin, end - begin, madv);
+#endif
+}
+
+//マップした範囲の物理ページを解放
+void fw::File::releasePages(const size_t offset, const size_t size)
+{
+	//マップ済みの場合はファイルサイズがsize_tに収まる
+	const size_t fileSize = size_t(this->fileSize_);
+	if ((this->mapData_ == nullptr) || (offset >= fileSize)) {
+		return;
+	}
+
+	//ページ境界に合わせる(範囲内に完全に含まれるページのみ)
+	const size_t pageSize = getPageSize();
+	const size_t end = (size < (fileSize - offset)) ? (offset + size) : fileSize;
+	const size_t begin = ((offset + pageSize - 1) / pageSize) * pageSize;
+	const size_t endPage = (end == fileSize) ? end : ((end / pageSize) * pageSize);
+	if (begin >= endPage) {
+		return;
+	}
+
+#if defined(_WIN32)
+	//ロックしていないページのアンロックでワーキングセットから外れる
+	(void)VirtualUnlock(this->mapData_ + begin, endPage - begin);
+#else
+	(void)madvise(this->mapData_ + begin, endPage - begin, MADV_DONTNEED);
+#endif
+}
+
+//マップ解除
+void fw::File::unmap()
+{
+	if (this->mapData_ == nullptr) {
+		return;
+	}
+
+#if defined(_WIN32)
+	(void)UnmapViewOfFile(this->mapData_);
+	(void)CloseHandle(HANDLE(this->mapHandle_));
+	this->mapHandle_ = nullptr;
+#else
+	(void)munmap(this->mapData_, size_t(this->fileSize_));
+#endif
+	this->mapData_ = nullptr;
+}
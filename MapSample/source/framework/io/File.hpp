@@ -6,6 +6,20 @@
 
 namespace fw {
 
+	//マップ先のアクセス方法の通知
+	enum EN_FileAdvice : std::uint16_t {
+		D_FILEADVICE_NORMAL,		//既定
+		D_FILEADVICE_SEQUENTIAL,	//先頭から順に参照する(先読みを増やし、参照済みのページは早めに解放される)
+		D_FILEADVICE_RANDOM,		//不規則に参照する(先読みしない)
+		D_FILEADVICE_WILLNEED,		//まもなく参照する(非同期に読み込んでおく)
+	};
+
+	//マップ先の読み込み専用の参照(参照元のFileのクローズまで有効)
+	struct FileView {
+		const std::uint8_t*	data_;	//先頭(範囲外、マップ失敗時はnullptr)
+		size_t				size_;	//バイト数
+	};
+
 	//----------------------------------------------------------
 	//
 	// ファイルクラス
@@ -15,8 +29,15 @@ namespace fw {
 	class File {
 		//メンバ変数
 		std::string		filePath_;
-		size_t			fileSize_;
-		FILE*			fp_;
+		std::uint64_t	fileSize_;
+		std::uint64_t	writePos_;		//書き込み位置
+#if defined(_WIN32)
+		void*			handle_;		//ファイルハンドル(未オープンはnullptr)
+#else
+		int				fd_;			//ファイルディスクリプタ(未オープンは-1)
+#endif
+		std::uint8_t*	mapData_;		//マップ先(未マップはnullptr)
+		void*			mapHandle_;		//マップ用ハンドル(Windowsのみ)
 
 	public:
 		//コンストラクタ
@@ -25,14 +46,40 @@ namespace fw {
 		~File();
 		//作成
 		bool create(const std::string& filePath);
-		//ファイルオープン
+		//ファイルオープン(modeはfopenと同じ"rb","wb","ab","r+b"等、テキストモードはなし)
 		bool open(const std::string& mode);
 		//ファイルクローズ
 		void close();
-		//ファイル読み込み
-		bool read(std::uint8_t** const data, const std::int32_t offset, const size_t size);
+		//ファイル読み込み(offsetの位置からsizeバイトをdataへ読み込む)
+		//読み込み位置を持たないため、オープン中は複数スレッドから排他なしで同時に呼んでよい
+		bool read(std::uint8_t* const data, const std::uint64_t offset, const size_t size) const;
+		//ファイル書き込み(現在位置に書き込む)
+		bool write(const std::uint8_t* const data, const size_t size);
 		//ファイルサイズ取得
-		size_t getFileSize();
+		std::uint64_t getFileSize() const;
+#if !defined(_WIN32)
+		//ファイルディスクリプタ取得(未オープンは-1、io_uring等のOSの読み込みへ直接渡す場合のみ使用)
+		int getFd() const;
+#endif
+		//ファイル全体を読み込み専用でマップ(失敗時はnullptr、クローズ時に解除)
+		//マップ先は書き込み不可
+		std::uint8_t* map();
+		//マップ先のoffsetの位置からsizeバイトの参照を取得(未マップの場合はファイル全体をマップ)
+		//コピーせずにページキャッシュを直接参照する
+		FileView view(const size_t offset, const size_t size);
+		//マップした範囲のアクセス方法を通知(未マップの場合は何もしない)
+		void advise(const size_t offset, const size_t size, const EN_FileAdvice advice);
+		//マップした範囲の物理ページを解放(再アクセス時はファイルから読み直される)
+		void releasePages(const size_t offset, const size_t size);
+
+		//コピーコンストラクタ(禁止)
+		File(const File& org) = delete;
+		//代入演算子(禁止)
+		File& operator=(const File& org) = delete;
+
+	private:
+		//マップ解除
+		void unmap();
 	};
 }
 
@@ -0,0 +1,273 @@
+﻿#include "FileStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+//----------------------------------------------------------
+//
+// ファイル入力ストリームクラス
+//
+//----------------------------------------------------------
+
+//コンストラクタ
+fw::FileStream::FileStream() :
+	file_(), reader_(nullptr), buffer_(), readPos_(0), bufferSize_(0), startOffset_(0), nextOffset_(0), endOffset_(0),
+	prefetch_(), requestOffset_(0), pending_(), pendingPos_(0), isError_(false)
+{
+}
+
+//デストラクタ
+fw::FileStream::~FileStream()
+{
+	this->close();
+}
+
+//オープン
+bool fw::FileStream::open(const std::string& filePath, const std::uint64_t offset, const std::uint64_t size, const size_t chunkSize, AsyncFileReader* const reader)
+{
+	this->close();
+
+	//範囲を確定するためファイルサイズを取得(非同期の場合も先読みは同じファイルから行う)
+	this->file_ = std::make_shared<File>();
+	if (!this->file_->create(filePath) || !this->file_->open("rb")) {
+		this->close();
+		return false;
+	}
+	const std::uint64_t fileSize = this->file_->getFileSize();
+	if ((offset > fileSize) || (size > (fileSize - offset))) {
+		//範囲がファイルサイズを超える
+		this->close();
+		return false;
+	}
+
+	this->reader_ = reader;
+	this->buffer_.resize(std::max(chunkSize, size_t(1)));
+	this->startOffset_ = offset;
+	this->nextOffset_ = offset;
+	this->endOffset_ = (size == 0) ? fileSize : (offset + size);
+	this->requestOffset_ = offset;
+
+	if (this->reader_ != nullptr) {
+		//以降の読み込みは非同期ファイル読み込みで行う
+		this->postPrefetch();
+	}
+
+	return true;
+}
+
+//クローズ
+void fw::FileStream::close()
+{
+	//先読み中のチャンクは完了を待たずに破棄(読み込み先とファイルは読み込みタスクが保持する)
+	this->prefetch_ = std::future<FileReadResult>();
+	this->file_.reset();
+	this->reader_ = nullptr;
+	this->buffer_.clear();
+	this->readPos_ = 0;
+	this->bufferSize_ = 0;
+	this->startOffset_ = 0;
+	this->nextOffset_ = 0;
+	this->endOffset_ = 0;
+	this->requestOffset_ = 0;
+	this->pending_.clear();
+	this->pendingPos_ = 0;
+	this->isError_ = false;
+}
+
+//バッファ内の未読データの先頭を取得
+const std::uint8_t* fw::FileStream::getData() const
+{
+	return this->buffer_.data() + this->readPos_;
+}
+
+//バッファ内の未読データのバイト数を取得
+size_t fw::FileStream::getSize() const
+{
+	return this->bufferSize_ - this->readPos_;
+}
+
+//バッファ内の未読データを読み込み済みにする
+void fw::FileStream::consume(const size_t size)
+{
+	this->readPos_ += std::min(size, this->getSize());
+}
+
+//未読データをバッファの先頭へ移し、空いた分を読み込む
+bool fw::FileStream::refill()
+{
+	if (this->isError_ || this->buffer_.empty()) {
+		return false;
+	}
+
+	//未読データを先頭へ移動
+	const size_t unreadSize = this->getSize();
+	if ((unreadSize > 0) && (this->readPos_ > 0)) {
+		(void)std::memmove(this->buffer_.data(), this->buffer_.data() + this->readPos_, unreadSize);
+	}
+	this->readPos_ = 0;
+	this->bufferSize_ = unreadSize;
+
+	//バッファが一杯になるか範囲の終端まで読み込む
+	while ((this->bufferSize_ < this->buffer_.size()) && (this->nextOffset_ < this->endOffset_)) {
+		const std::uint64_t restSize = this->endOffset_ - this->nextOffset_;
+		size_t size = this->buffer_.size() - this->bufferSize_;
+		size = (std::uint64_t(size) < restSize) ? size : size_t(restSize);
+
+		if (this->reader_ == nullptr) {
+			//同期読み込み
+			if (!this->file_->read(this->buffer_.data() + this->bufferSize_, this->nextOffset_, size)) {
+				this->isError_ = true;
+				break;
+			}
+		}
+		else {
+			//先読み済みのデータから転送(なければ先読みの完了を待つ)
+			if ((this->pendingPos_ >= this->pending_.size()) && !this->receivePrefetch()) {
+				this->isError_ = true;
+				break;
+			}
+			size = std::min(size, this->pending_.size() - this->pendingPos_);
+			(void)std::memcpy(this->buffer_.data() + this->bufferSize_, this->pending_.data() + this->pendingPos_, size);
+			this->pendingPos_ += size;
+		}
+		this->bufferSize_ += size;
+		this->nextOffset_ += size;
+	}
+
+	return (this->bufferSize_ > unreadSize);
+}
+
+//sizeバイトをdataへ読み込む
+bool fw::FileStream::read(std::uint8_t* const data, const size_t size)
+{
+	size_t readSize = 0;
+	for (;;) {
+		const size_t copySize = std::min(size - readSize, this->getSize());
+		if (copySize > 0) {
+			(void)std::memcpy(data + readSize, this->getData(), copySize);
+			this->consume(copySize);
+			readSize += copySize;
+		}
+		if (readSize >= size) {
+			return true;
+		}
+		if (!this->refill()) {
+			//範囲の終端、読み込み失敗
+			return false;
+		}
+	}
+}
+
+//sizeバイト読み飛ばす
+bool fw::FileStream::skip(const std::uint64_t size)
+{
+	//バッファ内を読み飛ばす
+	const size_t bufferSkip = (size < std::uint64_t(this->getSize())) ? size_t(size) : this->getSize();
+	this->consume(bufferSkip);
+	std::uint64_t restSize = size - bufferSkip;
+	if (restSize == 0) {
+		return true;
+	}
+	if (restSize > (this->endOffset_ - this->nextOffset_)) {
+		//範囲の終端まで読み飛ばす
+		this->nextOffset_ = this->endOffset_;
+		this->pending_.clear();
+		this->pendingPos_ = 0;
+		this->prefetch_ = std::future<FileReadResult>();
+		return false;
+	}
+	this->nextOffset_ += restSize;
+
+	if (this->reader_ != nullptr) {
+		//先読み済みのデータを読み飛ばす
+		const size_t pendingSkip = std::min(size_t(std::min(restSize, std::uint64_t(SIZE_MAX))), this->pending_.size() - this->pendingPos_);
+		this->pendingPos_ += pendingSkip;
+		restSize -= pendingSkip;
+		if (restSize > 0) {
+			//先読み中のチャンクより先は読み込み位置から先読みし直す
+			this->pending_.clear();
+			this->pendingPos_ = 0;
+			this->prefetch_ = std::future<FileReadResult>();
+			this->requestOffset_ = this->nextOffset_;
+			this->postPrefetch();
+		}
+	}
+
+	return true;
+}
+
+//範囲の先頭から読み込み直す
+bool fw::FileStream::rewind()
+{
+	if (this->buffer_.empty()) {
+		//未オープン
+		return false;
+	}
+
+	if (!this->isError_ && ((this->nextOffset_ - this->bufferSize_) == this->startOffset_)) {
+		//バッファの先頭が範囲の先頭のため読み込み位置を戻すのみ
+		this->readPos_ = 0;
+		return true;
+	}
+
+	//先読み中のチャンクを破棄して範囲の先頭から読み込み直す
+	this->prefetch_ = std::future<FileReadResult>();
+	this->readPos_ = 0;
+	this->bufferSize_ = 0;
+	this->nextOffset_ = this->startOffset_;
+	this->requestOffset_ = this->startOffset_;
+	this->pending_.clear();
+	this->pendingPos_ = 0;
+	this->isError_ = false;
+	if (this->reader_ != nullptr) {
+		this->postPrefetch();
+	}
+
+	return true;
+}
+
+//範囲内の未読バイト数を取得
+std::uint64_t fw::FileStream::getRestSize() const
+{
+	return std::uint64_t(this->getSize()) + (this->endOffset_ - this->nextOffset_);
+}
+
+//読み込み失敗有無
+bool fw::FileStream::isError() const
+{
+	return this->isError_;
+}
+
+//次のチャンクの先読みを登録
+void fw::FileStream::postPrefetch()
+{
+	if (this->requestOffset_ >= this->endOffset_) {
+		//範囲の終端まで登録済み
+		return;
+	}
+
+	const std::uint64_t restSize = this->endOffset_ - this->requestOffset_;
+	const size_t size = (std::uint64_t(this->buffer_.size()) < restSize) ? this->buffer_.size() : size_t(restSize);
+	this->prefetch_ = this->reader_->read(std::shared_ptr<const File>(this->file_), this->requestOffset_, size);
+	this->requestOffset_ += size;
+}
+
+//先読みしたチャンクを受け取る
+bool fw::FileStream::receivePrefetch()
+{
+	if (!this->prefetch_.valid()) {
+		return false;
+	}
+
+	FileReadResult result = this->prefetch_.get();
+	if (!result.isOk_ || result.data_.empty()) {
+		return false;
+	}
+	this->pending_.swap(result.data_);
+	this->pendingPos_ = 0;
+
+	//受け取ったチャンクを参照している間に次を読み込む
+	this->postPrefetch();
+
+	return true;
+}
@@ -0,0 +1,90 @@
+﻿#ifndef INCLUDED_FILESTREAM_HPP
+#define INCLUDED_FILESTREAM_HPP
+
+#include "Std.hpp"
+#include "io/AsyncFileReader.hpp"
+#include "io/File.hpp"
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fw {
+
+	//----------------------------------------------------------
+	//
+	// ファイル入力ストリームクラス
+	//
+	// ファイルの指定範囲を先頭から固定サイズのバッファへ順に読み込む。
+	// デコーダへファイル全体を読み込まずに渡すために使い、常駐するのはバッファ分のみ。
+	// 非同期ファイル読み込みを指定した場合は、次のチャンクを先読みしながら現在のバッファを参照できる。
+	// ファイルはオープン時に1回だけ開き、先読みでも同じファイルを使う。
+	// 1つのストリームを複数スレッドから同時に使わないこと。
+	//
+	//----------------------------------------------------------
+
+	class FileStream {
+	public:
+		//既定のバッファサイズ
+		static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	private:
+		//メンバ変数
+		std::shared_ptr<File>		file_;			//ファイル(非同期読み込みでは先読み中のタスクと共有)
+		AsyncFileReader*			reader_;		//非同期ファイル読み込み(同期読み込みはnullptr)
+		std::vector<std::uint8_t>	buffer_;		//バッファ
+		size_t						readPos_;		//バッファ内の読み込み位置
+		size_t						bufferSize_;	//バッファ内の有効バイト数
+		std::uint64_t				startOffset_;	//読み込み範囲の先頭
+		std::uint64_t				nextOffset_;	//次にバッファへ読み込むファイル上の位置
+		std::uint64_t				endOffset_;		//読み込み範囲の終端
+		std::future<FileReadResult>	prefetch_;		//先読み中のチャンク(非同期のみ)
+		std::uint64_t				requestOffset_;	//次に先読みするファイル上の位置(非同期のみ)
+		std::vector<std::uint8_t>	pending_;		//先読み済みでバッファへ未転送のデータ(非同期のみ)
+		size_t						pendingPos_;	//先読み済みデータの転送位置(非同期のみ)
+		bool						isError_;		//読み込み失敗
+
+	public:
+		//コンストラクタ
+		FileStream();
+		//デストラクタ
+		~FileStream();
+		//オープン(offsetの位置からsizeバイト、sizeが0の場合はファイル末尾まで)
+		//readerを指定した場合は非同期ファイル読み込みで先読みする
+		bool open(const std::string& filePath, const std::uint64_t offset = 0, const std::uint64_t size = 0,
+			const size_t chunkSize = DEFAULT_CHUNK_SIZE, AsyncFileReader* const reader = nullptr);
+		//クローズ
+		void close();
+		//バッファ内の未読データの先頭を取得
+		const std::uint8_t* getData() const;
+		//バッファ内の未読データのバイト数を取得
+		size_t getSize() const;
+		//バッファ内の未読データをsizeバイト読み込み済みにする
+		void consume(const size_t size);
+		//未読データをバッファの先頭へ移し、空いた分を読み込む(新たに読み込めなかった場合はfalse)
+		bool refill();
+		//sizeバイトをdataへ読み込む(足りない場合はfalse)
+		bool read(std::uint8_t* const data, const size_t size);
+		//sizeバイト読み飛ばす(範囲を超える場合はfalse)
+		bool skip(const std::uint64_t size);
+		//範囲の先頭から読み込み直す(先頭がバッファ内に残っていればファイルは読み直さない)
+		bool rewind();
+		//範囲内の未読バイト数を取得(バッファ内を含む)
+		std::uint64_t getRestSize() const;
+		//読み込み失敗有無
+		bool isError() const;
+
+		//コピーコンストラクタ(禁止)
+		FileStream(const FileStream& org) = delete;
+		//代入演算子(禁止)
+		FileStream& operator=(const FileStream& org) = delete;
+
+	private:
+		//次のチャンクの先読みを登録
+		void postPrefetch();
+		//先読みしたチャンクを受け取る(失敗時はfalse)
+		bool receivePrefetch();
+	};
+}
+
+#endif //INCLUDED_FILESTREAM_HPP
@@ -1,6 +1,7 @@
 ﻿#include "UiMng.hpp"
 #include "UiScreen.hpp"
 #include "image/LocalImage.hpp"
+#include "image/DecodeCache.hpp"
 
 
 
@@ -28,13 +29,20 @@ namespace {
 
 //コンストラクタ
 ui::UiMng::UiMng(fw::DrawIF* drawIF) :
-	isStart_(std::EN_OffOn::OFF), mainThread_(), drawThread_(), drawIF_(drawIF), localImage_(nullptr), screen_(nullptr)
+	isStart_(std::EN_OffOn::OFF), mainThread_(), drawThread_(), drawIF_(drawIF), localImage_(nullptr), decodeCache_(nullptr), screen_(nullptr)
 {
 	printf("[%s] DrawIF:0x%p\n", __FUNCTION__, drawIF);
 
+	//デコードキャッシュ作成(2回目以降の起動ではデコード済み画像をマップして参照)
+	this->decodeCache_ = new fw::DecodeCache(std::D_CACHE_PATH);
+	fw::ImageDecorder::setDecodeCache(this->decodeCache_);
+
 	//ソフト持ち画像作成
+	//アーカイブがあれば1回のマップで全画像を参照、なければ使用する画像のみ初回取得時にマップ
 	this->localImage_ = new fw::LocalImage();
-	this->localImage_->create();
+	if (!this->localImage_->createFromArchive(std::string(std::D_DATA_PATH) + "/" + fw::D_LOCALIMAGE_ARCHIVE_FILE)) {
+		this->localImage_->create(fw::EN_LocalImageLoad::D_LOCALIMAGELOAD_LAZY);
+	}
 
 	//画面作成
 	this->screen_ = new UiScreen(this->drawIF_, this->localImage_, std::D_MAP_POSITION);
@@ -50,6 +58,10 @@ ui::UiMng::~UiMng()
 	if (this->localImage_ != nullptr) {
 		delete this->localImage_;
 	}
+	if (this->decodeCache_ != nullptr) {
+		fw::ImageDecorder::setDecodeCache(nullptr);
+		delete this->decodeCache_;
+	}
 }
 
 //開始
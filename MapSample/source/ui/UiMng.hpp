@@ -9,6 +9,7 @@ namespace fw {
 	//前方宣言
 	class DrawIF;
 	class LocalImage;
+	class DecodeCache;
 }
 namespace ui {
 	//前方宣言
@@ -31,6 +32,7 @@ namespace ui {
 
 		fw::DrawIF*		drawIF_;
 		fw::LocalImage*	localImage_;
+		fw::DecodeCache*	decodeCache_;
 		UiScreen*		screen_;
 
 	public:
@@ -65,26 +65,31 @@ void ui::UiScreen::makeViewData()
 			//std::int32_t xOffset = 227;
 			//for (std::uint16_t id = fw::D_IMAGEID_JPEG_01; id <= fw::D_IMAGEID_JPEG_02; id++) {
 
-			//画像データを取得
-			fw::LocalImageData imageData;
-			localImage->getImage(id, &imageData);
-
-			fw::Image image;
-			image.id_ = imageData.id_;
-			image.format_ = imageData.format_;
-			image.type_ = fw::EN_ImageType::D_IMAGETYPE_LOCAL;
-			image.isFlip_ = 0;
-			image.body_.data_ = imageData.body_;
-			image.body_.dataSize_ = imageData.bodySize_;
-			image.body_.width_ = 0;
-			image.body_.height_ = 0;
-			image.body_.isPixelFlip_ = 0;
-			image.body_.isChgPallete_ = 0;
-			image.body_.palleteNum_ = 0;
-			image.body_.pallete_ = nullptr;
-			image.isBlend_ = 0;
-
-			this->viewData_.setDrawParts(new ViewImage(texBasePos, image));
+			//画像データを取得(未登録の画像IDは表示しない)
+			const fw::LocalImageData* imageData = localImage->getImage(id);
+			if (imageData != nullptr) {
+				fw::Image image;
+				image.id_ = imageData->id_;
+				image.format_ = imageData->format_;
+				image.type_ = fw::EN_ImageType::D_IMAGETYPE_LOCAL;
+				image.isFlip_ = 0;
+				image.body_.data_ = imageData->body_;
+				image.body_.dataSize_ = imageData->bodySize_;
+				image.body_.width_ = 0;
+				image.body_.height_ = 0;
+				image.body_.transColor_ = 0;
+				image.body_.isPixelFlip_ = 0;
+				image.body_.isChgPallete_ = 0;
+				image.body_.palleteNum_ = 0;
+				image.body_.pallete_ = nullptr;
+				image.body_.stream_ = nullptr;
+				image.isBlend_ = 0;
+				image.blend_ = image.body_;
+				image.blend_.data_ = nullptr;
+				image.blend_.dataSize_ = 0;
+
+				this->viewData_.setDrawParts(new ViewImage(texBasePos, image));
+			}
 
 			texBasePos.x += xOffset;
 		}
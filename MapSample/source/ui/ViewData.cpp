@@ -79,6 +79,18 @@ void ui::ViewImage::draw(fw::DrawIF* const drawIF)
 	drawIF->drawImage(coord_, image_);
 }
 
+//描画で使用するイメージを取得
+const fw::Image* ui::ViewImage::getImage() const
+{
+	return &this->image_;
+}
+
+//イメージの描画座標を取得
+const std::CoordI* ui::ViewImage::getImageCoord() const
+{
+	return &this->coord_;
+}
+
 
 //----------------------------------------------------------
 //
@@ -134,7 +146,35 @@ void ui::ViewData::draw(fw::DrawIF* const drawIF)
 {
 	drawIF->clear(this->backColor_);
 
+	//イメージはまとめて並列デコードしておく
+	std::vector<fw::Image> images;
 	for (auto itr = this->partsList_.begin(); itr != this->partsList_.end(); itr++) {
+		const fw::Image* image = (*itr)->getImage();
+		if (image != nullptr) {
+			images.push_back(*image);
+		}
+	}
+	drawIF->prepareImages(images);
+
+	//連続するイメージはまとめて描画(アトラスの同じページの画像は1回の描画になる)
+	fw::DrawCoords imageCoords;
+	images.clear();
+	for (auto itr = this->partsList_.begin(); itr != this->partsList_.end(); itr++) {
+		const fw::Image* image = (*itr)->getImage();
+		const std::CoordI* imageCoord = (*itr)->getImageCoord();
+		if ((image != nullptr) && (imageCoord != nullptr)) {
+			imageCoords.push_back(*imageCoord);
+			images.push_back(*image);
+			continue;
+		}
+		if (!images.empty()) {
+			drawIF->drawImages(imageCoords, images);
+			imageCoords.clear();
+			images.clear();
+		}
 		(*itr)->draw(drawIF);
 	}
+	if (!images.empty()) {
+		drawIF->drawImages(imageCoords, images);
+	}
 }
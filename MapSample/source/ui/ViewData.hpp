@@ -36,6 +36,10 @@ namespace ui {
 	public:
 		//描画
 		virtual void draw(fw::DrawIF* const drawIF) = 0;
+		//描画で使用するイメージを取得(イメージ以外はnullptr)
+		virtual const fw::Image* getImage() const { return nullptr; }
+		//イメージの描画座標を取得(イメージ以外はnullptr)
+		virtual const std::CoordI* getImageCoord() const { return nullptr; }
 	};
 
 
@@ -110,6 +114,10 @@ namespace ui {
 		ViewImage(const std::CoordI& coord, const fw::Image& image);
 		//描画
 		virtual void draw(fw::DrawIF* const drawIF);
+		//描画で使用するイメージを取得
+		virtual const fw::Image* getImage() const;
+		//イメージの描画座標を取得
+		virtual const std::CoordI* getImageCoord() const;
 	};
 
 
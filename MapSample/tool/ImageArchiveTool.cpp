@@ -0,0 +1,130 @@
+﻿//----------------------------------------------------------
+//
+// 画像アーカイブ作成ツール
+//
+// ImageArchiveTool <アーカイブ>
+//   ソフト持ち画像の画像ファイルテーブルの全画像をdataフォルダから読み込んで作成
+// ImageArchiveTool <アーカイブ> <マニフェスト>
+//   マニフェストに列挙した画像から作成。1行1画像で
+//   「画像ID 画像フォーマット(bmp/png/jpeg) 本体画像ファイル [ブレンド画像ファイル]」
+//   画像IDは10進または0x付き16進、ファイルはマニフェストからの相対パス、#以降はコメント
+//
+// ビルド例(Visual Studio開発者コマンドプロンプト)
+//   cl /std:c++14 /EHsc /I..\source\framework ImageArchiveTool.cpp ..\source\framework\io\File.cpp
+//      ..\source\framework\image\ImageArchive.cpp ..\source\framework\image\LocalImage.cpp
+//
+//----------------------------------------------------------
+
+#include "image/ImageArchive.hpp"
+#include "image/LocalImage.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+	//画像フォーマット名から画像フォーマットを取得
+	static bool toFormat(const std::string& name, fw::EN_ImageFormat* const format)
+	{
+		if (name == "bmp") {
+			*format = fw::EN_ImageFormat::D_IMAGEFORMAT_BMP;
+		}
+		else if (name == "png") {
+			*format = fw::EN_ImageFormat::D_IMAGEFORMAT_PNG;
+		}
+		else if ((name == "jpeg") || (name == "jpg")) {
+			*format = fw::EN_ImageFormat::D_IMAGEFORMAT_JPEG;
+		}
+		else {
+			return false;
+		}
+		return true;
+	}
+
+	//マニフェストを読み込み
+	static bool readManifest(const std::string& manifestPath, std::vector<fw::ImageArchiveSource>* const sources)
+	{
+		std::ifstream manifest(manifestPath);
+		if (!manifest) {
+			std::fprintf(stderr, "cannot open manifest: %s\n", manifestPath.c_str());
+			return false;
+		}
+
+		//ファイルはマニフェストからの相対パス
+		const size_t slash = manifestPath.find_last_of("/\\");
+		const std::string baseDir = (slash == std::string::npos) ? "" : manifestPath.substr(0, slash + 1);
+
+		std::string line;
+		std::int32_t lineNo = 0;
+		while (std::getline(manifest, line)) {
+			lineNo++;
+			line = line.substr(0, line.find('#'));
+
+			std::istringstream fields(line);
+			std::string id;
+			std::string format;
+			std::string body;
+			std::string blend;
+			if (!(fields >> id)) {
+				//空行
+				continue;
+			}
+			fields >> format >> body >> blend;
+
+			fw::ImageArchiveSource source;
+			char* end = nullptr;
+			const unsigned long value = std::strtoul(id.c_str(), &end, 0);
+			if ((*end != '\0') || (value > 0xFFFF) || !toFormat(format, &source.format_) || body.empty()) {
+				std::fprintf(stderr, "%s:%d: invalid line\n", manifestPath.c_str(), lineNo);
+				return false;
+			}
+			source.id_ = std::uint16_t(value);
+			source.bodyPath_ = baseDir + body;
+			source.blendPath_ = (blend.empty()) ? "" : (baseDir + blend);
+			sources->push_back(source);
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if ((argc != 2) && (argc != 3)) {
+		std::fprintf(stderr, "usage: %s <archive> [manifest]\n", argv[0]);
+		return 1;
+	}
+	const std::string archivePath = argv[1];
+
+	//アーカイブを作成
+	bool isOk = false;
+	if (argc == 2) {
+		isOk = fw::LocalImage::writeArchive(archivePath);
+	}
+	else {
+		std::vector<fw::ImageArchiveSource> sources;
+		isOk = readManifest(argv[2], &sources) && fw::ImageArchive::write(archivePath, sources);
+	}
+	if (!isOk) {
+		std::fprintf(stderr, "cannot write archive: %s\n", archivePath.c_str());
+		return 1;
+	}
+
+	//作成したアーカイブを開いて内容を表示
+	fw::ImageArchive archive;
+	if (!archive.open(archivePath)) {
+		std::fprintf(stderr, "cannot open archive: %s\n", archivePath.c_str());
+		return 1;
+	}
+	for (std::int32_t i = 0; i < archive.getEntryNum(); i++) {
+		fw::ImageArchiveEntry entry;
+		(void)archive.getEntry(i, &entry);
+		std::printf("0x%04X format:%d body:%d blend:%d\n", entry.id_, std::int32_t(entry.format_), entry.bodySize_, entry.blendSize_);
+	}
+	std::printf("%d images\n", archive.getEntryNum());
+
+	return 0;
+}